@@ -4,37 +4,227 @@
   FSM (matches your block diagram):
     SAFE_STATE  -> (Power long-press) -> SAFE_READY
     SAFE_READY  -> (limit pressed)     -> ARMED_FLY
-    ARMED_FLY   -> (limit released)    -> ARMED_SENSING
-    ARMED_SENSING -> (altitude >= 3m)  -> ARMED_IR_FLASH
+    ARMED_FLY   -> (released)          -> ARMED_SENSING
+    ARMED_SENSING -> (at altitude)     -> ARMED_IR_FLASH
     ARMED_IR_FLASH -> (after TX)       -> EXPENDED
     EXPENDED (5 s) -> SAFE_STATE
     Power long-press from anywhere forces SAFE; from SAFE it arms to SAFE_READY.
+    The transition table itself lives in MILES_FSM.h and is shared with
+    MILES_GUI.py; fsm_guard()/fsm_action() below bind it to the hardware.
+
+  Cores:
+    core 0: FSM, buttons, sensors, transmitter (setup/loop)
+    core 1: OLED, settings journal, Serial telemetry (setup1/loop1)
+    Core 0 posts state snapshots and requests through a lock-free SPSC
+    queue (MILES_QUEUE.h), so the arm-to-fire path never waits on I2C,
+    flash or USB. Everything that reaches the FSM (input, alarm, TX and RX
+    IRQs, core 1's injected inputs) arrives as an event on one MPSC ring
+    (MILES_SCHED.h); no flags are shared with interrupt handlers.
+    Both loops are event-driven and sleep in WFE: core 0 wakes on GPIO edge
+    and alarm events (MILES_SCHED.h), core 1 on queue posts and its next
+    GUI deadline (toast / confirm expiry, countdown tick).
+
+  Boot:
+    setup() only does what arming needs: pins, TX, registry and settings
+    (flash reads), the sampler and the ADC. It does not wait for USB.
+    setup1() brings up Serial, the OLED and the shot log at the same time,
+    and the first frame goes out by DMA like any other. Core 1 sends the
+    armable, first-frame and USB times (us since reset) as a TM_BOOT
+    record once a host is attached.
+
+  Memory:
+    Nothing is allocated from the heap after boot: queues, rings, the
+    glyph cache and the TX buffers are static, and the SSD1306 buffer is
+    allocated once by display.begin() in setup1(). That can finish after
+    setup(), so boot ends when the GUI goes live, with both setups done.
+    From then on:
+    - malloc() and friends, String and new are poisoned ahead of the
+      project headers. Any allocation in this file or a MILES_*.h header
+      is a compile error.
+    - operator new panics (heap_sealed), which covers C++ library code.
+    - If the Adafruit libraries or the core malloc() directly, 't' shows it
+      as heap growth since the GUI went live. The poison cannot see their
+      compiled sources, and the core already wraps malloc() itself.
 
   GUI:
+    - Retained widgets; only changed SSD1306 pages are sent, by DMA (MILES_DISPLAY.h)
+    - Labels and the values they show are rasterized once, on the first
+      snapshot; redraws copy page bytes from that cache
     - Shows state, protocol, BLU/OPFOR, limit, ALT>=3m
     - Shot counter (#)
     - “IR FLASHED” toast on transmit
     - “CONFIRMED” indicator if self-sense sees the burst
 
+  Drop detection:
+    "Released" and "at altitude" are fused signals (MILES_FUSION.h). A
+    1 kHz timer reads the accelerometer by SPI DMA (MILES_IMU.h) and
+    scores the limit switch and free fall for the first, the range sensor
+    and the free-fall time (1/2 g t^2) for the second. Agreeing sources
+    assert a signal within a few ms; one source alone is slower, and a
+    limit bounce without free fall is ignored. Each assertion is sent as a
+    TM_FUSE record; "LIM->REL" and "ALT->FUSE" in 't' measure the added
+    latency. Without an IMU the limit and the range sensor decide alone.
+
+  Standby:
+    After STANDBY_IDLE_MS without any event in SAFE_STATE, both cores
+    deep-sleep with only the core clocks running (MILES_POWER.h): input
+    sampling, altitude ADC/DMA and the LEDs stop and the OLED is switched
+    off. A PWR press wakes the unit; the edge-to-responsive time is traced
+    and sent as a TM_WAKE record. The wake press never arms: PWR has to be
+    released and held again.
+
   Timing:
-    BIN_US / PULSE_US are demo values. Replace with your MILES timing.
-    SIDE_BIT_INDEX = 5 (flip if your format uses a different team bit position).
+    Bin and pulse widths, the team bit, the confirm window, the EXPENDED
+    hold and the debounce/hold times come from a timing profile
+    (MILES_PROFILE.h), chosen at build time with MILES_PROFILE. The default
+    is the demo profile; add one with your MILES timing. The profile id is
+    saved with the settings and a mismatch is logged at boot.
 
   Transmit:
-    laser_transmit_frame(...) is a simple stub (digitalWrite + delay).
-    Swap in your precise PWM+DMA streaming routine here for real range use.
+    The selected (protocol, side) frame is pre-encoded into a PIO pulse/space
+    buffer whenever the selection changes (frame cache). laser_transmit_frame()
+    only starts the DMA burst (see MILES_TX.h) and returns immediately. The FSM
+    stays in ARMED_IR_FLASH until the PIO end-of-frame IRQ and the confirm
+    window have passed, so buttons and the OLED keep running during a burst.
+    Self-sense edges are timestamped by interrupt (MILES_CAPTURE.h) and the
+    echo is checked against the sent frame: bit errors + latency from TX start.
+    A burst with a missing or corrupted echo is resent from the same buffer,
+    within retry_config's count and time budget, before EXPENDED.
+    Codes come from the protocol registry (MILES_REGISTRY.h): a flash image
+    loaded over Serial, else the compiled-in table. Each entry is expanded to
+    its BLUFOR/OPFOR frames once at boot.
+    With burst_config.count > 1 the cache holds a whole salvo (frames and
+    gaps in one DMA transfer) and each frame's echo is checked on its own.
+    The emitter is driven from PIN_IR_LED: a PWM slice makes the carrier
+    and a PIO gate passes it only while PIN_OUT is high (MILES_CARRIER.h).
+    A second PIO block times every edge on PIN_OUT at system-clock
+    resolution, with no extra wiring (MILES_SCOPE.h). Send 's' for the last
+    shot's per-bin error, drift and jitter against BIN_US / PULSE_US.
+
+  Receive:
+    Incoming 11-bit frames on PIN_IR_SENSE are timed by a PIO state machine,
+    moved into a ring by DMA and decoded on core 0 against the registry
+    codes, both sides (MILES_RX.h). Frames that fall inside our own burst
+    and confirm window are echoes; anything else that matches a code is a
+    hit. Each decoded frame goes out as a TM_RX record.
+
+  Tracing:
+    State entries, input edges, TX start/end and GUI render/flush are stamped
+    into per-core rings (MILES_TRACE.h). Send 't' over Serial for latency
+    histograms of the spans in TRACE_SPANS, the heap in use and the number
+    of core 0 events lost to a full scheduler ring.
+
+  Telemetry:
+    State changes, TX frames, echo results and log messages go out as binary
+    records (MILES_TELEM.h, decoded by MILES_TELEM.py). Core 1 owns Serial
+    and only writes while no burst or confirm window is in progress.
+
+  GUI bridge:
+    MILES_GUI.py --port attaches to a live unit. Once it sends HC_MIRROR,
+    core 1 sends a TM_UI record of the GUI state whenever it changes, at
+    most every MIRROR_MIN_MS. HC_INJECT frames (several events each) drive
+    buttons, the limit switch and the altitude in place of the hardware;
+    injected levels go through the normal debounce and filter on core 0.
+
+  Shot log:
+    Every burst leaves a 16-byte record (protocol, side, time, confirm
+    latency, bit errors, echo result) in a flash ring behind the registry
+    sector (MILES_SHOTLOG.h). Core 1 batches them in RAM and programs them
+    once the unit is EXPENDED or SAFE. Send 'D' over Serial to download the
+    whole ring as TM_SHOT records, oldest first.
+
+  Benchmarks:
+    With MILES_BENCH set to 1, the unit times its hot paths once at boot
+    (frame build/encode, TX kick and time on air, GUI render and flush,
+    settings journal append; see MILES_BENCH.h). The results are printed as
+    JSON lines when the telemetry ring is empty. Sending 'b' prints
+    them again. MILES_BENCH.py compares two runs.
 */
 
+// Core, library and SDK headers first, so the poison below covers every
+// project header but not them.
 #include <Arduino.h>
 #include <EEPROM.h>
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string.h>
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/spi.h"
+#include "hardware/structs/clocks.h"
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+#ifndef MILES_HEAP_TRAP
+#define MILES_HEAP_TRAP 1   // 0: keep the toolchain's operator new (the host bench allocates as it likes)
+#endif
+
+// Set once the GUI is live (ui_drain()); from then on operator new panics.
+volatile bool heap_sealed = false;
+
+#if MILES_HEAP_TRAP
+void *operator new(size_t n) {
+  if (heap_sealed) panic("operator new after boot");
+  void *p = malloc(n);
+  if (!p) panic("out of memory");
+  return p;
+}
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+#endif
+
+// Zero-heap guarantee: any allocation from here on is a compile error.
+#pragma GCC poison malloc calloc realloc free strdup String new
+
 #include "MILES_CODES_H.h"
+#include "MILES_PROFILE.h"
+#include "MILES_FSM.h"
+#include "MILES_TX.h"
+#include "MILES_CARRIER.h"
+#include "MILES_CAPTURE.h"
+#include "MILES_SCOPE.h"
+#include "MILES_RX.h"
+#include "MILES_DISPLAY.h"
+#include "MILES_QUEUE.h"
+#include "MILES_SCHED.h"
+#include "MILES_INPUT.h"
+#include "MILES_ALT.h"
+#include "MILES_IMU.h"
+#include "MILES_FUSION.h"
+#include "MILES_POWER.h"
+#include "MILES_JOURNAL.h"
+#include "MILES_REGISTRY.h"
+#include "MILES_SHOTLOG.h"
+#include "MILES_TRACE.h"
+#include "MILES_TELEM.h"
+#include "MILES_BENCH.h"
+
+#ifndef MILES_BENCH
+#define MILES_BENCH 0   // 1: benchmark build, runs the suite below once at boot
+#endif
 
 // -------------------- Pins --------------------
-// IR out (to emitter driver transistor)
+// IR out: PIN_OUT carries the envelope (scope, self-test, baseband
+// drivers), PIN_IR_LED the carrier-modulated drive for the emitter.
 const uint8_t PIN_OUT       = 8;   // GP8
+const uint8_t PIN_IR_LED    = 9;   // GP9 (to emitter driver transistor)
+const uint8_t PIN_CARRIER   = 12;  // GP12, PWM 6A: carrier source, leave unconnected
 
 // Buttons (to GND, using INPUT_PULLUP)
 const uint8_t PIN_BTN_PWR   = 10;  // Power/Arm long-press
@@ -44,9 +234,15 @@ const uint8_t PIN_BTN_FIRE  = 4;   // Manual fire (only from ARMED_SENSING)
 
 // Inputs
 const uint8_t PIN_LIMIT     = 6;   // Limit switch (HIGH = pressed) -> invert if needed
-const uint8_t PIN_ALT_OK    = 7;   // Digital: HIGH means altitude >= 3m (replace with real sensor logic)
+const uint8_t PIN_ALT_ADC   = 26;  // GP26/ADC0: analog range sensor output (see alt_config)
 const uint8_t PIN_IR_SENSE  = 18;  // IR self-sense digital input (receiver module pointed at emitter)
 
+// Accelerometer (LIS3DH, SPI0 mode 3)
+const uint8_t PIN_IMU_MOSI  = 19;  // GP19 SPI0 TX  -> SDA/SDI
+const uint8_t PIN_IMU_MISO  = 20;  // GP20 SPI0 RX  <- SDO
+const uint8_t PIN_IMU_CS    = 21;  // GP21 SPI0 CSn -> CS
+const uint8_t PIN_IMU_SCK   = 22;  // GP22 SPI0 SCK -> SCL/SPC
+
 // State LEDs
 const uint8_t LED_SAFE      = 14;  // Green
 const uint8_t LED_ARMED     = 15;  // Orange
@@ -59,287 +255,1462 @@ Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
 const uint8_t I2C_SDA = 4;  // GP4
 const uint8_t I2C_SCL = 5;  // GP5
 
-// -------------------- MILES timing (demo) --------------------
-const uint32_t BIN_US   = 500;  // bin duration (adjust!)
-const uint32_t PULSE_US = 250;  // '1' pulse width inside a bin (adjust!)
+// -------------------- MILES timing (MILES_PROFILE.h) --------------------
+constexpr uint32_t BIN_US   = TIMING.bin_us;    // bin duration
+constexpr uint32_t PULSE_US = TIMING.pulse_us;  // '1' pulse width inside a bin
+
+// IR carrier inside each pulse (MILES_CARRIER.h); match your receivers.
+// { 0, 0 } sends the bare envelope on PIN_IR_LED.
+const CarrierConfig carrier_config = { 56000, 33 };
 
 // Team bit index (which bit of 11-bit frame encodes BLU/OPFOR)
-const int SIDE_BIT_INDEX = 5;   // adjust to your protocol/receiver mapping
+constexpr int SIDE_BIT_INDEX = TIMING.side_bit;
 
-// -------------------- EEPROM --------------------
+// -------------------- Settings --------------------
+// Saved in the flash journal (MILES_JOURNAL.h). The EEPROM layout below is
+// only read once, to migrate settings from older firmware.
 const int EEPROM_ADDR_MAGIC    = 0;
 const int EEPROM_ADDR_PROTOCOL = 4;
 const int EEPROM_ADDR_SIDE     = 8;
 const uint32_t EEPROM_MAGIC    = 0x4D494C45; // 'MILE'
 
-// -------------------- Protocol registry --------------------
 typedef struct {
-  uint8_t id;
-  const char *name;
-  const MILES_Code *code;
-} ProtocolEntry;
-
-// Codes from header
-extern const MILES_Code PLAYER_UNIVERSAL_KILL;
-extern const MILES_Code PLAYER_ID_001;
-extern const MILES_Code PLAYER_ID_002;
-extern const MILES_Code EVENT_PAUSE;
-extern const MILES_Code EVENT_END_EXERCISE;
-
-ProtocolEntry protocols[] = {
-  { 0, "Universal Kill (Basic)", &PLAYER_UNIVERSAL_KILL },
-  { 1, "Player ID 001",          &PLAYER_ID_001 },
-  { 2, "Player ID 002",          &PLAYER_ID_002 },
-  { 3, "Pause/Reset",            &EVENT_PAUSE },
-  { 4, "End Exercise",           &EVENT_END_EXERCISE }
+  uint8_t protocol_id;
+  uint8_t side;          // 0=BLUFOR, 1=OPFOR
+  uint8_t profile_id;    // TIMING.id of the build that saved it, 0xFF = older firmware
+  uint8_t reserved[5];   // 0xFF
+} SettingsRecord;
+static_assert(sizeof(SettingsRecord) == JOURNAL_PAYLOAD, "SettingsRecord must fill one journal payload");
+
+// Saves are coalesced on core 1 and only written once the unit is back in
+// SAFE_STATE and no setting has changed for SETTINGS_IDLE_MS.
+const unsigned long SETTINGS_IDLE_MS = 2000;
+
+// -------------------- Protocol registry --------------------
+// Codes from header (packed at compile time). Used until a registry image
+// is loaded over Serial ('L', see MILES_LOAD.py). Must stay sorted by id.
+#define BUILTIN(id, code, name) { code.pattern, id, code.bits, 0, 0, name }
+const RegistryEntry builtin_protocols[] = {
+  BUILTIN(0, PLAYER_UNIVERSAL_KILL, "Universal Kill (Basic)"),
+  BUILTIN(1, PLAYER_ID_001,         "Player ID 001"),
+  BUILTIN(2, PLAYER_ID_002,         "Player ID 002"),
+  BUILTIN(3, EVENT_PAUSE,           "Pause/Reset"),
+  BUILTIN(4, EVENT_END_EXERCISE,    "End Exercise")
 };
-const size_t NUM_PROTOCOLS = sizeof(protocols) / sizeof(protocols[0]);
+#undef BUILTIN
+const uint8_t NUM_BUILTIN = sizeof(builtin_protocols) / sizeof(builtin_protocols[0]);
+static_assert(REGISTRY_MAX_BITS == TX_MAX_BITS && MILES_MAX_BITS == TX_MAX_BITS, "word length limits disagree");
+
+typedef struct {
+  uint64_t bits;     // packed, bit i = bin i
+  uint8_t  len;      // bins
+} Frame;
+Frame proto_frame[REGISTRY_MAX][2];   // core 0: [registry index][opfor], side bit applied
+
+// -------------------- Burst / salvo --------------------
+// One trip through ARMED_IR_FLASH sends `count` frames back to back, gap_us
+// of idle between them. Entries are registry ids; BURST_SELECTED means
+// the code picked with NEXT. The side bit is applied to every frame.
+const uint8_t BURST_MAX      = 4;
+const uint8_t BURST_SELECTED = 0xff;
+
+typedef struct {
+  uint8_t  count;                  // 1 = single shot
+  uint32_t gap_us;
+  uint8_t  protocol[BURST_MAX];
+} BurstConfig;
+
+// Selected code three times, 20 ms apart: ~100 ms on air at the demo timing.
+const BurstConfig burst_config = { 3, 20000, { BURST_SELECTED, BURST_SELECTED, BURST_SELECTED } };
+// e.g. player ID then kill: { 2, 20000, { BURST_SELECTED, 0 } }
+
+// -------------------- Confirm-and-retry --------------------
+// A burst whose echo is missing, or has more than max_bit_errors bit errors
+// over all its frames, is sent again right after its confirm window, up to
+// max_retries times. A retry only starts if its own confirm window still
+// closes within budget_ms of the first TX start. PWR (disarm) cancels any
+// retry still to come.
+typedef struct {
+  uint8_t  max_retries;     // 0 = one attempt, never retry
+  uint8_t  max_bit_errors;  // more than this counts as corrupted
+  uint32_t budget_ms;       // first TX start to the last confirm window closing
+} RetryConfig;
+
+// Two retries, ~70 ms per attempt at the demo timing.
+const RetryConfig retry_config = { 2, 0, 400 };
 
 // -------------------- FSM --------------------
-enum State : uint8_t {
-  SAFE_STATE = 0,
-  SAFE_READY,
-  ARMED_FLY,
-  ARMED_SENSING,
-  ARMED_IR_FLASH,
-  EXPENDED
-};
-State state = SAFE_STATE;
+State state = SAFE_STATE;        // states and transitions: MILES_FSM.h
 
 // -------------------- UI / settings --------------------
 size_t active_index = 0;         // selected protocol index
 bool active_side_opfor = false;  // false=BLUFOR, true=OPFOR
-bool eeprom_ok = false;
 
-// Debounce / holds
-unsigned long t_last_next=0, t_last_side=0, t_last_fire=0, t_last_pwr=0;
-const unsigned long DEBOUNCE_MS = 200;
-const unsigned long PWR_HOLD_MS = 800;
+// Debounce / holds (integrator depth per pin, sampled every INPUT_TICK_US)
+constexpr unsigned long DEBOUNCE_MS        = TIMING.debounce_ms;
+constexpr unsigned long SENSOR_DEBOUNCE_MS = TIMING.sensor_debounce_ms;
+constexpr unsigned long PWR_HOLD_MS        = TIMING.pwr_hold_ms;
+
+enum InputId : uint8_t {
+  IN_PWR = 0,
+  IN_NEXT,
+  IN_SIDE,
+  IN_FIRE,
+  IN_LIMIT,
+  NUM_INPUTS,
+  IN_ALT = NUM_INPUTS,  // not sampled: posted by the altitude filter (MILES_ALT.h)
+  IN_RELEASED,          // not sampled: fused drop signals (MILES_FUSION.h)
+  IN_AT_ALT
+};
+const InputConfig input_table[NUM_INPUTS] = {
+  // pin           active_low  debounce_ms          long_press_ms
+  { PIN_BTN_PWR,   true,       DEBOUNCE_MS,         PWR_HOLD_MS },
+  { PIN_BTN_NEXT,  true,       DEBOUNCE_MS,         0 },
+  { PIN_BTN_SIDE,  true,       DEBOUNCE_MS,         0 },
+  { PIN_BTN_FIRE,  true,       DEBOUNCE_MS,         0 },
+  { PIN_LIMIT,     false,      SENSOR_DEBOUNCE_MS,  0 },   // HIGH = pressed; set true if wired INPUT_PULLUP->GND
+};
+
+// Altitude: 3 m +/- 0.15 m, decided every 10 ms with a ~40 ms filter.
+// Scale is for an analog sonar at Vcc/1024 per cm (4 counts/cm at 12 bit).
+const AltConfig alt_config = {
+  PIN_ALT_ADC,
+  2500,        // um_per_count
+  0,           // offset_mm
+  3000,        // threshold_mm
+  150,         // hysteresis_mm
+  10000,       // period_us
+  2,           // iir_shift
+  IN_ALT
+};
+
+const ImuConfig imu_config = { spi0, PIN_IMU_SCK, PIN_IMU_MOSI, PIN_IMU_MISO, PIN_IMU_CS, 10000000 };
+
+// Released: limit alone in 10 ms, with free fall in 4 ms. At altitude:
+// either term alone in 4 ms, both in 2 ms (at 3 m the unit falls 7.7 mm/ms).
+const FusionConfig fusion_config = {
+  IN_LIMIT, IN_RELEASED, IN_AT_ALT,
+  100,         // limit_gain
+  150,         // fall_gain
+  250,         // alt_gain
+  250,         // kin_gain
+  350,         // free_fall_mg
+  4000,        // impact_mg
+  3000         // kin_mm, as alt_config.threshold_mm
+};
 
 // Expended timer
 unsigned long t_expended_start = 0;
-const unsigned long EXPENDED_MS = 5000;
+constexpr unsigned long EXPENDED_MS = TIMING.expended_ms;
 
 // ---- Fire feedback / confirmation ----
-volatile bool flash_event = false;        // set when TX happens
-unsigned long flash_event_ms = 0;
+unsigned long flash_event_ms = 0;         // millis() of the last TX
 uint32_t shot_count = 0;
 const unsigned long FLASH_TOAST_MS = 600; // "IR FLASHED" banner duration
 
-volatile bool flash_confirmed = false;    // set if self-sense sees the burst
+bool flash_confirmed = false;             // set if self-sense sees the burst
 unsigned long confirmed_ms = 0;
-const unsigned long CONFIRM_WINDOW_MS = 12; // ms window after TX to accept confirmation
+uint8_t  flash_bit_errors = 0;            // echo vs. sent frame
+uint32_t flash_latency_us = 0;            // first echo edge vs. first sent pulse
+constexpr unsigned long CONFIRM_WINDOW_MS = TIMING.confirm_window_ms; // ms window after TX to accept confirmation
 const unsigned long CONFIRM_SHOW_MS   = 800;
 
+// -------------------- Core 0 -> core 1 messages --------------------
+typedef struct {
+  State    state;
+  uint8_t  active_index;
+  bool     side_opfor;
+  bool     limit, alt;
+  bool     confirmed;
+  uint8_t  bit_errors;
+  uint32_t shot_count;
+  uint32_t flash_ms;         // millis() of the last TX
+  uint32_t confirmed_ms;     // millis() of the last echo result
+  uint32_t expended_ms;      // millis() EXPENDED was entered
+} UiSnapshot;
+
+enum UiMsgType : uint8_t {
+  UI_SNAPSHOT = 0,
+  UI_SAVE_SETTINGS,
+  UI_LOG_TX,
+  UI_LOG_ECHO,
+  UI_LOG_RX,
+  UI_LOG_SHOT,               // one shot log record, seq / boot / crc still to fill
+  UI_LOG_TEXT,
+  UI_STANDBY,                // core 1: blank the OLED and deep-sleep until the next message
+  UI_WAKE,
+  UI_LOG_FUSE,               // a drop signal asserted while armed
+  UI_BENCH,                  // one core 0 benchmark result
+  UI_BENCH_DONE              // core 0 suite finished: run core 1's part
+};
+
+typedef struct {
+  UiMsgType type;
+  uint32_t  t_us;            // core 0 time of the event (log records)
+  union {
+    UiSnapshot snap;
+    struct { uint8_t pid, side; } save;
+    struct { uint64_t bits; uint8_t len; } tx;   // bit i of .bits = frame bit i
+    SenseResult echo;
+    struct { uint16_t bits; uint8_t pid, side, flags; } rx;   // pid / side 0xFF: no code matched
+    ShotRecord shot;
+    const char *text;        // string literal
+    struct { uint32_t wake_us, standby_ms; } wake;
+    struct { FuseReport r; uint8_t signal; } fuse;
+    BenchResult bench;
+  };
+} UiMsg;
+
+SpscQueue<UiMsg, 32> ui_queue;   // producer: core 0, consumer: core 1
+
+// SEV wakes core 1 out of its WFE as soon as something is queued.
+bool ui_post(const UiMsg &m) {
+  bool ok = ui_queue.push(m);
+  __sev();
+  return ok;
+}
+
+void ui_log(const char *text) {
+  UiMsg m; m.type = UI_LOG_TEXT; m.t_us = (uint32_t)time_us_64(); m.text = text;
+  ui_post(m);
+}
+
 // -------------------- Persistence --------------------
-void save_settings() {
-  if (!eeprom_ok) return;
-  EEPROM.put(EEPROM_ADDR_MAGIC, EEPROM_MAGIC);
-  EEPROM.put(EEPROM_ADDR_PROTOCOL, (uint8_t)protocols[active_index].id);
-  EEPROM.put(EEPROM_ADDR_SIDE, (uint8_t)(active_side_opfor ? 1 : 0));
-  EEPROM.commit();
+SettingsRecord settings_pending;         // core 1: newest requested values
+bool settings_dirty = false;
+unsigned long settings_changed_ms = 0;
+
+// Core 1: records the request; the flash write happens in settings_service().
+void save_settings(uint8_t pid, bool opfor) {
+  memset(&settings_pending, 0xFF, sizeof(settings_pending));
+  settings_pending.protocol_id = pid;
+  settings_pending.side = opfor ? 1 : 0;
+  settings_pending.profile_id = TIMING.id;
+  settings_dirty = true;
+  settings_changed_ms = millis();
 }
+
+void apply_settings(uint8_t pid, uint8_t side) {
+  int i = registry_find(pid);
+  if (i >= 0) active_index = (size_t)i;
+  active_side_opfor = (side!=0);
+}
+
+// Core 0, in setup(): newest journal record, else the legacy EEPROM block.
 void load_settings() {
-  if (!eeprom_ok) return;
+  SettingsRecord s;
+  if (!journal_init()) ui_log("Settings journal region missing (settings won't persist)");
+  if (journal_latest((uint8_t *)&s)) {
+    if (s.profile_id != 0xFF && s.profile_id != TIMING.id) ui_log("Settings from another profile");
+    apply_settings(s.protocol_id, s.side);
+    return;
+  }
+
+  if (!EEPROM.begin(512)) return;
   uint32_t magic=0; EEPROM.get(EEPROM_ADDR_MAGIC, magic);
-  if (magic != EEPROM_MAGIC) return;
-  uint8_t pid=0, side=0;
-  EEPROM.get(EEPROM_ADDR_PROTOCOL, pid);
-  EEPROM.get(EEPROM_ADDR_SIDE, side);
-  for (size_t i=0;i<NUM_PROTOCOLS;i++) if (protocols[i].id==pid) { active_index=i; break; }
-  active_side_opfor = (side!=0);
+  if (magic == EEPROM_MAGIC) {
+    uint8_t pid=0, side=0;
+    EEPROM.get(EEPROM_ADDR_PROTOCOL, pid);
+    EEPROM.get(EEPROM_ADDR_SIDE, side);
+    apply_settings(pid, side);
+  }
+  EEPROM.end();
 }
 
 // -------------------- Frame helpers --------------------
-void build_frame_from_code(const MILES_Code *c, uint8_t *out_bits, size_t *out_len) {
-  for (size_t i=0;i<11;i++) out_bits[i] = c->pattern[i] ? 1 : 0;
-  *out_len = 11;
+// Frames are packed words: bit i = bin i, each code has its own length.
+Frame build_frame_from_code(const RegistryEntry *c) {
+  Frame f = { c->pattern, c->bits };
+  return f;
+}
+// Words too short to hold the side bit are sent unchanged.
+Frame apply_side_to_frame(Frame f, bool opfor) {
+  static_assert(SIDE_BIT_INDEX < (int)MILES_FRAME_BITS, "SIDE_BIT_INDEX outside the standard frame");
+  if (SIDE_BIT_INDEX >= f.len) return f;
+  const uint64_t mask = 1ull << SIDE_BIT_INDEX;
+  f.bits = opfor ? (f.bits | mask) : (f.bits & ~mask);
+  return f;
 }
-void apply_side_to_frame(uint8_t *bits, size_t len, bool opfor) {
-  if (len > (size_t)SIDE_BIT_INDEX) bits[SIDE_BIT_INDEX] = opfor ? 1 : 0;
+
+// Standard-length words take the unrolled encoder (MILES_TX.h).
+bool encode_frame(TxBuffer *b, const Frame &f, uint32_t gap_us) {
+  if (f.len == MILES_FRAME_BITS) return tx_burst_append_fixed<MILES_FRAME_BITS>(b, f.bits, BIN_US, PULSE_US, gap_us);
+  return tx_burst_append(b, f.bits, f.len, BIN_US, PULSE_US, gap_us);
+}
+
+// Core 0, in setup(): picks the registry table and expands every entry.
+void load_registry() {
+  if (!registry_init(builtin_protocols, NUM_BUILTIN)) ui_log("No registry image in flash, using built-in codes");
+  for (uint8_t i = 0; i < reg_count; i++) {
+    Frame f = build_frame_from_code(&reg_entries[i]);
+    proto_frame[i][0] = apply_side_to_frame(f, false);
+    proto_frame[i][1] = apply_side_to_frame(f, true);
+  }
+  rx_table_clear();                       // slot = 2 * index + side
+  for (uint8_t i = 0; i < reg_count; i++)
+    for (uint8_t s = 0; s < 2; s++) rx_table_add(2 * i + s, proto_frame[i][s].bits, proto_frame[i][s].len);
 }
 
 // -------------------- Sensors --------------------
+// Debounced levels from the input sampler; polarity lives in input_table.
 bool limit_switch_pressed() {
-  // If wired INPUT_PULLUP->GND, invert this logic accordingly.
-  // Here we assume HIGH = pressed (adjust for your wiring).
-  return digitalRead(PIN_LIMIT) == HIGH;
+  return input_active(IN_LIMIT);
 }
+// Latched by the altitude filter; crossings also wake loop() as IN_ALT edges.
 bool altitude_ge_3m() {
-  // For bench test, PIN_ALT_OK HIGH means ">= 3m".
-  // Replace with actual baro/ultrasonic threshold logic when integrating real sensor.
-  return digitalRead(PIN_ALT_OK) == HIGH;
+  return alt_above();
+}
+// Fused (MILES_FUSION.h); edges wake loop() as IN_RELEASED / IN_AT_ALT.
+// Without the fusion timer, the raw levels above. A closed limit vetoes
+// "released" at once, before the next fusion tick has seen it.
+bool fuse_ok = false;
+bool drop_released() {
+  return !limit_switch_pressed() && (!fuse_ok || fuse_on(FUSE_RELEASED));
+}
+bool drop_at_altitude() {
+  return fuse_ok ? fuse_on(FUSE_AT_ALT) : altitude_ge_3m();
+}
+
+// -------------------- Transmit (PIO + DMA) --------------------
+bool tx_ok = false;                       // PIO/DMA engine claimed in setup()
+bool tx_pending = false;                  // burst on air or confirm window open
+bool tx_done = false;                     // end-of-frame IRQ seen for the burst on air
+uint32_t tx_done_us = 0;                  // its IRQ time
+std::atomic<bool> tx_done_irq(false);     // set by on_tx_done(), taken by tx_done_latched()
+uint32_t tx_done_irq_us = 0;
+Frame    tx_frames[BURST_MAX];            // frames on air, for the echo check
+uint8_t  tx_count = 0;
+uint32_t tx_gap_us = 0;
+SenseMark tx_mark;
+uint32_t tx_own_until_us = 0;             // frames received up to here are the last burst's echo
+ShotRecord tx_shot;                       // the shot log record, completed by the echo check
+const TxBuffer *tx_buf = nullptr;         // buffer of the shot in progress, resent on retry
+uint8_t  tx_attempt = 0;                  // 0 = first burst of the shot
+uint8_t  tx_retries_left = 0;
+uint32_t tx_first_us = 0;                 // TX start of attempt 0
+
+// Frame k's bin 0, relative to TX start.
+uint32_t tx_frame_offset_us(uint8_t k) {
+  uint32_t t = TX_GUARD_US;
+  for (uint8_t i = 0; i < k; i++) t += tx_frames[i].len * BIN_US + tx_gap_us;
+  return t;
 }
 
-// -------------------- Transmit (replace with DMA/PWM) --------------------
-void laser_transmit_frame(const uint8_t *frame_bits, size_t bitlen) {
+// Ready-to-stream buffer for the selected (protocol, side) burst. Rebuilt
+// when the selection changes, never on the fire path. A change that lands
+// while the PIO is still reading the buffer is deferred to the end-of-frame
+// event.
+typedef struct {
+  Frame    frames[BURST_MAX]; // incl. side bit
+  uint8_t  count;
+  TxBuffer tx;
+  bool     stale;
+} FrameCache;
+FrameCache frame_cache = { {}, 0, {}, true };
+
+static_assert(BURST_MAX * (2 * MILES_FRAME_BITS + 2) <= TX_MAX_WORDS, "a standard-length burst must fit a TxBuffer");
+
+// Registry index for a burst entry; unknown ids fall back to the selection.
+size_t burst_index(uint8_t entry) {
+  int i = entry == BURST_SELECTED ? -1 : registry_find(entry);
+  return i >= 0 ? (size_t)i : active_index;
+}
+
+void frame_cache_rebuild() {
+  frame_cache.stale = true;
+  if (tx_pending || tx_is_busy()) return;   // a retry resends the same buffer
+  uint8_t n = burst_config.count < 1 ? 1 : (burst_config.count > BURST_MAX ? BURST_MAX : burst_config.count);
+  tx_burst_begin(&frame_cache.tx);
+  uint8_t k = 0;
+  for (; k < n; k++) {   // long words may not all fit: the burst is cut short
+    frame_cache.frames[k] = proto_frame[burst_index(burst_config.protocol[k])][active_side_opfor ? 1 : 0];
+    if (!encode_frame(&frame_cache.tx, frame_cache.frames[k], k ? burst_config.gap_us : 0)) break;
+  }
+  tx_burst_end(&frame_cache.tx);
+  frame_cache.count = k;
+  frame_cache.stale = false;
+}
+
+// The completion is latched outside the event ring: EV_TX_DONE only wakes
+// core 0, so a post dropped on a full ring cannot leave the burst pending.
+void on_tx_done() {                       // IRQ context
+  tx_done_irq_us = (uint32_t)time_us_64();
+  tx_done_irq.store(true, std::memory_order_release);
+  trace(TR_TX_END);
+  sched_post(EV_TX_DONE);
+}
+
+// Core 0: takes the latch into tx_done/tx_done_us. True once per burst.
+bool tx_done_latched() {
+  if (!tx_done_irq.exchange(false, std::memory_order_acquire)) return false;
+  tx_done = true;
+  tx_done_us = tx_done_irq_us;
+  return true;
+}
+
+// Sends attempt tx_attempt of the shot in progress: tx_buf, described by
+// tx_frames. The scope must already be armed.
+void tx_kick() {
+  tx_done = false;
+  tx_mark = sense_mark(time_us_64());
+  tx_own_until_us = tx_mark.t_us + tx_frame_offset_us(tx_count) + CONFIRM_WINDOW_MS * 1000;
+  memset(&tx_shot, 0, sizeof(tx_shot));
+  tx_shot.t_ms = millis();
+  tx_shot.pid  = reg_entries[burst_index(burst_config.protocol[0])].id;
+  tx_shot.flags = (active_side_opfor ? SHOT_OPFOR : 0) | (tx_attempt ? SHOT_RETRY : 0);
+  trace(TR_TX_START, tx_attempt);
+  if (!tx_ok || !tx_start(tx_buf, on_tx_done)) {   // no engine: frame dropped, echo check reports none
+    tx_shot.flags |= SHOT_NO_TX;
+    on_tx_done();
+  }
+
+  for (uint8_t k = 0; k < tx_count; k++) {   // logged by core 1 after the burst has started
+    UiMsg m; m.type = UI_LOG_TX;
+    m.t_us = tx_mark.t_us + tx_frame_offset_us(k);
+    m.tx.bits = tx_frames[k].bits; m.tx.len = tx_frames[k].len;
+    ui_post(m);
+  }
+}
+
+// Streams a prebuilt buffer; frames[0..count) (gap_us apart) describe it
+// for the echo check. Retries (retry_config) resend the same buffer.
+void laser_transmit_frame(const TxBuffer *buf, const Frame *frames, uint8_t count, uint32_t gap_us) {
+  if (tx_pending) return;
+  scope_arm();                            // before tx_frames changes: core 1 may be reading the last shot
+
   // GUI feedback: shot count + toast
   shot_count++;
-  flash_event = true;
   flash_event_ms = millis();
 
-  Serial.print("TX bits: "); for (size_t i=0;i<bitlen;i++) Serial.print(frame_bits[i]?'1':'0'); Serial.println();
-
-  // Simple, illustrative timing only. Replace with your PWM+DMA burst.
-  digitalWrite(PIN_OUT, LOW);
-  delayMicroseconds(10);
+  tx_count = count > BURST_MAX ? BURST_MAX : count;
+  memcpy(tx_frames, frames, tx_count * sizeof(tx_frames[0]));
+  tx_gap_us = gap_us;
+  tx_buf = buf;
+  tx_pending = true;
+  tx_attempt = 0;
+  tx_retries_left = retry_config.max_retries;
+  tx_kick();
+  tx_first_us = tx_mark.t_us;
+}
 
-  for (size_t i=0;i<bitlen;i++) {
-    if (frame_bits[i]) {
-      digitalWrite(PIN_OUT, HIGH);
-      delayMicroseconds(PULSE_US);
-      digitalWrite(PIN_OUT, LOW);
-      if (BIN_US > PULSE_US) delayMicroseconds(BIN_US - PULSE_US);
-    } else {
-      delayMicroseconds(BIN_US);
-    }
-  }
-  digitalWrite(PIN_OUT, LOW);
+// Another attempt is worth it if there is an engine to send it, retries
+// are left and its confirm window closes inside the budget.
+bool tx_retry_allowed() {
+  if (!tx_retries_left || (tx_shot.flags & SHOT_NO_TX)) return false;
+  uint32_t attempt_us = tx_frame_offset_us(tx_count) + TX_GUARD_US + CONFIRM_WINDOW_MS * 1000;
+  return (uint32_t)time_us_64() - tx_first_us + attempt_us <= retry_config.budget_ms * 1000;
+}
 
-  // Physical confirmation window: check self-sense pin for a brief time
-  unsigned long start = millis();
+// Called every loop(). Once the confirm window (CONFIRM_WINDOW_MS after the
+// PIO finished) has closed, checks each frame's echo against what was sent.
+// The burst counts as confirmed if any frame was seen; bit errors add up.
+// A failed burst is resent (tx_retry_allowed) and the shot stays pending;
+// every burst gets its own shot log record.
+void laser_transmit_poll() {
+  if (!tx_pending) return;
+  if (!tx_done || (uint32_t)time_us_64() - tx_done_us < CONFIRM_WINDOW_MS * 1000) return;
+  scope_stop();
   bool seen = false;
-  while (millis() - start < CONFIRM_WINDOW_MS) {
-    // Adjust polarity to match your IR module. Many produce HIGH on envelope detect.
-    if (digitalRead(PIN_IR_SENSE) == HIGH) { seen = true; break; }
+  uint32_t errors = 0, latency = 0;
+  for (uint8_t k = 0; k < tx_count; k++) {
+    // A frame's echo ends where the next frame starts; the last one's with
+    // the confirm window.
+    SenseMark mk = sense_mark_at(&tx_mark, tx_mark.t_us + tx_frame_offset_us(k));
+    uint32_t end = k + 1 < tx_count ? tx_mark.t_us + tx_frame_offset_us(k + 1)
+                                    : mk.t_us + tx_frames[k].len * BIN_US + CONFIRM_WINDOW_MS * 1000;
+    SenseResult r = sense_check(&mk, tx_frames[k].bits, tx_frames[k].len, BIN_US, PULSE_US, 0, end);
+    if (r.seen && !seen) latency = r.latency_us;
+    seen |= r.seen;
+    errors += r.bit_errors;
+
+    UiMsg m; m.type = UI_LOG_ECHO; m.t_us = mk.t_us; m.echo = r;
+    ui_post(m);
   }
-  flash_confirmed = seen;
+  flash_confirmed  = seen;
+  flash_bit_errors = errors > 255 ? 255 : (uint8_t)errors;
+  flash_latency_us = latency;
   confirmed_ms = millis();
+
+  tx_shot.flags     |= seen ? SHOT_CONFIRMED : 0;
+  tx_shot.bit_errors = flash_bit_errors;
+  tx_shot.latency_us = seen && latency < 0xFFFF ? (uint16_t)latency : 0xFFFF;
+  UiMsg m; m.type = UI_LOG_SHOT; m.t_us = tx_mark.t_us; m.shot = tx_shot;
+  ui_post(m);
+
+  if ((!seen || errors > retry_config.max_bit_errors) && tx_retry_allowed()) {
+    tx_retries_left--;
+    tx_attempt++;
+    trace(TR_RETRY, tx_attempt);
+    scope_arm();
+    tx_kick();
+    return;
+  }
+  tx_pending = false;
+  trace(TR_SHOT_DONE, tx_attempt);
+  if (frame_cache.stale) frame_cache_rebuild();   // a selection change during the shot
 }
 
-// -------------------- LEDs & GUI --------------------
+// -------------------- LEDs (core 0) --------------------
 void set_state_leds() {
   digitalWrite(LED_SAFE,     state == SAFE_STATE ? HIGH : LOW);
   digitalWrite(LED_ARMED,   (state == SAFE_READY || state == ARMED_FLY || state == ARMED_SENSING || state == ARMED_IR_FLASH) ? HIGH : LOW);
   digitalWrite(LED_EXPENDED, state == EXPENDED ? HIGH : LOW);
 }
+// -------------------- UI publishing (core 0) --------------------
+UiSnapshot ui_posted;
+bool ui_posted_valid = false;
+
+// Posts a snapshot when anything the GUI shows has changed. Returns false if
+// the queue was full and the snapshot still needs to go out.
+bool ui_publish() {
+  UiMsg m;
+  memset(&m, 0, sizeof(m));      // zero padding so memcmp is meaningful
+  m.type = UI_SNAPSHOT;
+  m.t_us = (uint32_t)time_us_64();
+  UiSnapshot &s = m.snap;
+  s.state        = state;
+  s.active_index = (uint8_t)active_index;
+  s.side_opfor   = active_side_opfor;
+  s.limit        = limit_switch_pressed();
+  s.alt          = altitude_ge_3m();
+  s.confirmed    = flash_confirmed;
+  s.bit_errors   = flash_bit_errors;
+  s.shot_count   = shot_count;
+  s.flash_ms     = flash_event_ms;
+  s.confirmed_ms = confirmed_ms;
+  s.expended_ms  = t_expended_start;
+  if (ui_posted_valid && memcmp(&s, &ui_posted, sizeof(s)) == 0) return true;
+  if (!ui_post(m)) return false;
+  ui_posted = s; ui_posted_valid = true;
+  return true;
+}
+
+void ui_request_save() {
+  UiMsg m; m.type = UI_SAVE_SETTINGS; m.t_us = 0;
+  m.save.pid  = reg_entries[active_index].id;
+  m.save.side = active_side_opfor ? 1 : 0;
+  ui_post(m);
+}
+
+// -------------------- Boot timing --------------------
+// Milestones in us since reset.
+const uint32_t BOOT_PENDING = UINT32_MAX;             // not reached yet
+std::atomic<uint32_t> boot_armable_us(BOOT_PENDING);  // core 0: setup() done, inputs live
+uint32_t boot_frame_us = BOOT_PENDING;                // core 1: first frame handed to the flush
+uint32_t boot_usb_us = BOOT_PENDING;                  // core 1: host first seen on USB
+bool boot_reported = false;
+const unsigned long BOOT_USB_POLL_MS = 10;            // resolution of the USB time
+
+// -------------------- GUI (core 1) --------------------
+UiSnapshot ui;   // core 1's copy of the last snapshot
+
 const char* state_name(State s) {
-  switch(s) {
-    case SAFE_STATE:     return "SAFE";
-    case SAFE_READY:     return "SAFE READY";
-    case ARMED_FLY:      return "ARMED FLY";
-    case ARMED_SENSING:  return "ARMED SENSE";
-    case ARMED_IR_FLASH: return "IR FLASH";
-    case EXPENDED:       return "EXPENDED";
-    default:             return "?";
+  return s < NUM_STATES ? FSM_STATE_NAMES[s] : "?";
+}
+// Retained-mode GUI: each widget owns a rect and a content key. draw_gui()
+// only clears and redraws widgets whose key changed (plus any widget they
+// overlap), marks those rects dirty and kicks a background DMA flush of the
+// touched SSD1306 pages. Cheap enough to call every loop1().
+// A widget's static labels come from oled_bg; its value comes from a glyph
+// strip where one was cached for the key, else from the font.
+enum Widget : uint8_t {
+  W_TITLE = 0,
+  W_SHOTS,
+  W_STATE,      // "State:" + size-2 name (long names wrap onto the next rows)
+  W_BANNER,     // IR FLASHED toast / CONFIRMED
+  W_PROTO,      // long names wrap onto a second row
+  W_SIDE,
+  W_INPUTS,
+  W_COUNTDOWN,
+  NUM_WIDGETS
+};
+const Rect widget_rect[NUM_WIDGETS] = {
+  {   0,  0,  96,  8 },
+  {  98,  0,  30,  8 },
+  {   0, 10, 128, 32 },
+  {   0, 24, 128, 10 },
+  {   0, 32, 128, 16 },
+  {   0, 44, 128,  8 },
+  {   0, 56, 102,  8 },
+  { 100, 56,  28,  8 },
+};
+uint32_t widget_key[NUM_WIDGETS];
+bool gui_valid = false;     // false until the first full render
+bool gui_cached = false;    // oled_bg and the glyph strips are built
+bool gui_use_cache = true;  // false: font for everything (bench reference)
+bool oled_dma_ok = false;   // false: fall back to blocking display.display()
+
+void gui_keys(uint32_t *k) {
+  // Toast / confirmation expire on core 1's clock
+  bool toast   = ui.shot_count && (millis() - ui.flash_ms) < FLASH_TOAST_MS;
+  bool confirm = ui.confirmed  && (millis() - ui.confirmed_ms) < CONFIRM_SHOW_MS;
+
+  unsigned long remain = 0;
+  if (ui.state == EXPENDED && millis() - ui.expended_ms < EXPENDED_MS)
+    remain = (EXPENDED_MS - (millis() - ui.expended_ms)) / 1000UL;
+
+  k[W_TITLE]     = 0;
+  k[W_SHOTS]     = ui.shot_count;
+  k[W_STATE]     = ui.state;
+  k[W_BANNER]    = (toast ? 1u : 0u) | (confirm ? 2u : 0u) | ((uint32_t)ui.bit_errors << 2);
+  k[W_PROTO]     = ui.active_index;
+  k[W_SIDE]      = ui.side_opfor ? 1 : 0;
+  k[W_INPUTS]    = (ui.limit ? 1u : 0u) | (ui.alt ? 2u : 0u);
+  k[W_COUNTDOWN] = ui.state == EXPENDED ? remain + 1 : 0;
+}
+
+// The parts of a widget that never change (drawn into oled_bg once).
+void draw_widget_static(uint8_t w) {
+  display.setTextSize(1);
+  switch (w) {
+    case W_TITLE:  display.setCursor(0, 0);   display.print("MILES FSM"); break;
+    case W_SHOTS:  display.setCursor(98, 0);  display.print("#"); break;
+    case W_STATE:  display.setCursor(0, 12);  display.print("State:"); break;
+    case W_PROTO:  display.setCursor(0, 32);  display.print("Proto: "); break;
+    case W_SIDE:   display.setCursor(0, 44);  display.print("Side : "); break;
+    case W_INPUTS: display.setCursor(0, 56);  display.print("LIM:");
+                   display.setCursor(42, 56); display.print(" ALT3m:"); break;
   }
 }
-void draw_gui() {
-  display.clearDisplay();
-  display.setTextColor(SSD1306_WHITE);
 
-  // Title
+// The value for key k[w]. Reads nothing but k for the widgets that have
+// glyph strips, so gui_cache_build() can draw every key.
+void draw_widget(uint8_t w, const uint32_t *k) {
   display.setTextSize(1);
-  display.setCursor(0,0); display.print("MILES FSM");
+  switch (w) {
+    case W_SHOTS:
+      display.setCursor(104, 0); display.print(ui.shot_count);
+      break;
+    case W_STATE:
+      display.setTextSize(2);
+      display.setCursor(48, 10); display.print(state_name((State)k[W_STATE]));
+      break;
+    case W_BANNER:
+      if (k[W_BANNER] & 1) {
+        display.fillRect(0, 24, 128, 10, SSD1306_WHITE);
+        display.setTextColor(SSD1306_BLACK);
+        display.setCursor(28, 24); display.print("IR FLASHED");
+        display.setTextColor(SSD1306_WHITE);
+      }
+      if (k[W_BANNER] & 2) {
+        display.setCursor(0, 24);
+        if (ui.bit_errors == 0) display.print("CONFIRMED");
+        else { display.print("ECHO ERR:"); display.print(ui.bit_errors); }
+      }
+      break;
+    case W_PROTO:
+      display.setCursor(42, 32); display.print(k[W_PROTO] < reg_count ? reg_entries[k[W_PROTO]].name : "?");
+      break;
+    case W_SIDE:
+      display.setCursor(42, 44); display.print(k[W_SIDE] ? "OPFOR" : "BLUFOR");
+      break;
+    case W_INPUTS:
+      display.setCursor(24, 56); display.print((k[W_INPUTS] & 1) ? "ON "  : "OFF");
+      display.setCursor(84, 56); display.print((k[W_INPUTS] & 2) ? "YES" : "NO ");
+      break;
+    case W_COUNTDOWN:
+      if (k[W_COUNTDOWN]) { display.setCursor(100, 56); display.print("T-"); display.print(k[W_COUNTDOWN] - 1); display.print("s"); }
+      break;
+  }
+  display.setTextSize(1);
+}
 
-  // Shot counter (top-right)
-  display.setCursor(98, 0); display.print("#"); display.print(shot_count);
+// Widgets whose value is one of a fixed set of keys 0..n-1.
+uint32_t gui_strip_keys(uint8_t w) {
+  switch (w) {
+    case W_STATE:  return NUM_STATES;
+    case W_PROTO:  return reg_count;
+    case W_SIDE:   return 2;
+    case W_INPUTS: return 4;
+    default:       return 0;
+  }
+}
 
-  // State
-  display.setCursor(0, 12); display.print("State:");
-  display.setTextSize(2);
-  display.setCursor(48, 10); display.print(state_name(state));
-  display.setTextSize(1);
+const uint16_t GUI_MAX_STRIPS = NUM_STATES + REGISTRY_MAX + 2 + 4;
+GlyphStrip gui_strips[GUI_MAX_STRIPS];
+uint16_t gui_strip_base[NUM_WIDGETS];
+uint16_t gui_strip_count[NUM_WIDGETS];     // keys below this have a strip
 
-  // Protocol & side
-  display.setCursor(0, 32); display.print("Proto: "); display.print(protocols[active_index].name);
-  display.setCursor(0, 44); display.print("Side : "); display.print(active_side_opfor ? "OPFOR" : "BLUFOR");
+const GlyphStrip *gui_strip(uint8_t w, uint32_t key) {
+  if (!gui_cached || !gui_use_cache || key >= gui_strip_count[w]) return nullptr;
+  return &gui_strips[gui_strip_base[w] + key];
+}
 
-  // Inputs
-  display.setCursor(0, 56);
-  display.print("LIM:");   display.print(limit_switch_pressed() ? "ON "  : "OFF");
-  display.print(" ALT3m:"); display.print(altitude_ge_3m()     ? "YES" : "NO ");
+// Renders the static labels into oled_bg and every key of every strip
+// widget into the pool, each alone in the cleared framebuffer. Needs the
+// registry, so it runs on the first snapshot (core 0's setup is done).
+void gui_cache_build() {
+  uint8_t *fb = display.getBuffer();
+  display.setTextColor(SSD1306_WHITE);
+  display.clearDisplay();
+  for (uint8_t w = 0; w < NUM_WIDGETS; w++) draw_widget_static(w);
+  memcpy(oled_bg, fb, OLED_FB_BYTES);
 
-  // Toast: “IR FLASHED”
-  if (flash_event && (millis() - flash_event_ms) < FLASH_TOAST_MS) {
-    display.fillRect(0, 24, 128, 10, SSD1306_WHITE);
-    display.setTextColor(SSD1306_BLACK);
-    display.setCursor(28, 24); display.print("IR FLASHED");
+  uint16_t n = 0;
+  for (uint8_t w = 0; w < NUM_WIDGETS; w++) {
+    uint32_t k[NUM_WIDGETS] = {};
+    gui_strip_base[w] = n;
+    gui_strip_count[w] = 0;
+    for (uint32_t key = 0; key < gui_strip_keys(w) && n < GUI_MAX_STRIPS; key++) {
+      display.clearDisplay();
+      k[w] = key;
+      draw_widget(w, k);
+      if (!oled_strip_capture(fb, &gui_strips[n])) break;   // pool full: font from here on
+      n++;
+      gui_strip_count[w]++;
+    }
+  }
+  display.clearDisplay();
+  oled_mark_dirty(Rect{ 0, 0, OLED_W, OLED_PAGES * 8 });
+  gui_cached = true;
+  gui_valid = false;
+}
+
+void draw_gui() {
+  uint64_t t0 = time_us_64();
+  uint32_t k[NUM_WIDGETS];
+  gui_keys(k);
+
+  uint32_t dirty = 0;
+  for (uint8_t w = 0; w < NUM_WIDGETS; w++)
+    if (!gui_valid || k[w] != widget_key[w]) dirty |= 1u << w;
+
+  if (dirty) {
+    trace_at(TR_GUI_BEGIN, 0, t0);
+    dirty = oled_close_dirty(dirty, widget_rect, NUM_WIDGETS);
+    bool bg = gui_cached && gui_use_cache;
+    uint8_t *fb = display.getBuffer();
     display.setTextColor(SSD1306_WHITE);
-  } else if (flash_event && (millis() - flash_event_ms) >= FLASH_TOAST_MS) {
-    flash_event = false;
+    for (uint8_t w = 0; w < NUM_WIDGETS; w++) {
+      if (!(dirty & (1u << w))) continue;
+      const Rect &r = widget_rect[w];
+      if (bg) oled_bg_restore(fb, r);
+      else display.fillRect(r.x, r.y, r.w, r.h, SSD1306_BLACK);
+      oled_mark_dirty(r);
+    }
+    for (uint8_t w = 0; w < NUM_WIDGETS; w++) {   // z-order = enum order
+      if (!(dirty & (1u << w))) continue;
+      if (!bg) draw_widget_static(w);
+      const GlyphStrip *s = gui_strip(w, k[w]);
+      if (s) oled_strip_blit(fb, *s);
+      else draw_widget(w, k);
+      widget_key[w] = k[w];
+    }
+    gui_valid = true;
+    if (boot_frame_us == BOOT_PENDING) boot_frame_us = (uint32_t)time_us_64();
+    trace(TR_GUI_END);
+    if (!oled_dma_ok) { trace(TR_FLUSH_BEGIN); display.display(); trace(TR_FLUSH_END); }
+  }
+  if (oled_dma_ok) {               // also retries spans left over while the DMA was busy
+    uint64_t f0 = time_us_64();
+    if (oled_flush()) { trace_at(TR_FLUSH_BEGIN, 0, f0); trace(TR_FLUSH_END); }
   }
+}
+
+// Latency histograms printed by trace_dump(). Input edges carry their
+// sampler timestamp, so "LIM->SENSE" includes the debounce-to-FSM path but
+// not the debounce depth itself. "ALT->TX" is only meaningful when ALT goes
+// high while ARMED_SENSING; "SENSE->TX" covers the already-high case.
+const TraceSpan TRACE_SPANS[] = {
+  { "LIM->SENSE", TR_RELEASE,     IN_LIMIT,      TR_STATE,     ARMED_SENSING },
+  { "ALT->TX",    TR_PRESS,       IN_ALT,        TR_TX_START,  TRACE_ANY },
+  { "LIM->REL",   TR_RELEASE,     IN_LIMIT,      TR_PRESS,     IN_RELEASED },
+  { "ALT->FUSE",  TR_PRESS,       IN_ALT,        TR_PRESS,     IN_AT_ALT },
+  { "SENSE->TX",  TR_STATE,       ARMED_SENSING, TR_TX_START,  TRACE_ANY },
+  { "TX frame",   TR_TX_START,    TRACE_ANY,     TR_TX_END,    TRACE_ANY },
+  { "FIRE->DONE", TR_TX_START,    0,             TR_SHOT_DONE, TRACE_ANY },
+  { "RETRY",      TR_RETRY,       TRACE_ANY,     TR_TX_START,  TRACE_ANY },
+  { "GUI render", TR_GUI_BEGIN,   TRACE_ANY,     TR_GUI_END,   TRACE_ANY },
+  { "OLED flush", TR_FLUSH_BEGIN, TRACE_ANY,     TR_FLUSH_END, TRACE_ANY },
+  { "WAKE",       TR_WAKE_EDGE,   TRACE_ANY,     TR_WAKE_READY, TRACE_ANY },
+};
+
+// Serial is quiet while a burst or its confirm window is in progress: USB
+// traffic there would add interrupt jitter to the self-sense timestamps.
+bool serial_idle() {
+  return ui.state != ARMED_IR_FLASH;
+}
+
+const uint32_t TELEM_RETRY_MS = 5;   // poll for USB room while records are queued
+bool trace_requested = false;
+
+// Benchmark results (MILES_BENCH builds): core 0's arrive as UI_BENCH messages.
+const uint8_t BENCH_MAX_RESULTS = 12;
+BenchResult bench_results[BENCH_MAX_RESULTS];
+uint8_t bench_count = 0;
+bool bench_due = false;               // core 0 is done, core 1's part still to run
+bool bench_print_requested = false;
+bool scope_requested = false;
 
-  // Confirmation: show for a short time after TX
-  if (flash_confirmed && (millis() - confirmed_ms) < CONFIRM_SHOW_MS) {
-    display.setCursor(0, 24); display.print("CONFIRMED");
-  } else if (flash_confirmed && (millis() - confirmed_ms) >= CONFIRM_SHOW_MS) {
-    flash_confirmed = false;
+// Nominal '1' bins of a burst, relative to the first: bin i of a frame
+// rises at i * BIN_US and lasts PULSE_US, frames are len * BIN_US + gap_us
+// apart (as tx_frame_offset_us()).
+uint32_t scope_pulses(ScopePulse *p, uint32_t max, const Frame *frames, uint8_t count, uint32_t gap_us) {
+  uint32_t n = 0, first = 0, t = 0;
+  for (uint8_t k = 0; k < count; k++) {
+    for (uint8_t i = 0; i < frames[k].len; i++) {
+      if (!((frames[k].bits >> i) & 1) || n == max) continue;
+      uint32_t rise = t + i * BIN_US;
+      if (n == 0) first = rise;
+      p[n].rise_ns = (rise - first) * 1000;
+      p[n].width_ns = PULSE_US * 1000;
+      p[n].frame = k; p[n].bin = i;
+      n++;
+    }
+    t += frames[k].len * BIN_US + gap_us;
   }
+  return n;
+}
+
+// Core 1: the edge timer's view of the last shot (MILES_SCOPE.h).
+void scope_dump() {
+  static uint32_t cycles[SCOPE_MAX];
+  static ScopePulse ideal[SCOPE_MAX / 2];
+  Frame frames[BURST_MAX];
+  uint8_t count = 0;
+  uint32_t gap_us = 0;
+  uint32_t n = scope_snapshot(cycles, [&] { memcpy(frames, tx_frames, sizeof(frames)); count = tx_count; gap_us = tx_gap_us; });
+  if (n == 0) { Serial.println("scope: no capture yet"); return; }
+  uint32_t np = scope_pulses(ideal, SCOPE_MAX / 2, frames, count, gap_us);
+  scope_report(Serial, cycles, n, ideal, np, clock_get_hz(clk_sys));
+  if (carrier_sm < 0) return;
+  Serial.print("scope: carrier ");
+  if (carrier_hz) { Serial.print(carrier_hz); Serial.print(" Hz, "); Serial.print(carrier_config.duty_pct); Serial.println(" % duty"); }
+  else Serial.println("off (baseband)");
+}
+
+// Registry upload: 'L' followed by one complete image. Only accepted in
+// SAFE_STATE; on success the unit reboots into the new table.
+const unsigned long REGISTRY_RX_TIMEOUT_MS = 2000;
+uint8_t  reg_rx[REGISTRY_BYTES];
+uint32_t reg_rx_len = 0;
+bool     reg_rx_active = false;
+unsigned long reg_rx_ms = 0;
+
+void registry_upload_done() {
+  reg_rx_active = false;
+  if (ui.state != SAFE_STATE) { telem_text("Registry upload rejected: not SAFE"); return; }
+  if (!registry_store(reg_rx, reg_rx_len)) { telem_text("Registry upload invalid"); return; }
+  telem_text("Registry stored, rebooting");
+  unsigned long t = millis();
+  while (!telem_empty() && millis() - t < 100) telem_flush(Serial);
+  Serial.flush();
+  rp2040.reboot();
+}
+
+void registry_rx_byte(uint8_t c) {
+  reg_rx[reg_rx_len++] = c;
+  reg_rx_ms = millis();
+  if (reg_rx_len < sizeof(RegistryHeader)) return;
+  uint8_t count = ((const RegistryHeader *)reg_rx)->count;
+  if (count == 0 || count > REGISTRY_MAX) { reg_rx_active = false; telem_text("Registry upload invalid"); return; }
+  if (reg_rx_len == sizeof(RegistryHeader) + count * sizeof(RegistryEntry)) registry_upload_done();
+}
 
-  // Expended countdown
-  if (state == EXPENDED) {
-    unsigned long remain = 0;
-    if (millis() - t_expended_start < EXPENDED_MS)
-      remain = (EXPENDED_MS - (millis() - t_expended_start)) / 1000UL;
-    display.setCursor(100, 56); display.print("T-"); display.print(remain); display.print("s");
+// GUI bridge: host command frames (MILES_TELEM.h framing) and the TM_UI
+// mirror. Only the newest GUI state is sent, so a burst of snapshots costs
+// one record per MIRROR_MIN_MS however fast they arrive.
+const unsigned long HOST_RX_TIMEOUT_MS = 100;   // a partial frame older than this is dropped
+const unsigned long MIRROR_MIN_MS = 20;
+TelemRx host_rx = {};
+unsigned long host_rx_ms = 0;
+bool mirror_on = false;
+bool mirror_dirty = false;
+unsigned long mirror_sent_ms = 0;
+
+const uint8_t INJECT_ALL = 0xFF;          // EV_INJECT arg: release every injected input
+
+// Each (input id, i16 value) of an HC_INJECT frame becomes an EV_INJECT
+// for core 0 (inject_event()). HC_MIRROR off detaches the bridge: every
+// injected input goes back to the hardware.
+void host_command(const TelemRx &p) {
+  switch (p.b[0]) {
+    case HC_MIRROR:
+      mirror_on = p.len >= 2 && p.b[1];
+      mirror_dirty = mirror_on;
+      if (!mirror_on) sched_post(EV_INJECT, INJECT_ALL);
+      break;
+    case HC_INJECT:
+      for (uint8_t i = 1; i + 3 <= p.len; i += 3)
+        sched_post(EV_INJECT, p.b[i], (int16_t)(p.b[i + 1] | p.b[i + 2] << 8));
+      break;
   }
+}
 
-  display.display();
-  set_state_leds();
+void mirror_service() {
+  if (!mirror_on || !mirror_dirty || millis() - mirror_sent_ms < MIRROR_MIN_MS) return;
+  if (telem_room() < TELEM_MAX_BODY + 3) return;
+  TelemBody r;
+  uint8_t flags = (ui.side_opfor ? 1 : 0) | (ui.limit ? 2 : 0) | (ui.alt ? 4 : 0) | (ui.confirmed ? 8 : 0);
+  telem_begin(r, TM_UI);
+  telem_put(r, millis(), 4); telem_put(r, ui.state, 1); telem_put(r, ui.active_index, 1);
+  telem_put(r, reg_entries[ui.active_index].id, 1); telem_put(r, flags, 1); telem_put(r, ui.bit_errors, 1);
+  telem_put(r, ui.shot_count, 4); telem_put(r, ui.flash_ms, 4);
+  telem_put(r, ui.confirmed_ms, 4); telem_put(r, ui.expended_ms, 4);
+  telem_commit(r);
+  mirror_dirty = false;
+  mirror_sent_ms = millis();
 }
 
-// -------------------- Buttons / actions --------------------
-void next_protocol()       { active_index = (active_index + 1) % NUM_PROTOCOLS; save_settings(); draw_gui(); }
-void toggle_side()         { active_side_opfor = !active_side_opfor; save_settings(); draw_gui(); }
-void manual_fire()         { if (state == ARMED_SENSING) { state = ARMED_IR_FLASH; draw_gui(); } }
-// Power long-press (from SAFE -> SAFE_READY; otherwise -> SAFE)
-void handle_power_button() {
-  static bool pwr_down = false;
-  if (digitalRead(PIN_BTN_PWR) == LOW) {
-    if (!pwr_down) { pwr_down = true; t_last_pwr = millis(); }
-    if (pwr_down && (millis() - t_last_pwr >= PWR_HOLD_MS)) {
-      if (state == SAFE_STATE) state = SAFE_READY;
-      else                     state = SAFE_STATE;
-      pwr_down = false;
-      t_expended_start = 0;
-      draw_gui();
+// Shot log download: 'D' streams every record as TM_SHOT, oldest first,
+// then a TM_TEXT line with the count. The ring is refilled as fast as USB
+// drains it; the log is not flushed while a download runs.
+const uint32_t SHOT_TELEM_BYTES = 3 + 16;   // framing + type + 15-byte payload
+bool     shot_dump_active = false;
+uint32_t shot_dump_i = 0, shot_dump_n = 0;
+
+void shot_dump_service() {
+  TelemBody r;
+  ShotRecord s;
+  while (shot_dump_active) {
+    for (; shot_dump_i < shotlog_span() && telem_room() >= SHOT_TELEM_BYTES; shot_dump_i++) {
+      if (!shotlog_at(shot_dump_i, &s)) continue;
+      telem_begin(r, TM_SHOT);
+      telem_put(r, s.seq, 4); telem_put(r, s.t_ms, 4); telem_put(r, s.boot, 2);
+      telem_put(r, s.latency_us, 2); telem_put(r, s.pid, 1); telem_put(r, s.flags, 1);
+      telem_put(r, s.bit_errors, 1);
+      telem_commit(r);
+      shot_dump_n++;
     }
-  } else {
-    pwr_down = false;
+    if (shot_dump_i >= shotlog_span() && telem_room() >= TELEM_MAX_BODY + 3) {
+      char line[TELEM_MAX_BODY];
+      snprintf(line, sizeof(line), "Shot log: %lu records", (unsigned long)shot_dump_n);
+      telem_text(line);
+      shot_dump_active = false;
+    }
+    uint32_t sent = telem_tail;
+    telem_flush(Serial);
+    if (telem_tail == sent) return;   // port full: continue on the next pass
   }
 }
 
-// -------------------- FSM step --------------------
-void fsm_step() {
-  switch (state) {
-    case SAFE_STATE:
+// Core 1: flushes the batched shot records once the burst is over and the
+// unit is not armed (flash writes stall core 0).
+void shotlog_service() {
+  if (!shotlog_pending() || shot_dump_active) return;
+  if (ui.state != EXPENDED && ui.state != SAFE_STATE) return;
+  if (!shotlog_flush()) telem_text("Shot log write failed");
+}
+
+// Heap in use once the GUI went live (both setups done, glyph cache built)
+// and now. Anything but +0 means something allocated on a running path.
+uint32_t heap_mark = 0;
+
+void heap_report() {
+  int32_t grown = (int32_t)(rp2040.getUsedHeap() - heap_mark);
+  Serial.print("heap: "); Serial.print((unsigned long)rp2040.getUsedHeap());
+  Serial.print(" bytes in use, "); Serial.print(grown >= 0 ? "+" : ""); Serial.print((long)grown);
+  Serial.println(" since the GUI went live");
+}
+
+// Core 1: the TM_BOOT record, once a host is attached and the first frame
+// is out.
+void boot_report() {
+  if (boot_reported) return;
+  if (boot_usb_us == BOOT_PENDING && Serial) boot_usb_us = (uint32_t)time_us_64();
+  uint32_t armable = boot_armable_us.load(std::memory_order_relaxed);
+  if (boot_usb_us == BOOT_PENDING || armable == BOOT_PENDING || boot_frame_us == BOOT_PENDING) return;
+  TelemBody r;
+  telem_begin(r, TM_BOOT);
+  telem_put(r, armable, 4); telem_put(r, boot_frame_us, 4); telem_put(r, boot_usb_us, 4);
+  boot_reported = telem_commit(r);
+}
+
+// Core 1: 't' on Serial requests the trace histograms, 'b' the benchmark
+// results, 's' the output self-test, 'D' the shot log. They are sent
+// between records, so only once the telemetry ring is empty. A sync byte
+// starts a host command frame (GUI bridge).
+void serial_service() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (reg_rx_active) { registry_rx_byte((uint8_t)c); continue; }
+    if (telem_rx_busy(host_rx) || c == TELEM_SYNC) {
+      host_rx_ms = millis();
+      if (telem_rx_byte(host_rx, (uint8_t)c)) host_command(host_rx);
+      continue;
+    }
+    if (c == 't') trace_requested = true;
+    else if (c == 'b' && MILES_BENCH && bench_count) bench_print_requested = true;
+    else if (c == 's') scope_requested = true;
+    else if (c == 'D' && !shot_dump_active) { shot_dump_active = true; shot_dump_i = shot_dump_n = 0; }
+    else if (c == 'L') { reg_rx_active = true; reg_rx_len = 0; reg_rx_ms = millis(); }
+  }
+  if (reg_rx_active && millis() - reg_rx_ms > REGISTRY_RX_TIMEOUT_MS) {
+    reg_rx_active = false;
+    telem_text("Registry upload timed out");
+  }
+  if (telem_rx_busy(host_rx) && millis() - host_rx_ms > HOST_RX_TIMEOUT_MS) telem_rx_reset(host_rx);
+  if (!serial_idle()) return;
+  boot_report();
+  mirror_service();
+  telem_flush(Serial);
+  if (trace_requested && telem_empty()) {
+    trace_requested = false;
+    trace_dump(Serial, TRACE_SPANS, sizeof(TRACE_SPANS) / sizeof(TRACE_SPANS[0]));
+    heap_report();
+    Serial.print("events dropped: "); Serial.println((unsigned long)sched_queue.dropped());
+  }
+  if (bench_print_requested && telem_empty()) {
+    bench_print_requested = false;
+    bench_print_all(Serial, bench_results, bench_count);
+  }
+  if (scope_requested && telem_empty()) {
+    scope_requested = false;
+    scope_dump();
+  }
+  shot_dump_service();
+}
+
+// -------------------- Standby (core 1) --------------------
+bool ui_standby = false;   // core 0 asked this core to sleep
+
+void oled_power(bool on) {
+  if (!oled_dma_ok) { display.ssd1306_command(on ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF); return; }
+  const uint8_t cmd = on ? 0xAF : 0xAE;
+  while (!oled_command(&cmd, 1)) tight_loop_contents();   // waits out a running flush
+}
+
+// Switches the panel off, then deep-sleeps until core 0 posts again (the
+// UI_WAKE message). The I2C transfer must finish before the clocks stop.
+void standby_park() {
+  oled_power(false);
+  while (oled_dma_ok && !oled_idle()) tight_loop_contents();
+  power_sleep_until([] { return !ui_queue.empty(); });
+}
+
+// Drains core 0's queue: snapshots, settings commits and telemetry.
+void ui_drain() {
+  static bool state_sent = false;
+  UiMsg m;
+  TelemBody r;
+  while (ui_queue.pop(m)) {
+    switch (m.type) {
+      case UI_SNAPSHOT:
+        if (!state_sent || m.snap.state != ui.state) {
+          telem_begin(r, TM_STATE);
+          telem_put(r, m.t_us, 4); telem_put(r, m.snap.state, 1); telem_put(r, m.snap.shot_count, 4);
+          telem_commit(r);
+          state_sent = true;
+        }
+        ui = m.snap;
+        mirror_dirty = mirror_on;
+        if (!gui_cached) { gui_cache_build(); heap_mark = rp2040.getUsedHeap(); heap_sealed = true; }
+        break;
+      case UI_SAVE_SETTINGS:
+        save_settings(m.save.pid, m.save.side != 0);
+        break;
+      case UI_LOG_TX:
+        telem_begin(r, TM_TX);
+        telem_put(r, m.t_us, 4); telem_put(r, m.tx.len, 1); telem_put(r, m.tx.bits, 8);
+        telem_commit(r);
+        break;
+      case UI_LOG_ECHO:
+        telem_begin(r, TM_ECHO);
+        telem_put(r, m.t_us, 4); telem_put(r, m.echo.seen, 1);
+        telem_put(r, m.echo.bit_errors, 1); telem_put(r, m.echo.latency_us, 4);
+        telem_commit(r);
+        break;
+      case UI_LOG_RX:
+        telem_begin(r, TM_RX);
+        telem_put(r, m.t_us, 4); telem_put(r, m.rx.bits, 2);
+        telem_put(r, m.rx.pid, 1); telem_put(r, m.rx.side, 1); telem_put(r, m.rx.flags, 1);
+        telem_commit(r);
+        break;
+      case UI_LOG_SHOT:
+        shotlog_add(m.shot);
+        break;
+      case UI_LOG_TEXT:
+        telem_text(m.text);
+        break;
+      case UI_LOG_FUSE:
+        telem_begin(r, TM_FUSE);
+        telem_put(r, m.t_us, 4); telem_put(r, m.fuse.signal, 1); telem_put(r, m.fuse.r.sources, 1);
+        telem_put(r, m.fuse.r.latency_us, 4); telem_put(r, m.fuse.r.fall_ms, 2); telem_put(r, m.fuse.r.peak_mg, 2);
+        telem_commit(r);
+        break;
+      case UI_STANDBY:
+        ui_standby = true;
+        break;
+      case UI_WAKE:
+        ui_standby = false;
+        oled_power(true);
+        telem_begin(r, TM_WAKE);
+        telem_put(r, m.t_us, 4); telem_put(r, m.wake.wake_us, 4); telem_put(r, m.wake.standby_ms, 4);
+        telem_commit(r);
+        break;
+      case UI_BENCH:
+        if (bench_count < BENCH_MAX_RESULTS) bench_results[bench_count++] = m.bench;
+        break;
+      case UI_BENCH_DONE:
+        bench_due = true;
+        break;
+    }
+  }
+}
+
+// Next time the GUI would change on its own: toast / confirm expiry, the
+// next countdown second, or a retry while DMA spans are still queued.
+// Until USB shows up, also the poll that timestamps it.
+absolute_time_t ui_next_wake() {
+  unsigned long now = millis();
+  unsigned long wait = 1000;
+  if (oled_pending()) wait = 1;
+  if (ui.shot_count && now - ui.flash_ms < FLASH_TOAST_MS)
+    wait = min(wait, FLASH_TOAST_MS - (now - ui.flash_ms));
+  if (ui.confirmed && now - ui.confirmed_ms < CONFIRM_SHOW_MS)
+    wait = min(wait, CONFIRM_SHOW_MS - (now - ui.confirmed_ms));
+  if (ui.state == EXPENDED && now - ui.expended_ms < EXPENDED_MS)
+    wait = min(wait, 1000UL - (EXPENDED_MS - (now - ui.expended_ms)) % 1000UL);
+  if (settings_dirty && now - settings_changed_ms < SETTINGS_IDLE_MS)
+    wait = min(wait, SETTINGS_IDLE_MS - (now - settings_changed_ms));
+  if ((!telem_empty() || trace_requested || bench_print_requested || scope_requested || shot_dump_active) && Serial)
+    wait = min(wait, (unsigned long)TELEM_RETRY_MS);
+  if (reg_rx_active || telem_rx_busy(host_rx)) wait = 1;
+  if (boot_usb_us == BOOT_PENDING) wait = min(wait, BOOT_USB_POLL_MS);
+  if (mirror_dirty && now - mirror_sent_ms < MIRROR_MIN_MS)
+    wait = min(wait, MIRROR_MIN_MS - (now - mirror_sent_ms));
+  else if (mirror_dirty && Serial) wait = min(wait, (unsigned long)TELEM_RETRY_MS);
+  return make_timeout_time_ms(wait);
+}
+
+// Core 1: writes the coalesced settings once SAFE and idle. Skips the write
+// if the journal already holds the same values.
+void settings_service() {
+  if (!settings_dirty || ui.state != SAFE_STATE) return;
+  if (millis() - settings_changed_ms < SETTINGS_IDLE_MS) return;
+  settings_dirty = false;
+  SettingsRecord cur;
+  if (journal_latest((uint8_t *)&cur) && memcmp(&cur, &settings_pending, sizeof(cur)) == 0) return;
+  if (!journal_append((const uint8_t *)&settings_pending)) telem_text("Settings journal write failed");
+}
+
+// -------------------- Buttons / actions --------------------
+void next_protocol()       { active_index = (active_index + 1) % reg_count; frame_cache_rebuild(); ui_request_save(); }
+void toggle_side()         { active_side_opfor = !active_side_opfor; frame_cache_rebuild(); ui_request_save(); }
+bool fsm_step(Guard trigger);
+void manual_fire()         { fsm_step(G_MANUAL_FIRE); }
+void power_long_press()    { fsm_step(G_PWR_HOLD); }   // SAFE -> SAFE_READY; otherwise -> SAFE
+
+// -------------------- Events (core 0) --------------------
+enum TimerId : uint8_t {
+  TIMER_EXPENDED = 0,
+  TIMER_CONFIRM,
+  TIMER_UI_RETRY,
+  TIMER_STANDBY,
+  TIMER_RX_POLL
+};
+const uint32_t UI_RETRY_MS = 5;
+
+// -------------------- Standby (core 0) --------------------
+const uint32_t STANDBY_IDLE_MS = 60000;   // quiet time in SAFE_STATE before sleeping
+alarm_id_t standby_alarm = 0;
+bool standby_due = false;
+
+// Any event other than the standby timer itself restarts the idle timeout.
+void standby_kick() {
+  sched_cancel(standby_alarm);
+  standby_alarm = sched_after_ms(STANDBY_IDLE_MS, EV_TIMER, TIMER_STANDBY);
+  standby_due = false;
+}
+
+// Blocks until PWR is pressed. Clocks are gated only without a USB host, so
+// a connected port survives standby.
+void standby_run() {
+  UiMsg m; m.type = UI_STANDBY; m.t_us = (uint32_t)time_us_64();
+  ui_post(m);
+
+  fuse_stop();
+  input_stop();
+  alt_stop();
+  digitalWrite(LED_SAFE, LOW); digitalWrite(LED_ARMED, LOW); digitalWrite(LED_EXPENDED, LOW);
+  unsigned long slept_ms = millis();
+
+  power_arm_wake(PIN_BTN_PWR, FALLING);      // active-low button
+  power_gate_clocks(Serial);
+  power_sleep_until([] { return power_wake_us != 0; });
+  power_ungate_clocks();
+  power_disarm_wake();
+
+  input_resume();
+  alt_resume();
+  fuse_resume();
+  set_state_leds();
+  uint64_t ready_us = time_us_64();
+  trace_at(TR_WAKE_EDGE, 0, power_wake_us);
+  trace_at(TR_WAKE_READY, 0, ready_us);
+
+  m.type = UI_WAKE; m.t_us = (uint32_t)power_wake_us;
+  m.wake.wake_us = (uint32_t)(ready_us - power_wake_us);
+  m.wake.standby_ms = millis() - slept_ms;
+  ui_post(m);
+  standby_kick();
+}
+
+// -------------------- Receive (core 0) --------------------
+const uint32_t RX_POLL_MS = 10;           // while a frame group is open; the ring holds 64 ms
+bool rx_ok = false;
+alarm_id_t rx_alarm = 0;
+uint32_t hit_count = 0;                   // matched frames from other emitters
+uint32_t rx_echo_count = 0;               // frames of our own bursts
+
+enum HitFlags : uint8_t {
+  HIT_MATCHED  = 1,                       // a registry code, pid and side are valid
+  HIT_OWN      = 2,                       // inside our own burst + confirm window
+  HIT_FRIENDLY = 4                        // sent with our side's team bit
+};
+
+// -------------------- Injected inputs (core 0) --------------------
+// GUI bridge events. Buttons / limit: 1 pressed, 0 released, -1 back to the
+// pin. IN_ALT: altitude in mm, INT16_MIN back to the sensor. INJECT_ALL
+// releases everything.
+
+void inject_event(uint8_t id, int16_t v) {
+  if (id == INJECT_ALL) {
+    for (uint8_t i = 0; i < NUM_INPUTS; i++) input_release(i);
+    alt_release();
+  } else if (id < NUM_INPUTS) {
+    if (v < 0) input_release(id); else input_inject(id, v != 0);
+  } else if (id == IN_ALT) {
+    if (v == INT16_MIN) alt_release(); else alt_inject(v);
+  }
+}
+
+void on_rx_start() {                      // IRQ context
+  sched_post(EV_RX);
+}
+
+void rx_frame_seen(const RxFrame &f) {
+  UiMsg m; m.type = UI_LOG_RX; m.t_us = f.t_us;
+  m.rx.bits = f.bits; m.rx.pid = 0xFF; m.rx.side = 0xFF; m.rx.flags = 0;
+  if (f.slot != RX_NONE && f.slot / 2 < reg_count) {
+    m.rx.pid  = reg_entries[f.slot / 2].id;
+    m.rx.side = f.slot & 1;
+    m.rx.flags |= HIT_MATCHED;
+    if ((m.rx.side != 0) == active_side_opfor) m.rx.flags |= HIT_FRIENDLY;
+  }
+  bool own = shot_count && (int32_t)(f.t_us - tx_mark.t_us) >= 0 && (int32_t)(f.t_us - tx_own_until_us) <= 0;
+  if (own) { m.rx.flags |= HIT_OWN; rx_echo_count++; }
+  else if (m.rx.flags & HIT_MATCHED) hit_count++;
+  ui_post(m);
+}
+
+// Called every loop(): decodes what the DMA has captured and keeps polling
+// until the frame group has gone idle.
+void rx_service() {
+  if (!rx_ok) return;
+  rx_poll(rx_frame_seen);
+  if (rx_busy() && !rx_alarm) rx_alarm = sched_after_ms(RX_POLL_MS, EV_TIMER, TIMER_RX_POLL);
+}
+
+// The assertion that took a drop transition, for TM_FUSE.
+void post_fuse_report(FuseSignal s) {
+  UiMsg m; m.type = UI_LOG_FUSE; m.t_us = fuse_report[s].t_us;
+  m.fuse.r = fuse_report[s]; m.fuse.signal = s;
+  ui_post(m);
+}
+
+void handle_event(const Event &e) {
+  if (e.type == EV_PRESS || e.type == EV_RELEASE)
+    trace_at(e.type == EV_PRESS ? TR_PRESS : TR_RELEASE, e.arg, trace_widen_us(e.t_us));
+  if (e.type == EV_TIMER && e.arg == TIMER_STANDBY) { standby_alarm = 0; standby_due = true; return; }
+  if (e.type == EV_TIMER && e.arg == TIMER_RX_POLL) rx_alarm = 0;
+  standby_kick();
+
+  switch (e.type) {
+    case EV_PRESS:
+      switch (e.arg) {
+        case IN_NEXT: next_protocol(); break;
+        case IN_SIDE: toggle_side();   break;
+        case IN_FIRE: manual_fire();   break;
+        default:      break;           // limit / altitude: level guards re-evaluated by loop()
+      }
+      break;
+    case EV_LONG_PRESS:
+      if (e.arg == IN_PWR) power_long_press();
       break;
 
-    case SAFE_READY:
-      if (limit_switch_pressed()) { state = ARMED_FLY; draw_gui(); }
+    case EV_TX_DONE:   // the latch is taken by loop()
       break;
 
-    case ARMED_FLY:
-      if (!limit_switch_pressed()) { state = ARMED_SENSING; draw_gui(); }
+    case EV_INJECT:
+      inject_event(e.arg, e.val);
       break;
 
-    case ARMED_SENSING:
-      if (altitude_ge_3m()) { state = ARMED_IR_FLASH; draw_gui(); }
+    case EV_RELEASE:   // level guards are re-evaluated by loop()
+    case EV_RX:        // decoded by rx_service()
+    case EV_TIMER:
+    case EV_NONE:
       break;
+  }
+}
 
-    case ARMED_IR_FLASH: {
-      uint8_t bits[64]; size_t n=0;
-      build_frame_from_code(protocols[active_index].code, bits, &n);
-      apply_side_to_frame(bits, n, active_side_opfor);
-      laser_transmit_frame(bits, n);
-      state = EXPENDED;
-      t_expended_start = millis();
-      draw_gui();
-    } break;
+// -------------------- FSM step --------------------
+bool fsm_guard(Guard g, Guard trigger) {
+  switch (g) {
+    case G_LIMIT_PRESSED:    return limit_switch_pressed();
+    case G_LIMIT_RELEASED:   return drop_released();
+    case G_ALT_OK:           return drop_at_altitude();
+    case G_TX_COMPLETE:      return !tx_pending;
+    case G_EXPENDED_TIMEOUT: return millis() - t_expended_start >= EXPENDED_MS;
+    case G_MANUAL_FIRE:
+    case G_PWR_HOLD:         return trigger == g;
+    case G_NONE:             break;
+  }
+  return false;
+}
 
-    case EXPENDED:
-      if (millis() - t_expended_start >= EXPENDED_MS) { state = SAFE_STATE; draw_gui(); }
+void fsm_action(Action a) {
+  switch (a) {
+    case A_NONE:
+      break;
+    case A_FIRE:
+      if (frame_cache.stale) frame_cache_rebuild();   // only after a change raced the last burst
+      laser_transmit_frame(&frame_cache.tx, frame_cache.frames, frame_cache.count, burst_config.gap_us);
+      break;
+    case A_START_EXPENDED:
+      t_expended_start = millis();
+      sched_after_ms(EXPENDED_MS, EV_TIMER, TIMER_EXPENDED);
       break;
+    case A_DISARM:
+      t_expended_start = 0;
+      tx_retries_left = 0;      // a burst on air still finishes, nothing follows it
+      break;
+  }
+}
+
+// Takes the first matching row of FSM_TABLE. trigger is the event being
+// dispatched (G_MANUAL_FIRE / G_PWR_HOLD) or G_NONE for level guards only.
+// Returns true if a transition fired.
+bool fsm_step(Guard trigger) {
+  for (size_t i = 0; i < FSM_ROWS; i++) {
+    const Transition &t = FSM_TABLE[i];
+    if (t.from != state && t.from != ANY_STATE) continue;
+    if (fsm_guard_is_event(t.guard) && trigger != t.guard) continue;
+    if (!fsm_guard(t.guard, trigger)) continue;
+    if (fuse_ok && t.guard == G_LIMIT_RELEASED) post_fuse_report(FUSE_RELEASED);
+    if (fuse_ok && t.guard == G_ALT_OK)         post_fuse_report(FUSE_AT_ALT);
+    fsm_action(t.action);
+    state = t.to;
+    trace(TR_STATE, state);
+    return true;
   }
+  return false;
+}
+
+// -------------------- Benchmarks (MILES_BENCH builds) --------------------
+// Core 0 runs first, at the end of setup() before the inputs start, then
+// hands over to core 1. CPU paths are timed on BENCH_CLOCK(), the rest in
+// microseconds. The TX shots really go out and are checked like a normal
+// shot, so point the emitter somewhere harmless.
+const uint32_t BENCH_TX_SHOTS      = 16;
+const uint32_t BENCH_GUI_FRAMES    = 32;
+const uint32_t BENCH_JOURNAL_WRITES = 8;
+
+void bench_post(const BenchResult &r) {
+  UiMsg m; m.type = UI_BENCH; m.t_us = 0; m.bench = r;
+  while (!ui_post(m)) tight_loop_contents();   // core 1 drains meanwhile
+}
+
+// Time on air the PIO program will clock for b, in microseconds.
+uint32_t bench_air_us(const TxBuffer &b) {
+  uint64_t cyc = 0;
+  for (size_t i = 0; i < b.len; i++) cyc += (b.words[i] & TX_COUNT_MASK) + TX_LOOP_OVERHEAD;
+  return (uint32_t)(cyc / tx_cycles_per_us);
+}
+
+void bench_core0() {
+  bench_post(bench_time("frame_build", BENCH_MAX_N, [](uint32_t i) {
+    Frame f = apply_side_to_frame(build_frame_from_code(&reg_entries[i % reg_count]), i & 1);
+    bench_sink += f.bits;
+  }));
+  bench_post(bench_time("frame_encode", BENCH_MAX_N, [](uint32_t) { frame_cache_rebuild(); }));
+
+  // tx_kick: laser_transmit_frame() until the DMA runs. tx_air_err: TX
+  // start to end-of-frame IRQ against the buffer's nominal duration.
+  // tx_echo_lat: self-sense latency of confirmed shots.
+  uint32_t kick[BENCH_TX_SHOTS], err[BENCH_TX_SHOTS], echo[BENCH_TX_SHOTS];
+  uint32_t n_echo = 0;
+  uint32_t air_us = bench_air_us(frame_cache.tx);
+  Event e;
+  for (uint32_t i = 0; i < BENCH_TX_SHOTS; i++) {
+    uint32_t t0 = BENCH_CLOCK();
+    laser_transmit_frame(&frame_cache.tx, frame_cache.frames, frame_cache.count, burst_config.gap_us);
+    kick[i] = BENCH_CLOCK() - t0;
+    while (tx_pending) {       // inputs are not running yet: EV_TX_DONE is the only event
+      tight_loop_contents();
+      while (sched_pop(e)) {}
+      tx_done_latched();
+      laser_transmit_poll();
+    }
+    int32_t d = (int32_t)((uint32_t)tx_done_us - tx_mark.t_us - air_us);
+    err[i] = d < 0 ? (uint32_t)-d : (uint32_t)d;
+    if (flash_confirmed) echo[n_echo++] = flash_latency_us;
+  }
+  bench_post(bench_result("tx_kick", BENCH_CLOCK_UNIT, kick, BENCH_TX_SHOTS));
+  bench_post(bench_result("tx_air_err", "us", err, BENCH_TX_SHOTS));
+  bench_post(bench_result("tx_echo_lat", "us", echo, n_echo));
+
+  shot_count = 0;
+  flash_confirmed = false;
+  ui_request_save();           // the record core 1 appends to the journal
+  UiMsg m; m.type = UI_BENCH_DONE; m.t_us = 0;
+  while (!ui_post(m)) tight_loop_contents();
+}
+
+// Waits until every dirty span has left the I2C block.
+void bench_oled_settle() {
+  while (oled_dma_ok && (oled_pending() || !oled_idle())) { oled_flush(); tight_loop_contents(); }
+}
+
+// gui_render: a full redraw, every widget (blocking flush included without
+// OLED DMA); gui_render_font the same without the glyph cache. gui_flush:
+// all eight pages by DMA. settings_commit: one journal append of the current
+// settings (an occasional sector erase shows as max).
+void bench_gui(const char *name, uint32_t *flush) {
+  uint32_t render[BENCH_GUI_FRAMES];
+  for (uint32_t i = 0; i < BENCH_GUI_FRAMES; i++) {
+    bench_oled_settle();
+    gui_valid = false;
+    uint32_t t0 = BENCH_CLOCK();
+    draw_gui();
+    render[i] = BENCH_CLOCK() - t0;
+    uint64_t f0 = time_us_64();
+    bench_oled_settle();
+    if (flush) flush[i] = (uint32_t)(time_us_64() - f0);
+  }
+  bench_results[bench_count++] = bench_result(name, BENCH_CLOCK_UNIT, render, BENCH_GUI_FRAMES);
+}
+
+void bench_core1() {
+  uint32_t flush[BENCH_GUI_FRAMES];
+  bench_gui("gui_render", flush);
+  bench_results[bench_count++] = bench_result("gui_flush", "us", flush, BENCH_GUI_FRAMES);
+  gui_use_cache = false;
+  bench_gui("gui_render_font", nullptr);
+  gui_use_cache = true;
+
+  uint32_t w[BENCH_JOURNAL_WRITES], n = 0;
+  for (; n < BENCH_JOURNAL_WRITES; n++) {
+    uint64_t t0 = time_us_64();
+    if (!journal_append((const uint8_t *)&settings_pending)) break;
+    w[n] = (uint32_t)(time_us_64() - t0);
+  }
+  settings_dirty = false;
+  bench_results[bench_count++] = bench_result("settings_commit", "us", w, n);
+  bench_print_requested = true;
+  scope_requested = true;      // waveform of the last bench shot
 }
 
 // -------------------- Setup / Loop --------------------
+// Core 0 only waits for what arming needs; see "Boot" above.
 void setup() {
-  Serial.begin(115200);
-  while(!Serial && millis() < 1500);
-
   pinMode(PIN_OUT, OUTPUT); digitalWrite(PIN_OUT, LOW);
+  tx_ok = tx_init(PIN_OUT);
+  if (!tx_ok) ui_log("PIO/DMA transmitter init failed");
+  else {
+    if (!carrier_init(PIN_OUT, PIN_CARRIER, PIN_IR_LED, &carrier_config)) ui_log("IR carrier unavailable (emitter pin idle)");
+    if (!scope_init(PIN_OUT)) ui_log("PIO edge timer unavailable (no output self-test)");
+  }
 
   pinMode(PIN_BTN_PWR,  INPUT_PULLUP);
   pinMode(PIN_BTN_NEXT, INPUT_PULLUP);
@@ -347,41 +1718,71 @@ void setup() {
   pinMode(PIN_BTN_FIRE, INPUT_PULLUP);
 
   pinMode(PIN_LIMIT,   INPUT);     // set to INPUT_PULLUP if wired to GND
-  pinMode(PIN_ALT_OK,  INPUT);
-  pinMode(PIN_IR_SENSE,INPUT);     // IR self-sense module (adjust polarity test above)
+  pinMode(PIN_IR_SENSE,INPUT);     // IR self-sense module (adjust polarity in MILES_CAPTURE.h)
+  sense_init(PIN_IR_SENSE);
 
   pinMode(LED_SAFE, OUTPUT);
   pinMode(LED_ARMED, OUTPUT);
   pinMode(LED_EXPENDED, OUTPUT);
   set_state_leds();
 
-  eeprom_ok = EEPROM.begin(512);
-  if (!eeprom_ok) Serial.println("EEPROM init failed (settings won’t persist)");
+  load_registry();
   load_settings();
+  frame_cache_rebuild();
+  rx_ok = rx_init(PIN_IR_SENSE, BIN_US, PULSE_US, on_rx_start);
+  if (!rx_ok) ui_log("PIO IR receiver unavailable (hits are not decoded)");
+  if (MILES_BENCH) bench_core0();
 
-  Wire.setSDA(I2C_SDA); Wire.setSCL(I2C_SCL); Wire.begin();
-  if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-    Serial.println("SSD1306 init failed at 0x3C");
-  } else {
-    display.clearDisplay(); display.display();
-  }
+  if (!input_init(input_table, NUM_INPUTS)) ui_log("Input sampler timer unavailable");
+  if (!alt_init(&alt_config)) ui_log("Altitude ADC/DMA unavailable (ALT stays low)");
+  if (!imu_init(&imu_config)) ui_log("IMU missing, no free-fall check");
+  fuse_ok = fuse_init(&fusion_config);
+  if (!fuse_ok) ui_log("Fusion off: raw limit and ALT");
 
-  draw_gui();
+  ui_publish();
+  standby_kick();
+  boot_armable_us.store((uint32_t)time_us_64(), std::memory_order_relaxed);
 }
 
 void loop() {
-  handle_power_button();
+  Event e;
+  while (sched_pop(e)) handle_event(e);
 
-  if (digitalRead(PIN_BTN_NEXT) == LOW) {
-    if (millis() - t_last_next > DEBOUNCE_MS) { t_last_next = millis(); next_protocol(); }
-  }
-  if (digitalRead(PIN_BTN_SIDE) == LOW) {
-    if (millis() - t_last_side > DEBOUNCE_MS) { t_last_side = millis(); toggle_side(); }
-  }
-  if (digitalRead(PIN_BTN_FIRE) == LOW) {
-    if (millis() - t_last_fire > DEBOUNCE_MS) { t_last_fire = millis(); manual_fire(); }
+  if (tx_done_latched()) sched_after_ms(CONFIRM_WINDOW_MS, EV_TIMER, TIMER_CONFIRM);
+  laser_transmit_poll();
+  rx_service();
+  while (fsm_step(G_NONE)) {}   // settle chained transitions
+  set_state_leds();
+  if (!ui_publish()) sched_after_ms(UI_RETRY_MS, EV_TIMER, TIMER_UI_RETRY);
+
+  if (standby_due && state == SAFE_STATE && !tx_pending) standby_run();
+  standby_due = false;
+
+  sched_wait();
+}
+
+// -------------------- Setup / Loop (core 1) --------------------
+// Runs alongside setup(). The panel powers up with random RAM; the first
+// draw_gui() marks every page dirty, so no blocking clear is sent here.
+void setup1() {
+  Serial.begin(115200);
+  Wire.setSDA(I2C_SDA); Wire.setSCL(I2C_SCL); Wire.begin();
+  if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+    telem_text("SSD1306 init failed at 0x3C");
+  } else {
+    oled_dma_ok = oled_dma_init(i2c0, 0x3C, display.getBuffer());
+    if (!oled_dma_ok) telem_text("OLED DMA unavailable, using blocking flush");
   }
+  if (!shotlog_init()) telem_text("Shot log region missing (shots won't persist)");
+}
 
-  fsm_step();
-  delay(5);
+void loop1() {
+  ui_drain();
+  if (ui_standby) { standby_park(); return; }
+  if (MILES_BENCH && bench_due) { bench_due = false; bench_core1(); }
+  draw_gui();   // no-op unless a widget changed; flush runs in the background
+  settings_service();
+  shotlog_service();
+  serial_service();
+  best_effort_wfe_or_timeout(ui_next_wake());
 }
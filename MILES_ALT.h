@@ -0,0 +1,137 @@
+#ifndef MILES_ALT_H
+#define MILES_ALT_H
+
+/*
+  Sampled analog altitude with a latched threshold flag.
+
+  The ADC free-runs on one channel at ALT_ADC_HZ and a DMA channel streams
+  the conversions into a 16-sample ring, so no CPU time goes to reading the
+  sensor. A repeating timer then averages the ring once per period, runs a
+  fixed-point IIR low-pass and applies hysteresis around the threshold. The
+  flag only changes on a hysteresis crossing. Each crossing posts
+  EV_PRESS / EV_RELEASE (arg = the configured id), so the FSM reacts within
+  one filter period and alt_above() is a plain load.
+
+  Written for an analog range sensor (ultrasonic or laser rangefinder,
+  linear volts-per-distance output). The filter is first order with
+  tau = period * 2^iir_shift.
+
+  alt_inject() replaces the ADC reading with a fixed altitude (Serial GUI
+  bridge); the filter and hysteresis still apply.
+*/
+
+#include <Arduino.h>
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "MILES_SCHED.h"
+
+typedef struct {
+  uint8_t  adc_pin;         // GP26..GP29
+  uint32_t um_per_count;    // sensor scale: micrometers per 12-bit ADC count
+  int32_t  offset_mm;       // added after scaling (mounting height, sensor zero)
+  int32_t  threshold_mm;
+  int32_t  hysteresis_mm;   // flag sets at threshold + h, clears at threshold - h
+  uint32_t period_us;       // filter / decision rate
+  uint8_t  iir_shift;       // y += (x - y) >> iir_shift
+  uint8_t  event_id;        // arg of the posted EV_PRESS / EV_RELEASE
+} AltConfig;
+
+const uint32_t ALT_RING       = 16;        // samples, power of two
+const uint32_t ALT_ADC_HZ     = 16000;
+const uint8_t  ALT_FRAC_BITS  = 4;         // filter state is mm in Q4
+
+static const AltConfig *alt_cfg = nullptr;
+static uint16_t alt_ring[ALT_RING] __attribute__((aligned(ALT_RING * sizeof(uint16_t))));
+static int alt_dma = -1;
+static struct repeating_timer alt_timer;
+static volatile int32_t alt_q4 = 0;         // filtered altitude, mm << ALT_FRAC_BITS
+static volatile int32_t alt_rate = 0;       // filtered climb rate, mm/s
+static volatile bool    alt_flag = false;
+static bool alt_seeded = false;
+const int32_t ALT_NOT_INJECTED = INT32_MIN;
+static volatile int32_t alt_injected = ALT_NOT_INJECTED;   // mm, written by the core 0 thread
+
+static void alt_dma_start() {
+  dma_channel_config c = dma_channel_get_default_config(alt_dma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, true);
+  channel_config_set_ring(&c, true, 5);    // wrap the write address every 32 bytes
+  channel_config_set_dreq(&c, DREQ_ADC);
+  dma_channel_configure(alt_dma, &c, alt_ring, &adc_hw->fifo, 0xFFFFFFFFu, true);
+}
+
+static int32_t alt_raw_mm() {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < ALT_RING; i++) sum += alt_ring[i] & 0x0FFF;
+  return (int32_t)((uint64_t)sum * alt_cfg->um_per_count / (1000u * ALT_RING)) + alt_cfg->offset_mm;
+}
+
+static bool alt_tick(struct repeating_timer *) {
+  const AltConfig &c = *alt_cfg;
+  if (!dma_channel_is_busy(alt_dma)) alt_dma_start();   // count ran out (~3 days at 16 kHz)
+
+  int32_t inj = alt_injected;
+  int32_t x = (inj != ALT_NOT_INJECTED ? inj : alt_raw_mm()) * (1 << ALT_FRAC_BITS);   // may be below zero: no <<
+  int32_t prev = alt_q4;
+  int32_t y = alt_seeded ? prev + ((x - prev) >> c.iir_shift) : x;
+  alt_seeded = true;
+  alt_q4 = y;
+
+  int32_t inst = (int32_t)((int64_t)(y - prev) * 1000000 / (int32_t)c.period_us) >> ALT_FRAC_BITS;
+  alt_rate = alt_rate + ((inst - alt_rate) >> c.iir_shift);
+
+  int32_t mm = y >> ALT_FRAC_BITS;
+  if (!alt_flag && mm >= c.threshold_mm + c.hysteresis_mm) {
+    alt_flag = true;
+    sched_post(EV_PRESS, c.event_id);
+  } else if (alt_flag && mm < c.threshold_mm - c.hysteresis_mm) {
+    alt_flag = false;
+    sched_post(EV_RELEASE, c.event_id);
+  }
+  return true;
+}
+
+// cfg must outlive the subsystem. Starts clear; the first period seeds the
+// filter with the raw reading so there is no ramp from zero.
+static bool alt_init(const AltConfig *cfg) {
+  if (cfg->adc_pin < 26 || cfg->adc_pin > 29) return false;
+  alt_cfg = cfg;
+  alt_dma = dma_claim_unused_channel(false);
+  if (alt_dma < 0) return false;
+
+  adc_init();
+  adc_gpio_init(cfg->adc_pin);
+  adc_select_input(cfg->adc_pin - 26);
+  adc_fifo_setup(true, true, 1, false, false);   // FIFO on, DREQ at 1 sample, no error bit, 16-bit
+  adc_set_clkdiv(48000000.0f / ALT_ADC_HZ - 1.0f);
+  alt_dma_start();
+  adc_run(true);
+  return add_repeating_timer_us(-(int64_t)cfg->period_us, alt_tick, nullptr, &alt_timer);
+}
+
+// Standby: stops the timer, ADC and DMA. alt_resume() reseeds the filter
+// from the first new reading; the flag keeps its last value until then.
+static void alt_stop() {
+  if (alt_dma < 0) return;
+  cancel_repeating_timer(&alt_timer);
+  adc_run(false);
+  dma_channel_abort(alt_dma);
+  adc_fifo_drain();
+}
+
+static bool alt_resume() {
+  if (alt_dma < 0) return false;
+  alt_seeded = false;
+  alt_dma_start();
+  adc_run(true);
+  return add_repeating_timer_us(-(int64_t)alt_cfg->period_us, alt_tick, nullptr, &alt_timer);
+}
+
+static inline void    alt_inject(int32_t mm) { alt_injected = mm; }
+static inline void    alt_release()  { alt_injected = ALT_NOT_INJECTED; }
+static inline bool    alt_above()    { return alt_flag; }
+static inline int32_t alt_mm()       { return alt_q4 >> ALT_FRAC_BITS; }
+static inline int32_t alt_rate_mms() { return alt_rate; }
+
+#endif // MILES_ALT_H
@@ -0,0 +1,83 @@
+#ifndef MILES_BENCH_H
+#define MILES_BENCH_H
+
+/*
+  Microbenchmarks for the hot paths (benchmark build: MILES_BENCH = 1).
+
+  bench_time() calls a function n times and keeps each call's duration on
+  BENCH_CLOCK(), which is the cycle counter on the RP2040. The host bench
+  overrides it with a nanosecond wall clock. Paths that have to be measured
+  from outside (flash writes, DMA flushes, time on air) are sampled by the
+  caller in microseconds and reduced with bench_result().
+
+  bench_print() writes one JSON object per line:
+    {"bench":"frame_build","unit":"cyc","n":64,"min":..,"p50":..,"p99":..,"max":..}
+  MILES_BENCH.py extracts these lines from a capture and compares two builds.
+*/
+
+#include <Arduino.h>
+#include "MILES_TRACE.h"   // trace_sort()
+
+#ifndef BENCH_CLOCK
+#define BENCH_CLOCK()    rp2040.getCycleCount()
+#define BENCH_CLOCK_UNIT "cyc"
+#endif
+
+const uint32_t BENCH_MAX_N = 64;           // samples per benchmark
+
+typedef struct {
+  const char *name;                        // string literal
+  const char *unit;
+  uint32_t n;
+  uint32_t min, p50, p99, max;
+} BenchResult;
+
+// Sorts v[0..n) in place. n == 0 gives an empty result.
+static BenchResult bench_result(const char *name, const char *unit, uint32_t *v, uint32_t n) {
+  BenchResult r = { name, unit, n, 0, 0, 0, 0 };
+  if (n == 0) return r;
+  trace_sort(v, n);
+  r.min = v[0];
+  r.p50 = v[(n - 1) / 2];
+  r.p99 = v[(n - 1) * 99 / 100];
+  r.max = v[n - 1];
+  return r;
+}
+
+template <typename Fn>
+static BenchResult bench_time(const char *name, uint32_t n, Fn fn) {
+  uint32_t v[BENCH_MAX_N];
+  if (n > BENCH_MAX_N) n = BENCH_MAX_N;
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t t0 = BENCH_CLOCK();
+    fn(i);
+    v[i] = BENCH_CLOCK() - t0;
+  }
+  return bench_result(name, BENCH_CLOCK_UNIT, v, n);
+}
+
+// Stores a result so the optimizer keeps the computation that produced it.
+static volatile uint64_t bench_sink = 0;
+
+template <typename Out>
+static void bench_print(Out &out, const BenchResult &r) {
+  out.print("{\"bench\":\""); out.print(r.name);
+  out.print("\",\"unit\":\""); out.print(r.unit);
+  out.print("\",\"n\":"); out.print(r.n);
+  if (r.n) {
+    out.print(",\"min\":"); out.print(r.min);
+    out.print(",\"p50\":"); out.print(r.p50);
+    out.print(",\"p99\":"); out.print(r.p99);
+    out.print(",\"max\":"); out.print(r.max);
+  }
+  out.println("}");
+}
+
+// Build stamp first, so results from different images can be told apart.
+template <typename Out>
+static void bench_print_all(Out &out, const BenchResult *r, size_t n) {
+  out.print("{\"bench_build\":\""); out.print(__DATE__ " " __TIME__); out.println("\"}");
+  for (size_t i = 0; i < n; i++) bench_print(out, r[i]);
+}
+
+#endif // MILES_BENCH_H
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# Benchmark results of a MILES_BENCH build (see MILES_BENCH.h).
+#
+# Usage:
+#   python3 MILES_BENCH.py capture.bin                    # print the results
+#   python3 MILES_BENCH.py capture.bin -o new.json        # keep them as JSON lines
+#   python3 MILES_BENCH.py new.json --base old.json       # compare against an older build
+#
+# Input is a raw capture of the port (cat /dev/ttyACM0 > capture.bin, then
+# send 'b' to print the results again), MILES_TELEM.py output, the host
+# bench's stdout or a saved file. With --base, the exit status is 1 if any
+# p50 grew by more than --limit percent (default 10).
+
+import argparse
+import json
+import sys
+
+from MILES_TELEM import Decoder, open_source
+
+
+def read_results(path):
+    """Last result per benchmark name, in first-seen order, plus the build stamp."""
+    src = open_source(path)
+    dec = Decoder()
+    text = []
+    while True:
+        data = src.read(4096)
+        if not data: break
+        text += [item for kind, item in dec.feed(data) if kind == "text"]
+    results, build = {}, None
+    for line in "".join(text).splitlines():
+        line = line.strip()
+        if not line.startswith('{"bench'): continue
+        try:
+            obj = json.loads(line)
+        except ValueError:
+            continue   # cut off mid-line
+        if "bench_build" in obj: build = obj["bench_build"]
+        elif "bench" in obj: results[obj["bench"]] = obj
+    return results, build
+
+
+def fmt(r):
+    if not r.get("n"): return f"{'-':>10} {'-':>10} {'-':>10} {'-':>10}"
+    return " ".join(f"{r[k]:>10}" for k in ("min", "p50", "p99", "max"))
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("input")
+    ap.add_argument("-o", "--out", help="write the results as JSON lines")
+    ap.add_argument("--base", help="results of the build to compare against")
+    ap.add_argument("--limit", type=float, default=10.0, help="allowed p50 growth in percent")
+    args = ap.parse_args()
+
+    cur, build = read_results(args.input)
+    if not cur:
+        print(f"no benchmark results in {args.input}", file=sys.stderr)
+        return 2
+    if args.out:
+        with open(args.out, "w") as f:
+            if build: f.write(json.dumps({"bench_build": build}) + "\n")
+            for r in cur.values(): f.write(json.dumps(r) + "\n")
+
+    base = read_results(args.base)[0] if args.base else {}
+    print(f"build {build or '?'}")
+    print(f"{'bench':<16} {'unit':<4} {'n':>4} {'min':>10} {'p50':>10} {'p99':>10} {'max':>10}" + ("  vs base p50" if base else ""))
+    worse = []
+    for name, r in cur.items():
+        line = f"{name:<16} {r['unit']:<4} {r['n']:>4} {fmt(r)}"
+        b = base.get(name)
+        if b and b.get("n") and r.get("n") and b["unit"] == r["unit"]:
+            pct = (r["p50"] - b["p50"]) * 100.0 / b["p50"] if b["p50"] else (0.0 if r["p50"] == 0 else float("inf"))
+            line += f"  {pct:+7.1f}%"
+            if pct > args.limit and r["p50"] > b["p50"] + 1:   # one-count steps are timer resolution
+                line += "  REGRESSION"
+                worse.append(name)
+        elif base:
+            line += "  (no baseline)"
+        print(line)
+    if worse:
+        print(f"{len(worse)} regression(s) over {args.limit:g}%: {', '.join(worse)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
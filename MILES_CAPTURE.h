@@ -0,0 +1,123 @@
+#ifndef MILES_CAPTURE_H
+#define MILES_CAPTURE_H
+
+/*
+  IR self-sense capture.
+
+  A CHANGE interrupt on the sense pin timestamps every edge into a ring
+  buffer while the PIO transmitter runs. After the burst, sense_check()
+  replays the edges from the TX start mark against the sent frame and
+  reports whether the echo was seen, its latency and the bit error count.
+  Nothing polls the pin.
+
+  Polarity: HIGH = receiver asserted (envelope detect), same as before.
+*/
+
+#include <Arduino.h>
+
+typedef struct {
+  uint32_t t_us;
+  uint8_t  level;
+} SenseEdge;
+
+const uint32_t SENSE_RING_SIZE = 128;       // power of two; a frame is <= 2 edges per bit, a burst several frames
+const uint32_t SENSE_RING_MASK = SENSE_RING_SIZE - 1;
+
+static volatile SenseEdge sense_ring[SENSE_RING_SIZE];
+static volatile uint32_t sense_head = 0;    // total edges captured (free-running)
+static uint8_t sense_pin = 0;
+
+typedef struct {
+  bool     seen;         // any asserted level after the mark
+  uint32_t latency_us;   // first rising edge vs. the first '1' bin of the sent frame
+  uint8_t  bit_errors;   // bins whose sampled level disagrees with the sent bit
+} SenseResult;
+
+typedef struct {
+  uint32_t index;        // sense_head at TX start
+  uint32_t t_us;         // TX start timestamp
+  uint8_t  level;        // pin level at TX start
+} SenseMark;
+
+static void sense_isr() {
+  uint32_t h = sense_head;
+  sense_ring[h & SENSE_RING_MASK].t_us  = (uint32_t)time_us_64();
+  sense_ring[h & SENSE_RING_MASK].level = (uint8_t)digitalRead(sense_pin);
+  sense_head = h + 1;
+}
+
+static void sense_init(uint8_t pin) {
+  sense_pin = pin;
+  attachInterrupt(digitalPinToInterrupt(pin), sense_isr, CHANGE);
+}
+
+// Snapshot to take right before starting a transmission.
+static SenseMark sense_mark(uint64_t tx_start_us) {
+  SenseMark m;
+  m.index = sense_head;
+  m.t_us  = (uint32_t)tx_start_us;
+  m.level = (uint8_t)digitalRead(sense_pin);
+  return m;
+}
+
+// Level of the sense pin at time t, reconstructed from the edges after the mark.
+static uint8_t sense_level_at(const SenseMark *m, uint32_t head, uint32_t t) {
+  uint8_t level = m->level;
+  for (uint32_t i = m->index; i != head; i++) {
+    const volatile SenseEdge &e = sense_ring[i & SENSE_RING_MASK];
+    if ((int32_t)(e.t_us - t) > 0) break;
+    level = e.level;
+  }
+  return level;
+}
+
+// Re-bases a mark to a later time t in the same capture, e.g. the start of
+// the next frame of a burst.
+static SenseMark sense_mark_at(const SenseMark *m, uint32_t t) {
+  SenseMark r = *m;
+  uint32_t head = sense_head;
+  if (head - r.index > SENSE_RING_SIZE) r.index = head - SENSE_RING_SIZE;
+  r.level = sense_level_at(&r, head, t);
+  while (r.index != head && (int32_t)(sense_ring[r.index & SENSE_RING_MASK].t_us - t) <= 0) r.index++;
+  r.t_us = t;
+  return r;
+}
+
+// Compares the captured echo against the sent frame (packed, bit i = bin i).
+// lead_us is the idle time the transmitter emits before bin 0. Edges at or
+// after end_us belong to whatever came next (the next frame of a burst) and
+// are ignored, so a lost echo is not matched against a later frame.
+static SenseResult sense_check(const SenseMark *m, uint64_t bits, size_t n,
+                               uint32_t bin_us, uint32_t pulse_us, uint32_t lead_us, uint32_t end_us) {
+  SenseResult r = { false, 0, 0 };
+  SenseMark from = *m;
+  uint32_t head = sense_head;
+  if (head - from.index > SENSE_RING_SIZE) from.index = head - SENSE_RING_SIZE;   // overrun: keep newest
+  for (uint32_t i = from.index; i != head; i++)
+    if ((int32_t)(sense_ring[i & SENSE_RING_MASK].t_us - end_us) >= 0) { head = i; break; }
+
+  uint32_t first_rise = 0;
+  for (uint32_t i = from.index; i != head; i++) {
+    if (sense_ring[i & SENSE_RING_MASK].level) { first_rise = sense_ring[i & SENSE_RING_MASK].t_us; r.seen = true; break; }
+  }
+  if (!r.seen) {
+    r.seen = from.level != 0;   // stuck asserted: every '0' bin is an error
+    for (size_t i = 0; i < n; i++) if (((bits >> i) & 1) != (from.level ? 1u : 0u)) r.bit_errors++;
+    return r;
+  }
+
+  size_t first_one = 0;
+  while (first_one < n && !((bits >> first_one) & 1)) first_one++;
+  uint32_t expected = from.t_us + lead_us + (uint32_t)first_one * bin_us;
+  r.latency_us = (int32_t)(first_rise - expected) > 0 ? first_rise - expected : 0;
+
+  // Sample the middle of each pulse slot, shifted by the measured latency.
+  uint32_t t0 = from.t_us + lead_us + r.latency_us + pulse_us / 2;
+  for (size_t i = 0; i < n; i++) {
+    uint8_t rx = sense_level_at(&from, head, t0 + (uint32_t)i * bin_us) ? 1 : 0;
+    if (rx != ((bits >> i) & 1)) r.bit_errors++;
+  }
+  return r;
+}
+
+#endif // MILES_CAPTURE_H
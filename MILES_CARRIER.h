@@ -0,0 +1,95 @@
+#ifndef MILES_CARRIER_H
+#define MILES_CARRIER_H
+
+/*
+  IR carrier: a PWM slice makes the carrier, a PIO state machine gates it
+  with the TX envelope. Nothing runs on the CPU while a burst is on air.
+
+  The slice free-runs on a spare pin at the configured frequency and duty;
+  nothing needs to be connected to that pin. A four-instruction program on
+  the TX block drives the emitter pin. While the envelope pin (PIN_OUT, the
+  TX state machine's output) reads high, it copies the carrier pin every
+  two cycles; otherwise it holds the emitter low. PIO inputs see every pad,
+  so there are no jumpers. Each edge follows within 5 cycles (input
+  synchronizer plus one loop pass), the same delay for every edge.
+
+  The carrier is not phase-locked to the envelope. A pulse starts wherever
+  the carrier is, so its first and last carrier periods may be partial.
+  With hz = 0 the carrier pin is held high and the emitter pin is a copy
+  of the envelope, for baseband drivers.
+*/
+
+#include <Arduino.h>
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "MILES_TX.h"
+
+typedef struct {
+  uint32_t hz;          // 0 = no carrier, the emitter follows the envelope
+  uint8_t  duty_pct;    // carrier high time, 1..99
+} CarrierConfig;
+
+// -------------------- PIO program --------------------
+//   0: jmp pin 3        ; envelope high? (wrap target)
+//   1: mov pins, null   ; emitter low
+//   2: jmp 0
+//   3: mov pins, pins   ; emitter = carrier (wrap)
+static const uint16_t miles_carrier_program_instructions[] = {
+  0x00c3, 0xa003, 0x0000, 0xa000
+};
+static const pio_program_t miles_carrier_program = {
+  miles_carrier_program_instructions,
+  sizeof(miles_carrier_program_instructions) / sizeof(miles_carrier_program_instructions[0]),
+  -1
+};
+const uint32_t CARRIER_DELAY_CYCLES = 5;   // worst-case edge delay behind either input
+
+static int      carrier_sm = -1;
+static uint32_t carrier_hz = 0;            // achieved frequency, 0 = baseband
+
+// Starts the carrier and the gate. The emitter pin is low until the first
+// burst. Returns false if the frequency cannot be made or no state machine
+// is free; the emitter pin then stays unclaimed.
+static bool carrier_init(uint8_t env_pin, uint8_t carrier_pin, uint8_t led_pin, const CarrierConfig *cfg) {
+  uint32_t sys = clock_get_hz(clk_sys);
+  uint32_t div = cfg->hz ? sys / cfg->hz / 65536 + 1 : 1;   // integer divider, wrap fits 16 bits
+  if (cfg->hz && (cfg->hz > sys / 2 || div > 255 || cfg->duty_pct < 1 || cfg->duty_pct > 99)) return false;
+  if (!pio_can_add_program(tx_pio, &miles_carrier_program)) return false;
+  carrier_sm = pio_claim_unused_sm(tx_pio, false);
+  if (carrier_sm < 0) return false;
+  uint offset = pio_add_program(tx_pio, &miles_carrier_program);
+
+  if (cfg->hz) {
+    uint32_t top = sys / div / cfg->hz - 1;
+    uint slice = pwm_gpio_to_slice_num(carrier_pin);
+    pwm_config p = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&p, div);
+    pwm_config_set_wrap(&p, (uint16_t)top);
+    pwm_init(slice, &p, false);
+    pwm_set_chan_level(slice, pwm_gpio_to_channel(carrier_pin), (uint16_t)((top + 1) * cfg->duty_pct / 100));
+    gpio_set_function(carrier_pin, GPIO_FUNC_PWM);
+    pwm_set_enabled(slice, true);
+    carrier_hz = sys / div / (top + 1);
+  } else {
+    pinMode(carrier_pin, OUTPUT);
+    digitalWrite(carrier_pin, HIGH);
+    carrier_hz = 0;
+  }
+
+  pio_gpio_init(tx_pio, led_pin);
+  pio_sm_set_pins_with_mask(tx_pio, carrier_sm, 0, 1u << led_pin);
+  pio_sm_set_consecutive_pindirs(tx_pio, carrier_sm, led_pin, 1, true);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, offset, offset + miles_carrier_program.length - 1);
+  sm_config_set_jmp_pin(&c, env_pin);
+  sm_config_set_in_pins(&c, carrier_pin);
+  sm_config_set_out_pins(&c, led_pin, 1);
+  sm_config_set_clkdiv(&c, 1.0f);
+  pio_sm_init(tx_pio, carrier_sm, offset, &c);
+  pio_sm_set_enabled(tx_pio, carrier_sm, true);
+  return true;
+}
+
+#endif // MILES_CARRIER_H
@@ -3,35 +3,56 @@
 
 #include <cstdint>
 
+const unsigned MILES_FRAME_BITS = 11;   // standard 11-bit MILES word; bin 0 is sent first
+const unsigned MILES_MAX_BITS   = 64;   // longest word (MILES 2000 style words, preambles)
+
+// Packs a bin list into a word at compile time: bit i of the result = bin i.
+// The word length is the length of the list.
+template <unsigned N>
+constexpr uint64_t miles_pack(const uint8_t (&bins)[N], unsigned i = 0) {
+    static_assert(N >= 1 && N <= MILES_MAX_BITS, "MILES word length out of range");
+    return i == N ? 0
+         : ((bins[i] ? (1ull << i) : 0ull) | miles_pack(bins, i + 1));
+}
+
 struct MILES_Code {
     const char* description;
-    uint8_t pattern[11]; // 11-bit MILES word; index 0..10
+    uint64_t pattern;   // packed with miles_pack()
+    uint8_t bits;       // word length
 };
 
+template <unsigned N>
+constexpr MILES_Code miles_code(const char* description, const uint8_t (&bins)[N]) {
+    return { description, miles_pack(bins), (uint8_t)N };
+}
+
 // ---- Example codes (replace with your real ones) ----
-const MILES_Code PLAYER_UNIVERSAL_KILL = {
+constexpr MILES_Code PLAYER_UNIVERSAL_KILL = miles_code(
     "Universal Kill",
     {1, 1, 0, 0, 0, 1, 0, 1, 1, 0, 1}
-};
+);
 
-const MILES_Code PLAYER_ID_001 = {
+constexpr MILES_Code PLAYER_ID_001 = miles_code(
     "Player ID 001",
     {1, 0, 0, 1, 0, 0, 1, 1, 0, 1, 0}
-};
+);
 
-const MILES_Code PLAYER_ID_002 = {
+constexpr MILES_Code PLAYER_ID_002 = miles_code(
     "Player ID 002",
     {1, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0}
-};
+);
 
-const MILES_Code EVENT_PAUSE = {
+constexpr MILES_Code EVENT_PAUSE = miles_code(
     "Pause / Reset",
     {1, 1, 0, 0, 0, 1, 0, 1, 0, 1, 1}
-};
+);
 
-const MILES_Code EVENT_END_EXERCISE = {
+constexpr MILES_Code EVENT_END_EXERCISE = miles_code(
     "End Exercise",
     {1, 1, 0, 0, 0, 1, 1, 1, 1, 1, 0}
-};
+);
+
+static_assert(PLAYER_UNIVERSAL_KILL.pattern == 0x5a3, "miles_pack bit order");
+static_assert(PLAYER_UNIVERSAL_KILL.bits == MILES_FRAME_BITS, "miles_code length");
 
 #endif // MILES_CODES_H
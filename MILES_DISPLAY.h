@@ -0,0 +1,213 @@
+#ifndef MILES_DISPLAY_H
+#define MILES_DISPLAY_H
+
+/*
+  Dirty-page SSD1306 flush over DMA I2C.
+
+  Adafruit_SSD1306 is still used to bring the panel up and to rasterize into
+  its RAM framebuffer, but display.display() (a blocking 1 KB I2C push) is no
+  longer called after setup. Callers mark the rectangles they redraw; the
+  flush turns them into per-page column spans, packs only those spans into an
+  I2C DATA_CMD word buffer and lets DMA feed the I2C TX FIFO in the
+  background. The framebuffer is copied at kick time, so it can be redrawn
+  while a transfer is still on the bus.
+
+  Text is rasterized once. The static labels are drawn into oled_bg at
+  startup, and each value a widget can show (state names, protocol names,
+  ...) is kept as a glyph strip: the page bytes of its bounding box, taken
+  from the framebuffer it was drawn into. A redraw restores the widget's
+  rect from oled_bg and ORs the strip in at the same pages.
+*/
+
+#include <Arduino.h>
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+
+typedef struct {
+  int16_t x, y, w, h;
+} Rect;
+
+const uint8_t OLED_W     = 128;
+const uint8_t OLED_PAGES = 8;
+
+// Per transaction: control byte + 6 command bytes, then control byte + data
+const size_t OLED_DMA_WORDS = OLED_PAGES * (7 + 1 + OLED_W);
+
+static i2c_inst_t *oled_i2c = nullptr;
+static int oled_dma = -1;
+static const uint8_t *oled_fb = nullptr;
+static uint8_t oled_col_lo[OLED_PAGES];
+static uint8_t oled_col_hi[OLED_PAGES];
+static uint16_t oled_words[OLED_DMA_WORDS];
+
+// -------------------- Static background and glyph strips --------------------
+const size_t OLED_FB_BYTES    = OLED_W * OLED_PAGES;
+const size_t OLED_STRIP_POOL  = 12288;     // bytes for all strips; the rest fall back to the font
+
+typedef struct {
+  uint8_t  x, w, page, pages;              // bounding box, in columns and pages
+  uint16_t off;                            // into oled_strip_pool, pages * w bytes
+} GlyphStrip;
+
+static uint8_t oled_bg[OLED_FB_BYTES];
+static uint8_t oled_strip_pool[OLED_STRIP_POOL];
+static size_t  oled_strip_used = 0;
+
+// Keeps the set pixels of fb (drawn into a cleared buffer) as a strip. An
+// empty buffer gives an empty strip. Returns false when the pool is full.
+static bool oled_strip_capture(const uint8_t *fb, GlyphStrip *s) {
+  int x0 = OLED_W, x1 = -1, p0 = OLED_PAGES, p1 = -1;
+  for (int p = 0; p < OLED_PAGES; p++) {
+    for (int x = 0; x < OLED_W; x++) {
+      if (!fb[p * OLED_W + x]) continue;
+      if (x < x0) x0 = x;
+      if (x > x1) x1 = x;
+      if (p < p0) p0 = p;
+      p1 = p;
+    }
+  }
+  *s = GlyphStrip{ 0, 0, 0, 0, 0 };
+  if (x1 < 0) return true;
+  size_t w = x1 - x0 + 1, n = (p1 - p0 + 1) * w;
+  if (oled_strip_used + n > OLED_STRIP_POOL) return false;
+  *s = GlyphStrip{ (uint8_t)x0, (uint8_t)w, (uint8_t)p0, (uint8_t)(p1 - p0 + 1), (uint16_t)oled_strip_used };
+  for (int p = p0; p <= p1; p++)
+    memcpy(&oled_strip_pool[oled_strip_used + (p - p0) * w], &fb[p * OLED_W + x0], w);
+  oled_strip_used += n;
+  return true;
+}
+
+static void oled_strip_blit(uint8_t *fb, const GlyphStrip &s) {
+  const uint8_t *src = &oled_strip_pool[s.off];
+  for (uint8_t p = 0; p < s.pages; p++) {
+    uint8_t *dst = &fb[(s.page + p) * OLED_W + s.x];
+    for (uint8_t i = 0; i < s.w; i++) dst[i] |= *src++;
+  }
+}
+
+// Same pixels as fillRect(r, BLACK) followed by the static labels inside r.
+static void oled_bg_restore(uint8_t *fb, const Rect &r) {
+  int x0 = r.x < 0 ? 0 : r.x, x1 = r.x + r.w;
+  int y0 = r.y < 0 ? 0 : r.y, y1 = r.y + r.h;
+  if (x1 > OLED_W) x1 = OLED_W;
+  if (y1 > OLED_PAGES * 8) y1 = OLED_PAGES * 8;
+  for (int p = y0 / 8; p * 8 < y1; p++) {
+    int lo = y0 > p * 8 ? y0 - p * 8 : 0, hi = y1 < p * 8 + 8 ? y1 - p * 8 : 8;
+    uint8_t m = (uint8_t)((0xFFu << lo) & (0xFFu >> (8 - hi)));
+    for (int x = x0; x < x1; x++) {
+      uint8_t &b = fb[p * OLED_W + x];
+      b = (uint8_t)((b & ~m) | (oled_bg[p * OLED_W + x] & m));
+    }
+  }
+}
+
+static inline bool rect_overlap(const Rect &a, const Rect &b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// Grows a widget dirty mask until no clean widget overlaps a dirty one, so
+// clearing and redrawing every widget in the mask cannot clip a neighbour.
+static uint32_t oled_close_dirty(uint32_t mask, const Rect *rects, size_t n) {
+  bool grew = true;
+  while (grew) {
+    grew = false;
+    for (size_t i = 0; i < n; i++) {
+      if (mask & (1u << i)) continue;
+      for (size_t j = 0; j < n; j++) {
+        if ((mask & (1u << j)) && rect_overlap(rects[i], rects[j])) { mask |= 1u << i; grew = true; break; }
+      }
+    }
+  }
+  return mask;
+}
+
+static void oled_mark_dirty(const Rect &r) {
+  int x0 = r.x < 0 ? 0 : r.x, x1 = r.x + r.w - 1;
+  int y0 = r.y < 0 ? 0 : r.y, y1 = r.y + r.h - 1;
+  if (x1 >= OLED_W) x1 = OLED_W - 1;
+  if (y1 >= OLED_PAGES * 8) y1 = OLED_PAGES * 8 - 1;
+  if (x1 < x0 || y1 < y0) return;
+  for (int p = y0 / 8; p <= y1 / 8; p++) {
+    bool empty = oled_col_lo[p] > oled_col_hi[p];
+    if (empty || x0 < oled_col_lo[p]) oled_col_lo[p] = x0;
+    if (empty || x1 > oled_col_hi[p]) oled_col_hi[p] = x1;
+  }
+}
+
+static void oled_clear_dirty() {
+  for (uint8_t p = 0; p < OLED_PAGES; p++) { oled_col_lo[p] = OLED_W; oled_col_hi[p] = 0; }   // lo > hi = clean
+}
+
+// Takes over the I2C block after display.begin(); fb is display.getBuffer().
+static bool oled_dma_init(i2c_inst_t *i2c, uint8_t addr, const uint8_t *fb) {
+  oled_dma = dma_claim_unused_channel(false);
+  if (oled_dma < 0 || fb == nullptr) return false;
+  oled_i2c = i2c;
+  oled_fb = fb;
+  oled_clear_dirty();
+
+  i2c_hw_t *hw = i2c_get_hw(i2c);
+  hw->enable = 0;
+  hw->tar = addr;
+  hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+  hw->enable = 1;
+
+  dma_channel_config c = dma_channel_get_default_config(oled_dma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+  dma_channel_configure(oled_dma, &c, &hw->data_cmd, oled_words, 0, false);
+  return true;
+}
+
+static bool oled_busy() {
+  return oled_dma >= 0 && dma_channel_is_busy(oled_dma);
+}
+
+// True while marked spans are still waiting for a flush.
+static bool oled_pending() {
+  for (uint8_t p = 0; p < OLED_PAGES; p++) if (oled_col_lo[p] <= oled_col_hi[p]) return true;
+  return false;
+}
+
+// True once the last transfer has left the I2C block (not just the DMA).
+static bool oled_idle() {
+  return !oled_busy() && (oled_i2c == nullptr || !(i2c_get_hw(oled_i2c)->status & I2C_IC_STATUS_ACTIVITY_BITS));
+}
+
+// Sends one command transaction (e.g. 0xAE display off) on the DMA path.
+// Returns false while a flush is still using the channel.
+static bool oled_command(const uint8_t *cmd, uint8_t n) {
+  if (oled_dma < 0 || oled_busy() || n == 0 || n > 6) return false;
+  size_t k = 0;
+  oled_words[k++] = 0x00;                                 // command stream
+  for (uint8_t i = 0; i < n; i++) oled_words[k++] = cmd[i];
+  oled_words[k - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  dma_channel_transfer_from_buffer_now(oled_dma, oled_words, k);
+  return true;
+}
+
+// Starts a background transfer of all dirty spans. Returns false when nothing
+// was sent (clean, DMA unavailable, or the previous transfer still running;
+// dirty spans are kept for the next call in that case).
+static bool oled_flush() {
+  if (oled_dma < 0 || oled_busy()) return false;
+  size_t n = 0;
+  for (uint8_t p = 0; p < OLED_PAGES; p++) {
+    if (oled_col_lo[p] > oled_col_hi[p]) continue;
+    uint8_t c0 = oled_col_lo[p], c1 = oled_col_hi[p];
+    const uint16_t cmd[7] = { 0x00, 0x21, c0, c1, 0x22, p, p };   // column + page window
+    for (uint8_t i = 0; i < 7; i++) oled_words[n++] = cmd[i];
+    oled_words[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    oled_words[n++] = 0x40;                                      // data follows
+    for (uint16_t x = c0; x <= c1; x++) oled_words[n++] = oled_fb[p * OLED_W + x];
+    oled_words[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  }
+  if (n == 0) return false;
+  oled_clear_dirty();
+  dma_channel_transfer_from_buffer_now(oled_dma, oled_words, n);
+  return true;
+}
+
+#endif // MILES_DISPLAY_H
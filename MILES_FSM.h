@@ -0,0 +1,113 @@
+#ifndef MILES_FSM_H
+#define MILES_FSM_H
+
+/*
+  Arming FSM definition shared by the firmware and MILES_GUI.py.
+
+  The X-macro lists below are the single source of truth: the firmware
+  expands them into enums and a constexpr transition table, and the
+  simulator parses the same lines at start-up. Edit the FSM here only.
+
+  Rows are evaluated top to bottom; the first row whose "from" matches the
+  current state (or ANY_STATE) and whose guard holds wins. Event guards
+  (MANUAL_FIRE, PWR_HOLD) are true only while that event is dispatched;
+  the others are level checks re-evaluated after every event.
+
+  Guard and action meanings live with each implementation (fsm_guard()/
+  fsm_action() in DROP_MILES.cpp, MilesSim.guard()/action() in MILES_GUI.py).
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+// X(id, display name)
+#define MILES_FSM_STATES(X)              \
+  X(SAFE_STATE,     "SAFE")              \
+  X(SAFE_READY,     "SAFE READY")        \
+  X(ARMED_FLY,      "ARMED FLY")         \
+  X(ARMED_SENSING,  "ARMED SENSE")       \
+  X(ARMED_IR_FLASH, "IR FLASH")          \
+  X(EXPENDED,       "EXPENDED")
+
+// X(id)
+#define MILES_FSM_GUARDS(X)  \
+  X(LIMIT_PRESSED)           \
+  X(LIMIT_RELEASED)          \
+  X(ALT_OK)                  \
+  X(TX_COMPLETE)             \
+  X(EXPENDED_TIMEOUT)        \
+  X(MANUAL_FIRE)             \
+  X(PWR_HOLD)
+
+// X(id)
+#define MILES_FSM_ACTIONS(X) \
+  X(NONE)                    \
+  X(FIRE)                    \
+  X(START_EXPENDED)          \
+  X(DISARM)
+
+// X(from, guard, action, to)
+#define MILES_FSM_TRANSITIONS(X)                                   \
+  X(SAFE_STATE,     PWR_HOLD,         NONE,           SAFE_READY)     \
+  X(SAFE_READY,     LIMIT_PRESSED,    NONE,           ARMED_FLY)      \
+  X(ARMED_FLY,      LIMIT_RELEASED,   NONE,           ARMED_SENSING)  \
+  X(ARMED_SENSING,  ALT_OK,           FIRE,           ARMED_IR_FLASH) \
+  X(ARMED_SENSING,  MANUAL_FIRE,      FIRE,           ARMED_IR_FLASH) \
+  X(ARMED_IR_FLASH, TX_COMPLETE,      START_EXPENDED, EXPENDED)       \
+  X(EXPENDED,       EXPENDED_TIMEOUT, NONE,           SAFE_STATE)     \
+  X(ANY_STATE,      PWR_HOLD,         DISARM,         SAFE_STATE)
+
+enum State : uint8_t {
+#define MILES_FSM_STATE_ENUM(id, name) id,
+  MILES_FSM_STATES(MILES_FSM_STATE_ENUM)
+#undef MILES_FSM_STATE_ENUM
+  NUM_STATES,
+  ANY_STATE = 0xff      // wildcard "from" in the transition table
+};
+
+enum Guard : uint8_t {
+#define MILES_FSM_GUARD_ENUM(id) G_##id,
+  MILES_FSM_GUARDS(MILES_FSM_GUARD_ENUM)
+#undef MILES_FSM_GUARD_ENUM
+  G_NONE                // "no event" trigger for level re-evaluation
+};
+
+enum Action : uint8_t {
+#define MILES_FSM_ACTION_ENUM(id) A_##id,
+  MILES_FSM_ACTIONS(MILES_FSM_ACTION_ENUM)
+#undef MILES_FSM_ACTION_ENUM
+};
+
+typedef struct {
+  State  from;
+  Guard  guard;
+  Action action;
+  State  to;
+} Transition;
+
+constexpr Transition FSM_TABLE[] = {
+#define MILES_FSM_ROW(from, guard, action, to) { from, G_##guard, A_##action, to },
+  MILES_FSM_TRANSITIONS(MILES_FSM_ROW)
+#undef MILES_FSM_ROW
+};
+constexpr size_t FSM_ROWS = sizeof(FSM_TABLE) / sizeof(FSM_TABLE[0]);
+
+constexpr const char *FSM_STATE_NAMES[NUM_STATES] = {
+#define MILES_FSM_STATE_NAME(id, name) name,
+  MILES_FSM_STATES(MILES_FSM_STATE_NAME)
+#undef MILES_FSM_STATE_NAME
+};
+
+constexpr bool fsm_guard_is_event(Guard g) {
+  return g == G_MANUAL_FIRE || g == G_PWR_HOLD;
+}
+
+constexpr bool fsm_table_valid(size_t i = 0) {
+  return i == FSM_ROWS ||
+         ((FSM_TABLE[i].from < NUM_STATES || FSM_TABLE[i].from == ANY_STATE) &&
+          FSM_TABLE[i].to < NUM_STATES && FSM_TABLE[i].guard != G_NONE &&
+          fsm_table_valid(i + 1));
+}
+static_assert(fsm_table_valid(), "MILES_FSM_TRANSITIONS has an out-of-range row");
+
+#endif // MILES_FSM_H
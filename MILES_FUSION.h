@@ -0,0 +1,185 @@
+#ifndef MILES_FUSION_H
+#define MILES_FUSION_H
+
+/*
+  Drop detection: the limit switch, the accelerometer (MILES_IMU.h) and the
+  range sensor (MILES_ALT.h) fused into two signals for the FSM, "released"
+  and "at altitude".
+
+  A 1 kHz timer polls the IMU and keeps a per-mille score per signal. Every
+  tick, each source that agrees adds its gain; the signal asserts when the
+  score reaches FUSE_FULL.
+
+    released     limit open (debounced)                +limit_gain
+                 free fall, |a| < free_fall_mg          +fall_gain
+                 limit closed: score 0, still attached
+    at altitude  range sensor above its threshold      +alt_gain
+    (released)   fallen 1/2 g t^2 >= kin_mm, t being    +kin_gain
+                 the free-fall time since the release
+                 neither: the score decays by alt_gain
+
+  One source can assert a signal on its own, but it takes longer than two
+  that agree. A limit bounce must outlast FUSE_FULL / limit_gain ticks,
+  and a range sensor that misses the window is covered by the fall time.
+  An impact (|a| > impact_mg) ends the fall: the fall time stops until the
+  next release. Without an IMU only the limit and range terms remain. From
+  the first agreeing sample, a signal asserts within fuse_bound_us() of
+  the smallest gain in play.
+
+  Both edges are posted as EV_PRESS / EV_RELEASE (arg = the configured id).
+  An assertion also latches a FuseReport for telemetry. fuse_on() and
+  fuse_score() are plain loads.
+*/
+
+#include <Arduino.h>
+#include "MILES_SCHED.h"
+#include "MILES_INPUT.h"
+#include "MILES_ALT.h"
+#include "MILES_IMU.h"
+
+typedef struct {
+  uint8_t  limit_id;        // debounced input, active = still attached
+  uint8_t  released_id;     // args of the posted EV_PRESS / EV_RELEASE
+  uint8_t  at_alt_id;
+  uint16_t limit_gain;      // score per tick, per source
+  uint16_t fall_gain;
+  uint16_t alt_gain;
+  uint16_t kin_gain;
+  uint16_t free_fall_mg;    // |a| below: falling
+  uint16_t impact_mg;       // |a| above: hit something
+  int32_t  kin_mm;          // fall distance that counts as altitude
+} FusionConfig;
+
+enum FuseSignal : uint8_t { FUSE_RELEASED = 0, FUSE_AT_ALT, NUM_FUSE };
+
+enum FuseSource : uint8_t {
+  FUSE_SRC_LIMIT = 1,
+  FUSE_SRC_FALL  = 2,       // free fall
+  FUSE_SRC_ALT   = 4,       // range sensor
+  FUSE_SRC_KIN   = 8        // fall time
+};
+
+typedef struct {
+  uint32_t t_us;            // asserted
+  uint32_t latency_us;      // since the score left zero
+  uint8_t  sources;         // FuseSource bits that added to the score
+  uint16_t fall_ms;         // free-fall time since the release
+  uint16_t peak_mg;         // largest |a| since the release
+} FuseReport;
+
+const uint32_t FUSE_TICK_US = 1000;
+const int32_t  FUSE_FULL    = 1000;  // per-mille
+
+// Worst case from the first agreeing sample: the ticks to fill the score
+// plus one tick of phase.
+constexpr uint32_t fuse_bound_us(uint32_t gain) {
+  return ((FUSE_FULL + gain - 1) / gain + 1) * FUSE_TICK_US;
+}
+
+typedef struct {
+  int32_t  score;
+  bool     on;
+  uint8_t  sources;
+  uint32_t first_us;
+} FuseState;
+
+static const FusionConfig *fuse_cfg = nullptr;
+static struct repeating_timer fuse_timer;
+static volatile FuseState fuse_state[NUM_FUSE];
+static FuseReport fuse_report[NUM_FUSE];            // complete before its EV_PRESS is posted
+static uint32_t fuse_free2 = 0, fuse_impact2 = 0;    // thresholds squared, mg^2
+static uint32_t fuse_kin_ms = 0;                     // fall time that covers kin_mm
+static uint32_t fuse_fall_ms = 0;
+static uint32_t fuse_peak2 = 0;
+static bool     fuse_falling = false, fuse_landed = false;
+
+static uint32_t fuse_isqrt(uint32_t v) {
+  uint32_t r = 0;
+  for (uint32_t b = 1u << 30; b; b >>= 2) {
+    if (v >= r + b) { v -= r + b; r = (r >> 1) + b; }
+    else r >>= 1;
+  }
+  return r;
+}
+
+static void fuse_step(uint8_t sig, int32_t delta, uint8_t sources, uint32_t now) {
+  volatile FuseState &f = fuse_state[sig];
+  int32_t v = f.score + delta;
+  v = v < 0 ? 0 : v > FUSE_FULL ? FUSE_FULL : v;
+  if (f.score == 0 && v > 0) { f.first_us = now; f.sources = 0; }
+  if (delta > 0) f.sources = f.sources | sources;
+  f.score = v;
+
+  uint8_t id = sig == FUSE_RELEASED ? fuse_cfg->released_id : fuse_cfg->at_alt_id;
+  if (!f.on && v == FUSE_FULL) {
+    FuseReport &r = fuse_report[sig];
+    r.t_us = now;
+    r.latency_us = now - f.first_us;
+    r.sources = f.sources;
+    r.fall_ms = (uint16_t)(fuse_fall_ms < 0xFFFF ? fuse_fall_ms : 0xFFFF);
+    r.peak_mg = (uint16_t)fuse_isqrt(fuse_peak2);
+    f.on = true;
+    sched_post(EV_PRESS, id);
+  } else if (f.on && v == 0) {
+    f.on = false;
+    sched_post(EV_RELEASE, id);
+  }
+}
+
+static bool fuse_tick(struct repeating_timer *) {
+  const FusionConfig &c = *fuse_cfg;
+  uint32_t now = time_us_32();
+  ImuSample s;
+  bool fresh = imu_poll(&s);
+  if (fresh) fuse_falling = s.mag2 < fuse_free2;
+
+  if (input_active(c.limit_id)) {
+    fuse_fall_ms = 0; fuse_peak2 = 0; fuse_landed = false;
+    fuse_step(FUSE_RELEASED, -FUSE_FULL, 0, now);
+    fuse_step(FUSE_AT_ALT,   -FUSE_FULL, 0, now);
+    return true;
+  }
+  if (fresh) {
+    if (s.mag2 > fuse_peak2) fuse_peak2 = s.mag2;
+    if (s.mag2 > fuse_impact2) fuse_landed = true;
+  }
+  bool falling = fuse_falling && !fuse_landed;
+  if (falling) fuse_fall_ms += FUSE_TICK_US / 1000;
+
+  uint8_t src = FUSE_SRC_LIMIT | (falling ? FUSE_SRC_FALL : 0);
+  fuse_step(FUSE_RELEASED, c.limit_gain + (falling ? c.fall_gain : 0), src, now);
+  if (!fuse_state[FUSE_RELEASED].on) return true;
+
+  src = (alt_above() ? FUSE_SRC_ALT : 0) | (fuse_fall_ms >= fuse_kin_ms ? FUSE_SRC_KIN : 0);
+  int32_t gain = (src & FUSE_SRC_ALT ? c.alt_gain : 0) + (src & FUSE_SRC_KIN ? c.kin_gain : 0);
+  fuse_step(FUSE_AT_ALT, src ? gain : -(int32_t)c.alt_gain, src, now);
+  return true;
+}
+
+// cfg must outlive the subsystem. Call after input_init(), alt_init() and
+// imu_init(); the IMU terms are used only if imu_init() succeeded.
+static bool fuse_init(const FusionConfig *cfg) {
+  fuse_cfg = cfg;
+  fuse_free2   = (uint32_t)cfg->free_fall_mg * cfg->free_fall_mg;
+  fuse_impact2 = (uint32_t)cfg->impact_mg * cfg->impact_mg;
+  // d = g t^2 / 2 with g = 9807 mm/s^2: t^2 = 2 d / g, in ms^2
+  fuse_kin_ms  = fuse_isqrt((uint32_t)((uint64_t)cfg->kin_mm * 2000000 / 9807)) + 1;
+  return add_repeating_timer_us(-(int64_t)FUSE_TICK_US, fuse_tick, nullptr, &fuse_timer);
+}
+
+// Standby: stops the timer and the IMU. The scores keep their values until
+// the first tick after fuse_resume().
+static void fuse_stop() {
+  cancel_repeating_timer(&fuse_timer);
+  imu_stop();
+}
+
+static bool fuse_resume() {
+  imu_resume();
+  return add_repeating_timer_us(-(int64_t)FUSE_TICK_US, fuse_tick, nullptr, &fuse_timer);
+}
+
+static inline bool    fuse_on(FuseSignal s)    { return fuse_state[s].on; }
+static inline int32_t fuse_score(FuseSignal s) { return fuse_state[s].score; }
+
+#endif // MILES_FUSION_H
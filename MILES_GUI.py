@@ -13,6 +13,23 @@
 # R — Reset to SAFE
 # Q — Quit
 
+# Live mirror of a unit over USB (needs pyserial):
+#   python3 MILES_GUI.py --port /dev/ttyACM0
+# The window then shows the unit's own state (TM_UI records, MILES_TELEM.h)
+# and the keys drive its inputs instead: P/N/S/F press the buttons, L and A
+# toggle the limit switch and altitude, R hands every input back to the
+# hardware. C and X have no effect. Other records are printed as
+# MILES_TELEM.py prints them.
+
+# Scenario replay, no window (format and comparison in MILES_REPLAY.py):
+#   python3 MILES_GUI.py --replay host/replay/drop_fire.txt > sim.trace
+# The script's inputs go through modelled debounce, PWR hold, altitude
+# filter and confirm window on a virtual 1 ms clock, and every state entry
+# and burst is printed as host/MILES_HOST.cpp -r prints it for the firmware.
+# Not modelled: drop fusion (up to ~10 ms on a release), time on air.
+# Timings come from MILES_PROFILE.h (--profile, default demo, as the
+# default firmware build) and the altitude filter from DROP_MILES.cpp.
+
 # What you’ll see matches the embedded GUI:
 # State text (SAFE → SAFE READY → ARMED FLY → ARMED SENSE → IR FLASH → EXPENDED)
 # Protocol name and Side (BLUFOR/OPFOR)
@@ -22,28 +39,84 @@
 # CONFIRMED indicator when self-sense is detected (auto or manual)
 # “LEDs” on the right (green/orange/red) for SAFE/ARMED/EXPENDED
 
-import tkinter as tk
+import argparse
+import os
+import re
+import struct
+import sys
+import threading
 import time
+try:
+    import tkinter as tk
+except ImportError:
+    tk = None                # --replay runs without it
 
 OLED_W, OLED_H = 128, 72
 SCALE = 4
 W, H = OLED_W * SCALE, OLED_H * SCALE
 
-SAFE_STATE     = 0
-SAFE_READY     = 1
-ARMED_FLY      = 2
-ARMED_SENSING  = 3
-ARMED_IR_FLASH = 4
-EXPENDED       = 5
-
-STATE_NAMES = {
-    SAFE_STATE: "SAFE",
-    SAFE_READY: "SAFE READY",
-    ARMED_FLY: "ARMED FLY",
-    ARMED_SENSING: "ARMED SENSE",
-    ARMED_IR_FLASH: "IR FLASH",
-    EXPENDED: "EXPENDED",
-}
+# The FSM comes from the firmware's MILES_FSM.h so the two cannot drift.
+FSM_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "MILES_FSM.h")
+
+def _macro_body(src, name):
+    m = re.search(r"#define\s+" + name + r"\(X\)((?:[^\n]*\\\n)*[^\n]*)", src)
+    if not m: raise RuntimeError(f"{name} not found in {FSM_HEADER}")
+    return m.group(1)
+
+def load_fsm(path=FSM_HEADER):
+    with open(path) as f: src = f.read()
+    states = re.findall(r'X\(\s*(\w+)\s*,\s*"([^"]*)"\s*\)', _macro_body(src, "MILES_FSM_STATES"))
+    guards = re.findall(r"X\(\s*(\w+)\s*\)", _macro_body(src, "MILES_FSM_GUARDS"))
+    actions = re.findall(r"X\(\s*(\w+)\s*\)", _macro_body(src, "MILES_FSM_ACTIONS"))
+    rows = re.findall(r"X\(\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*\)",
+                      _macro_body(src, "MILES_FSM_TRANSITIONS"))
+    ids = {name: i for i, (name, _) in enumerate(states)}
+    ids["ANY_STATE"] = None
+    table = [(ids[f], g, a, ids[t]) for f, g, a, t in rows]
+    return states, guards, actions, table
+
+FSM_STATES, FSM_GUARDS, FSM_ACTIONS, FSM_TABLE = load_fsm()
+
+# Timings likewise: the rows of timing_profiles in MILES_PROFILE.h, and the
+# altitude filter from alt_config in the sketch.
+PROFILE_HEADER = os.path.join(os.path.dirname(FSM_HEADER), "MILES_PROFILE.h")
+SKETCH = os.path.join(os.path.dirname(FSM_HEADER), "DROP_MILES.cpp")
+
+def load_profiles(path=PROFILE_HEADER):
+    with open(path) as f: src = f.read()
+    struct_body = re.search(r"typedef struct \{(.*?)\} TimingProfile;", src, re.S).group(1)
+    fields = re.findall(r"(\w+);", struct_body)
+    table = re.search(r"timing_profiles\[\w+\] = \{(.*?)\};", src, re.S).group(1)
+    profiles = {}
+    for pid, name, nums in re.findall(r'\{\s*(\w+),\s*"(\w+)",([^}]*)\}', table):
+        values = [pid, name] + [int(v) for v in nums.split(",")]
+        if len(values) != len(fields): raise RuntimeError(f"profile {name} in {path} does not match TimingProfile")
+        profiles[name] = dict(zip(fields, values))
+    return profiles
+
+def load_alt_config(path=SKETCH):
+    with open(path) as f: src = f.read()
+    body = re.search(r"AltConfig alt_config = \{(.*?)\};", src, re.S).group(1)
+    return {k: int(v) for v, k in re.findall(r"(-?\d+),?\s*//\s*(\w+)", body)}
+
+PROFILES = load_profiles()
+ALT_CONFIG = load_alt_config()
+
+def use_profile(name):
+    global EXPENDED_MS, CONFIRM_WINDOW_MS, PWR_HOLD_MS, DEBOUNCE_MS, SENSOR_DEBOUNCE_MS
+    p = PROFILES[name]
+    EXPENDED_MS, CONFIRM_WINDOW_MS = p["expended_ms"], p["confirm_window_ms"]
+    PWR_HOLD_MS, DEBOUNCE_MS, SENSOR_DEBOUNCE_MS = p["pwr_hold_ms"], p["debounce_ms"], p["sensor_debounce_ms"]
+STATE_IDS = {name: i for i, (name, _) in enumerate(FSM_STATES)}
+STATE_NAMES = {i: label for i, (_, label) in enumerate(FSM_STATES)}
+EVENT_GUARDS = ("MANUAL_FIRE", "PWR_HOLD")   # mirrors fsm_guard_is_event()
+
+SAFE_STATE     = STATE_IDS["SAFE_STATE"]
+SAFE_READY     = STATE_IDS["SAFE_READY"]
+ARMED_FLY      = STATE_IDS["ARMED_FLY"]
+ARMED_SENSING  = STATE_IDS["ARMED_SENSING"]
+ARMED_IR_FLASH = STATE_IDS["ARMED_IR_FLASH"]
+EXPENDED       = STATE_IDS["EXPENDED"]
 
 PROTOCOLS = [
     "Universal Kill (Basic)",
@@ -53,18 +126,22 @@ PROTOCOLS = [
     "End Exercise",
 ]
 
-EXPENDED_MS = 5000
+use_profile("demo")
 FLASH_TOAST_MS = 600
-CONFIRM_WINDOW_MS = 36    # scaled up for desktop
 CONFIRM_SHOW_MS = 800
+CONFIRM_KEY_MS = 500         # X after a shot: a person's reaction time, not a firmware timing
 
-class MilesSim:
-    def __init__(self, root):
-        self.root = root
-        self.root.title("MILES OLED FSM Simulator (128x64)")
-        self.canvas = tk.Canvas(root, width=W, height=H, bg="black", highlightthickness=0)
-        self.canvas.pack()
+# Live bridge: input ids as InputId in DROP_MILES.cpp
+IN_PWR, IN_NEXT, IN_SIDE, IN_FIRE, IN_LIMIT, IN_ALT = range(6)
+TAP_MS = 60                  # button press length, over the 20 ms debounce
+ALT_HIGH_MM, ALT_LOW_MM = 4000, 0
+RELEASE, ALT_RELEASE = -1, -32768
+INJECT_MAX = 10              # events per HC_INJECT frame (3 bytes each)
+
+class MilesModel:
+    """The FSM and what the screen shows, on a clock supplied by the subclass."""
 
+    def __init__(self):
         self.state = SAFE_STATE
         self.active_index = 0
         self.side_opfor = False
@@ -84,36 +161,16 @@ class MilesSim:
 
         self.expended_start = 0.0
 
-        root.bind("<Key>", self.on_key)
-        self.update_loop()
-
     def now(self): return time.time()
-
-    def on_key(self, event):
-        k = event.keysym.lower()
-        if k == 'q': self.root.destroy()
-        elif k == 'p': self.handle_power_hold()
-        elif k == 'n': self.active_index = (self.active_index + 1) % len(PROTOCOLS)
-        elif k == 's': self.side_opfor = not self.side_opfor
-        elif k == 'l': self.limit_pressed = not self.limit_pressed
-        elif k == 'a': self.altitude_ok = not self.altitude_ok
-        elif k == 'f': self.manual_fire()
-        elif k == 'c': self.confirm_auto = not self.confirm_auto
-        elif k == 'x':
-            if not self.confirm_auto and (self.now() - self.confirm_window_start)*1000 <= CONFIRM_WINDOW_MS:
-                self.set_confirmed()
-        elif k == 'r': self.reset_safe()
+    def after(self, ms, fn): raise NotImplementedError
+    def elapsed_ms(self, since): return round((self.now() - since) * 1000, 3)
+    def entered(self): pass      # after every transition
 
     def handle_power_hold(self):
-        if self.state == SAFE_STATE: self.state = SAFE_READY
-        else:
-            self.state = SAFE_STATE
-            self.expended_start = 0.0
-            self.altitude_ok = False
-            self.limit_pressed = False
+        self.fsm_step("PWR_HOLD")
 
     def manual_fire(self):
-        if self.state == ARMED_SENSING: self.state = ARMED_IR_FLASH
+        self.fsm_step("MANUAL_FIRE")
 
     def reset_safe(self):
         self.state = SAFE_STATE
@@ -127,28 +184,74 @@ class MilesSim:
         self.flash_event_time = self.now()
         self.confirm_window_start = self.flash_event_time
         if self.confirm_auto:
-            self.root.after(80, self.set_confirmed)
+            self.after(CONFIRM_WINDOW_MS, self.set_confirmed)
 
     def set_confirmed(self):
         self.flash_confirmed = True
         self.confirmed_time = self.now()
 
-    def fsm_step(self):
-        if self.state == SAFE_STATE: pass
-        elif self.state == SAFE_READY:
-            if self.limit_pressed: self.state = ARMED_FLY
-        elif self.state == ARMED_FLY:
-            if not self.limit_pressed: self.state = ARMED_SENSING
-        elif self.state == ARMED_SENSING:
-            if self.altitude_ok: self.state = ARMED_IR_FLASH
-        elif self.state == ARMED_IR_FLASH:
-            self.transmit()
-            self.state = EXPENDED
-            self.expended_start = self.now()
-        elif self.state == EXPENDED:
-            if (self.now() - self.expended_start)*1000 >= EXPENDED_MS:
-                self.state = SAFE_STATE
-                self.expended_start = 0.0
+    # Guard / action bindings for the rows in MILES_FSM.h
+    def guard(self, g, trigger):
+        if g in EVENT_GUARDS:      return trigger == g
+        if g == "LIMIT_PRESSED":   return self.limit_pressed
+        if g == "LIMIT_RELEASED":  return not self.limit_pressed
+        if g == "ALT_OK":          return self.altitude_ok
+        if g == "TX_COMPLETE":     return self.elapsed_ms(self.confirm_window_start) >= CONFIRM_WINDOW_MS   # no time on air
+        if g == "EXPENDED_TIMEOUT": return self.elapsed_ms(self.expended_start) >= EXPENDED_MS
+        raise KeyError(f"guard {g} from MILES_FSM.h has no simulator binding")
+
+    def action(self, a):
+        if a == "NONE": pass
+        elif a == "FIRE": self.transmit()
+        elif a == "START_EXPENDED": self.expended_start = self.now()
+        elif a == "DISARM":
+            self.expended_start = 0.0
+            self.altitude_ok = False
+            self.limit_pressed = False
+        else: raise KeyError(f"action {a} from MILES_FSM.h has no simulator binding")
+
+    def fsm_step(self, trigger=None):
+        for frm, g, a, to in FSM_TABLE:
+            if frm is not None and frm != self.state: continue
+            if g in EVENT_GUARDS and trigger != g: continue
+            if not self.guard(g, trigger): continue
+            self.action(a)
+            self.state = to
+            self.entered()
+            return True
+        return False
+
+    def tick(self):
+        while self.fsm_step(): pass
+
+
+class MilesSim(MilesModel):
+    def __init__(self, root):
+        MilesModel.__init__(self)
+        self.root = root
+        self.root.title("MILES OLED FSM Simulator (128x64)")
+        self.canvas = tk.Canvas(root, width=W, height=H, bg="black", highlightthickness=0)
+        self.canvas.pack()
+
+        root.bind("<Key>", self.on_key)
+        self.update_loop()
+
+    def after(self, ms, fn): self.root.after(ms, fn)
+
+    def on_key(self, event):
+        k = event.keysym.lower()
+        if k == 'q': self.root.destroy()
+        elif k == 'p': self.handle_power_hold()
+        elif k == 'n': self.active_index = (self.active_index + 1) % len(PROTOCOLS)
+        elif k == 's': self.side_opfor = not self.side_opfor
+        elif k == 'l': self.limit_pressed = not self.limit_pressed
+        elif k == 'a': self.altitude_ok = not self.altitude_ok
+        elif k == 'f': self.manual_fire()
+        elif k == 'c': self.confirm_auto = not self.confirm_auto
+        elif k == 'x':
+            if not self.confirm_auto and (self.now() - self.confirm_window_start)*1000 <= CONFIRM_KEY_MS:
+                self.set_confirmed()
+        elif k == 'r': self.reset_safe()
 
     def draw_text(self, x, y, text, size=1, invert=False):
         color = "black" if invert else "white"
@@ -169,7 +272,7 @@ class MilesSim:
         self.draw_text(0, 12, "State:", size=1)
         self.draw_text(48, 10, STATE_NAMES[self.state], size=2)
 
-        self.draw_text(0, 32, "Proto: " + PROTOCOLS[self.active_index], size=1)
+        self.draw_text(0, 32, "Proto: " + self.protocol_name(), size=1)
         self.draw_text(0, 44, "Side : " + ("OPFOR" if self.side_opfor else "BLUFOR"), size=1)
 
         self.draw_text(0, 56, f"LIM:{'ON ' if self.limit_pressed else 'OFF'} ALT3m:{'YES' if self.altitude_ok else 'NO '}", size=1)
@@ -198,14 +301,217 @@ class MilesSim:
 
         self.draw_text(0, 65, "P N S L A F C X R Q", size=1)
 
+    def protocol_name(self):
+        return PROTOCOLS[self.active_index]
+
     def update_loop(self):
-        self.fsm_step()
+        self.tick()
         self.render()
         self.root.after(33, self.update_loop)
 
+
+class Bridge:
+    """USB link to a unit: a reader thread keeps only the newest TM_UI
+    record, so rendering stays at display rate however fast records arrive.
+    Injected events are collected and sent together once Tk is idle."""
+
+    def __init__(self, port):
+        import serial   # pyserial, only needed for a live unit
+        from MILES_TELEM import Decoder, UI_FORMAT, encode_record, format_record
+        self.encode, self.format, self.ui_format = encode_record, format_record, UI_FORMAT
+        self.port = serial.Serial(port, 115200, timeout=0.05)
+        self.lock = threading.Lock()
+        self.latest = None           # (arrival time, TM_UI payload)
+        self.pending = []
+        self.decoder = Decoder()
+        self.running = True
+        threading.Thread(target=self.read_loop, daemon=True).start()
+
+    def read_loop(self):
+        from MILES_TELEM import TM_UI
+        while self.running:
+            data = self.port.read(4096)
+            for kind, item in self.decoder.feed_raw(data):
+                if kind == "text":
+                    sys.stdout.write(item)
+                elif item[0] == TM_UI:
+                    with self.lock: self.latest = (time.time(), item[1])
+                else:
+                    try: print(self.format(*item))
+                    except struct.error: pass
+            sys.stdout.flush()
+
+    def take(self):
+        with self.lock:
+            v, self.latest = self.latest, None
+        return v
+
+    def mirror(self, on):
+        from MILES_TELEM import HC_MIRROR
+        self.port.write(self.encode(HC_MIRROR, bytes([1 if on else 0])))
+
+    def inject(self, root, target, value):
+        if not self.pending: root.after_idle(self.flush)
+        self.pending.append(struct.pack("<Bh", target, value))
+
+    def flush(self):
+        from MILES_TELEM import HC_INJECT
+        out = b"".join(self.encode(HC_INJECT, b"".join(self.pending[i:i + INJECT_MAX]))
+                       for i in range(0, len(self.pending), INJECT_MAX))
+        self.pending = []
+        self.port.write(out)
+
+    def close(self):
+        self.mirror(False)           # detaches: the unit takes its inputs back
+        self.running = False
+        self.port.flush()
+
+
+class MilesLive(MilesSim):
+    """Mirrors a live unit; the keys drive its inputs."""
+
+    def __init__(self, root, port):
+        self.bridge = Bridge(port)
+        self.pid = 0
+        self.injected_limit = False
+        self.injected_alt = False
+        MilesSim.__init__(self, root)
+        self.root.title(f"MILES live: {port}")
+        self.bridge.mirror(True)
+
+    def tap(self, target, ms):
+        self.bridge.inject(self.root, target, 1)
+        self.root.after(ms, lambda: self.bridge.inject(self.root, target, 0))
+
+    def on_key(self, event):
+        k = event.keysym.lower()
+        b = self.bridge
+        if k == 'q':
+            b.close()
+            self.root.destroy()
+        elif k == 'p': self.tap(IN_PWR, PWR_HOLD_MS + 100)
+        elif k == 'n': self.tap(IN_NEXT, TAP_MS)
+        elif k == 's': self.tap(IN_SIDE, TAP_MS)
+        elif k == 'f': self.tap(IN_FIRE, TAP_MS)
+        elif k == 'l':
+            self.injected_limit = not self.injected_limit
+            b.inject(self.root, IN_LIMIT, 1 if self.injected_limit else 0)
+        elif k == 'a':
+            self.injected_alt = not self.injected_alt
+            b.inject(self.root, IN_ALT, ALT_HIGH_MM if self.injected_alt else ALT_LOW_MM)
+        elif k == 'r':
+            self.injected_limit = self.injected_alt = False
+            for i in (IN_PWR, IN_NEXT, IN_SIDE, IN_FIRE, IN_LIMIT): b.inject(self.root, i, RELEASE)
+            b.inject(self.root, IN_ALT, ALT_RELEASE)
+
+    def protocol_name(self):
+        return PROTOCOLS[self.active_index] if self.active_index < len(PROTOCOLS) else f"ID {self.pid}"
+
+    # Device times are ms on its clock; t_ms says where that clock stood
+    # when the record was sent.
+    def tick(self):
+        v = self.bridge.take()
+        if not v: return
+        arrival, p = v
+        t_ms, state, index, pid, flags, errors, shots, flash_ms, conf_ms, exp_ms = struct.unpack_from(self.bridge.ui_format, p)
+        base = arrival - t_ms / 1000.0
+        self.state, self.active_index, self.pid = state, index, pid
+        self.side_opfor = bool(flags & 1)
+        self.limit_pressed = bool(flags & 2)
+        self.altitude_ok = bool(flags & 4)
+        self.shot_count = shots
+        self.flash_event = shots > 0
+        self.flash_event_time = base + flash_ms / 1000.0
+        self.flash_confirmed = bool(flags & 8)
+        self.confirmed_time = base + conf_ms / 1000.0
+        self.expended_start = base + exp_ms / 1000.0 if state == EXPENDED else 0.0
+
+class MilesReplay(MilesModel):
+    """Headless: a scenario file on a virtual 1 ms clock, inputs as the
+    firmware would see them, the trace on stdout."""
+
+    def __init__(self, steps, out=sys.stdout):
+        MilesModel.__init__(self)
+        self.steps, self.out = steps, out
+        self.t_ms = 0
+        self.timers = []                 # (due ms, fn)
+        self.raw = {name: 0 for name in ("PWR", "NEXT", "SIDE", "FIRE", "LIMIT")}
+        self.level = dict(self.raw)      # debounced
+        self.changed = dict(self.raw)    # ms of the last raw edge
+        self.pwr_down_ms = None          # debounced press not yet turned into a hold
+        self.alt_mm = 0
+        self.alt_q4 = None               # filter state, mm in Q4 as MILES_ALT.h
+
+    def now(self): return self.t_ms / 1000.0
+    def after(self, ms, fn): self.timers.append((self.t_ms + ms, fn))
+
+    def entered(self): self.out.write(f"{self.t_ms:10.3f} STATE {FSM_STATES[self.state][0]}\n")
+
+    def transmit(self):
+        self.out.write(f"{self.t_ms:10.3f} TX 0\n")
+        MilesModel.transmit(self)
+
+    def action(self, a):
+        if a == "DISARM": self.expended_start = 0.0   # the inputs stay as the script left them
+        else: MilesModel.action(self, a)
+
+    def debounce(self):
+        for name, raw in self.raw.items():
+            ms = SENSOR_DEBOUNCE_MS if name == "LIMIT" else DEBOUNCE_MS
+            if raw == self.level[name] or self.t_ms - self.changed[name] < ms: continue
+            self.level[name] = raw
+            if name == "PWR": self.pwr_down_ms = self.t_ms if raw else None
+            elif name == "NEXT" and raw: self.active_index = (self.active_index + 1) % len(PROTOCOLS)
+            elif name == "SIDE" and raw: self.side_opfor = not self.side_opfor
+            elif name == "FIRE" and raw: self.manual_fire()
+        self.limit_pressed = bool(self.level["LIMIT"])
+        if self.pwr_down_ms is not None and self.t_ms - self.pwr_down_ms >= PWR_HOLD_MS:
+            self.pwr_down_ms = None
+            self.handle_power_hold()
+
+    def alt_filter(self):
+        c = ALT_CONFIG
+        if self.t_ms % (c["period_us"] // 1000): return
+        x = self.alt_mm << 4
+        self.alt_q4 = x if self.alt_q4 is None else self.alt_q4 + ((x - self.alt_q4) >> c["iir_shift"])
+        mm = self.alt_q4 >> 4
+        if not self.altitude_ok and mm >= c["threshold_mm"] + c["hysteresis_mm"]: self.altitude_ok = True
+        elif self.altitude_ok and mm < c["threshold_mm"] - c["hysteresis_mm"]: self.altitude_ok = False
+
+    def run(self):
+        steps = list(self.steps)
+        end = steps[-1][0]
+        while self.t_ms <= end:
+            while steps and steps[0][0] == self.t_ms:
+                _, name, value = steps.pop(0)
+                if name == "ALT": self.alt_mm = value
+                elif name is not None and self.raw[name] != (value != 0):
+                    self.raw[name], self.changed[name] = int(value != 0), self.t_ms
+            for due, fn in [t for t in self.timers if t[0] <= self.t_ms]:
+                self.timers.remove((due, fn))
+                fn()
+            self.debounce()
+            self.alt_filter()
+            self.tick()
+            self.t_ms += 1
+
 def main():
+    ap = argparse.ArgumentParser(description="MILES OLED simulator, or a live mirror of a unit")
+    ap.add_argument("--port", help="serial port of a unit to mirror (e.g. /dev/ttyACM0)")
+    ap.add_argument("--replay", metavar="SCENARIO", help="replay a scenario file without a window, trace on stdout")
+    ap.add_argument("--profile", default="demo", choices=sorted(PROFILES), help="timing profile (MILES_PROFILE.h)")
+    args = ap.parse_args()
+    use_profile(args.profile)
+    if args.replay:
+        from MILES_REPLAY import load_scenario
+        try: steps = load_scenario(args.replay)
+        except (OSError, ValueError) as e: sys.exit(str(e))
+        MilesReplay(steps).run()
+        return
+    if tk is None: sys.exit("tkinter is missing; only --replay runs without it")
     root = tk.Tk()
-    MilesSim(root)
+    if args.port: MilesLive(root, args.port)
+    else: MilesSim(root)
     root.mainloop()
 
 if __name__ == "__main__":
@@ -0,0 +1,160 @@
+#ifndef MILES_IMU_H
+#define MILES_IMU_H
+
+/*
+  Accelerometer (LIS3DH on SPI), read by DMA.
+
+  imu_init() checks WHO_AM_I, then runs the part at 1.344 kHz, +/-16 g,
+  high resolution. Block data update is on, so a read never mixes two
+  samples. Every transfer is a pair of DMA channels on the SPI data
+  register, and CS is the block's own CSn pin. In mode 3 the PL022 holds
+  CSn low across back-to-back frames, and DMA keeps the FIFO fed, so a
+  burst is one transaction.
+
+  imu_poll() is meant for a periodic timer. It picks up the sample fetched
+  by the previous call and kicks the next read (7 bytes, ~6 us at 10 MHz),
+  so the CPU never waits on the bus. The sample comes back in mg, plus
+  |a|^2 in mg^2 for threshold checks without a square root.
+*/
+
+#include <Arduino.h>
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+
+typedef struct {
+  spi_inst_t *spi;
+  uint8_t  sck, mosi, miso, cs;   // pins of that SPI block; cs is its CSn
+  uint32_t baud;
+} ImuConfig;
+
+typedef struct {
+  int16_t  mg[3];
+  uint32_t mag2;                  // |a|^2 in mg^2
+} ImuSample;
+
+const uint8_t LIS3DH_WHO_AM_I  = 0x0F;
+const uint8_t LIS3DH_ID        = 0x33;
+const uint8_t LIS3DH_CTRL_REG1 = 0x20;
+const uint8_t LIS3DH_CTRL_REG4 = 0x23;
+const uint8_t LIS3DH_OUT_X_L   = 0x28;
+const uint8_t LIS3DH_READ      = 0x80;
+const uint8_t LIS3DH_INCR      = 0x40;   // auto-increment the register address
+const uint8_t LIS3DH_RUN       = 0x97;   // CTRL_REG1: ODR 1.344 kHz, X/Y/Z on
+const uint8_t LIS3DH_OFF       = 0x07;   // CTRL_REG1: power-down, axes kept
+const uint8_t LIS3DH_FS16_HR   = 0xB8;   // CTRL_REG4: BDU, +/-16 g, high resolution
+const int32_t IMU_MG_PER_LSB   = 12;     // +/-16 g HR, 12 bits left-justified
+const uint8_t IMU_BURST        = 7;      // address + X/Y/Z
+
+static const ImuConfig *imu_cfg = nullptr;
+static int  imu_tx_dma = -1, imu_rx_dma = -1;
+static bool imu_ok = false;
+static bool imu_inflight = false;
+static uint8_t imu_cmd[IMU_BURST];
+static uint8_t imu_buf[IMU_BURST];
+
+static void imu_start(uint8_t n) {
+  volatile void *dr = &spi_get_hw(imu_cfg->spi)->dr;
+  dma_channel_config c = dma_channel_get_default_config(imu_rx_dma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, true);
+  channel_config_set_dreq(&c, spi_get_dreq(imu_cfg->spi, false));
+  dma_channel_configure(imu_rx_dma, &c, imu_buf, dr, n, true);
+
+  c = dma_channel_get_default_config(imu_tx_dma);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, spi_get_dreq(imu_cfg->spi, true));
+  dma_channel_configure(imu_tx_dma, &c, dr, imu_cmd, n, true);
+}
+
+// Blocking register access, for setup and standby only.
+static void imu_wait() {
+  while (dma_channel_is_busy(imu_rx_dma)) tight_loop_contents();
+  imu_inflight = false;
+}
+
+static uint8_t imu_read_reg(uint8_t reg) {
+  imu_wait();
+  imu_cmd[0] = LIS3DH_READ | reg; imu_cmd[1] = 0;
+  imu_start(2);
+  imu_wait();
+  return imu_buf[1];
+}
+
+static void imu_write_reg(uint8_t reg, uint8_t v) {
+  imu_wait();
+  imu_cmd[0] = reg; imu_cmd[1] = v;
+  imu_start(2);
+  imu_wait();
+}
+
+// cfg must outlive the subsystem. False if the part does not answer; the
+// DMA channels are released again.
+static bool imu_init(const ImuConfig *cfg) {
+  imu_cfg = cfg;
+  imu_rx_dma = dma_claim_unused_channel(false);
+  imu_tx_dma = dma_claim_unused_channel(false);
+  if (imu_rx_dma < 0 || imu_tx_dma < 0) {
+    if (imu_rx_dma >= 0) dma_channel_unclaim(imu_rx_dma);
+    imu_rx_dma = -1;
+    return false;
+  }
+
+  spi_init(cfg->spi, cfg->baud);
+  spi_set_format(cfg->spi, 8, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+  gpio_set_function(cfg->sck,  GPIO_FUNC_SPI);
+  gpio_set_function(cfg->mosi, GPIO_FUNC_SPI);
+  gpio_set_function(cfg->miso, GPIO_FUNC_SPI);
+  gpio_set_function(cfg->cs,   GPIO_FUNC_SPI);
+
+  imu_ok = imu_read_reg(LIS3DH_WHO_AM_I) == LIS3DH_ID;
+  if (!imu_ok) {
+    dma_channel_unclaim(imu_rx_dma); dma_channel_unclaim(imu_tx_dma);
+    imu_rx_dma = imu_tx_dma = -1;
+    return false;
+  }
+  imu_write_reg(LIS3DH_CTRL_REG4, LIS3DH_FS16_HR);
+  imu_write_reg(LIS3DH_CTRL_REG1, LIS3DH_RUN);
+  return true;
+}
+
+// Timer context. True with a new sample in *out; false while the first
+// read is still on the bus or without a part.
+static bool imu_poll(ImuSample *out) {
+  if (!imu_ok) return false;
+  bool got = false;
+  if (imu_inflight && !dma_channel_is_busy(imu_rx_dma)) {
+    uint32_t mag2 = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+      int16_t raw = (int16_t)(imu_buf[1 + 2 * i] | imu_buf[2 + 2 * i] << 8);
+      int32_t mg = (raw >> 4) * IMU_MG_PER_LSB;
+      out->mg[i] = (int16_t)mg;
+      mag2 += (uint32_t)(mg * mg);
+    }
+    out->mag2 = mag2;
+    imu_inflight = false;
+    got = true;
+  }
+  if (!imu_inflight) {
+    imu_cmd[0] = LIS3DH_READ | LIS3DH_INCR | LIS3DH_OUT_X_L;
+    memset(imu_cmd + 1, 0, IMU_BURST - 1);
+    imu_start(IMU_BURST);
+    imu_inflight = true;
+  }
+  return got;
+}
+
+// Standby: powers the part down (its timer must already be stopped).
+// imu_resume() restarts it; the first poll after that only kicks a read.
+static void imu_stop() {
+  if (imu_ok) imu_write_reg(LIS3DH_CTRL_REG1, LIS3DH_OFF);
+}
+
+static void imu_resume() {
+  if (imu_ok) imu_write_reg(LIS3DH_CTRL_REG1, LIS3DH_RUN);
+}
+
+#endif // MILES_IMU_H
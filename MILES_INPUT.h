@@ -0,0 +1,128 @@
+#ifndef MILES_INPUT_H
+#define MILES_INPUT_H
+
+/*
+  Timer-sampled input subsystem.
+
+  A repeating hardware alarm samples every configured pin at a fixed rate
+  with one gpio_get_all() read and runs an integrator debounce per pin: the
+  counter walks towards the raw level one step per tick and the debounced
+  state only flips at the rails. Press, release and long-press are posted to
+  the scheduler queue (arg = input id), so a slow loop() can neither drop a
+  press nor stretch a hold.
+
+  Any input can be driven from software instead of its pin (input_inject,
+  used by the Serial GUI bridge). The injected level goes through the same
+  debounce and long-press logic as a real one.
+*/
+
+#include <Arduino.h>
+#include "hardware/gpio.h"
+#include "MILES_SCHED.h"
+
+typedef struct {
+  uint8_t  pin;
+  bool     active_low;      // true: LOW = pressed (INPUT_PULLUP to GND)
+  uint8_t  debounce_ms;     // integrator depth; 0 = take every sample as is
+  uint16_t long_press_ms;   // 0 = no long-press event
+} InputConfig;
+
+const uint8_t  INPUT_MAX     = 8;
+const uint32_t INPUT_TICK_US = 1000;
+
+typedef struct {
+  uint8_t  count;           // integrator, 0 .. ceiling
+  uint8_t  ceiling;
+  bool     active;          // debounced level
+  bool     long_sent;
+  uint32_t since_ms;        // ticks since the last debounced edge
+} InputState;
+
+static const InputConfig *input_cfg = nullptr;
+static uint8_t input_count = 0;
+static volatile InputState input_state[INPUT_MAX];
+static struct repeating_timer input_timer;
+static volatile uint32_t input_injected = 0;   // bit i: input i injected, bit 16 + i: its level
+
+// Core 0 thread only; the sampler reads the word in one load.
+static void input_inject(uint8_t id, bool on) {
+  if (id >= INPUT_MAX) return;
+  uint32_t v = input_injected | (1u << id);
+  input_injected = on ? v | (1u << (16 + id)) : v & ~(1u << (16 + id));
+}
+
+static void input_release(uint8_t id) {   // back to the pin
+  if (id >= INPUT_MAX) return;
+  input_injected = input_injected & ~((1u << id) | (1u << (16 + id)));
+}
+
+static bool input_tick(struct repeating_timer *) {
+  const uint32_t ms_per_tick = INPUT_TICK_US / 1000;
+  uint32_t raw = gpio_get_all();
+  uint32_t inj = input_injected;
+  for (uint8_t i = 0; i < input_count; i++) {
+    const InputConfig &c = input_cfg[i];
+    volatile InputState &s = input_state[i];
+    bool level = ((raw >> c.pin) & 1) != 0;
+    bool on = (inj >> i) & 1 ? ((inj >> (16 + i)) & 1) != 0 : (c.active_low ? !level : level);
+
+    if (on  && s.count < s.ceiling) s.count = s.count + 1;
+    if (!on && s.count > 0)         s.count = s.count - 1;
+    s.since_ms = s.since_ms + ms_per_tick;
+
+    if (!s.active && s.count == s.ceiling) {
+      s.active = true; s.long_sent = false; s.since_ms = 0;
+      sched_post(EV_PRESS, i);
+    } else if (s.active && s.count == 0) {
+      s.active = false; s.since_ms = 0;
+      sched_post(EV_RELEASE, i);
+    } else if (s.active && c.long_press_ms && !s.long_sent && s.since_ms >= c.long_press_ms) {
+      s.long_sent = true;
+      sched_post(EV_LONG_PRESS, i);
+    }
+  }
+  return true;   // keep repeating
+}
+
+static void input_seed(const InputConfig *cfg, uint8_t n) {
+  uint32_t raw = gpio_get_all();
+  for (uint8_t i = 0; i < n; i++) {
+    bool level = ((raw >> cfg[i].pin) & 1) != 0;
+    bool on = cfg[i].active_low ? !level : level;
+    uint8_t ceiling = cfg[i].debounce_ms * 1000 / INPUT_TICK_US;
+    input_state[i].ceiling   = ceiling ? ceiling : 1;
+    input_state[i].count     = on ? input_state[i].ceiling : 0;
+    input_state[i].active    = on;
+    input_state[i].long_sent = false;  // a hold through boot still counts
+    input_state[i].since_ms  = 0;
+  }
+}
+
+// cfg must outlive the subsystem (a static table). Pins must already be
+// configured with pinMode(). Initial levels are taken as-is without events.
+static bool input_init(const InputConfig *cfg, uint8_t n) {
+  if (n > INPUT_MAX) n = INPUT_MAX;
+  input_cfg = cfg;
+  input_seed(cfg, n);
+  input_count = n;
+  return add_repeating_timer_us(-(int64_t)INPUT_TICK_US, input_tick, nullptr, &input_timer);
+}
+
+// Standby: stops sampling. input_resume() re-reads every level like
+// input_init(), but a button held across the wake (the wake press itself)
+// must be released before it can long-press.
+static void input_stop() {
+  cancel_repeating_timer(&input_timer);
+}
+
+static bool input_resume() {
+  input_seed(input_cfg, input_count);
+  for (uint8_t i = 0; i < input_count; i++) input_state[i].long_sent = input_state[i].active;
+  return add_repeating_timer_us(-(int64_t)INPUT_TICK_US, input_tick, nullptr, &input_timer);
+}
+
+static bool input_active(uint8_t id) {
+  return id < input_count && input_state[id].active;
+}
+
+#endif // MILES_INPUT_H
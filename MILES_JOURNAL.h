@@ -0,0 +1,145 @@
+#ifndef MILES_JOURNAL_H
+#define MILES_JOURNAL_H
+
+/*
+  Append-only, wear-leveled settings journal in a reserved flash region.
+
+  The region is a ring of fixed 16-byte records (sequence number, payload,
+  CRC-32). Each save programs one record into the next free slot; a sector is
+  only erased when the ring wraps into it, so every sector sees one erase per
+  (sector size / record size) saves instead of one per button press. On boot
+  the newest record with a valid CRC wins; a torn write simply fails its CRC
+  and the previous record is used.
+
+  The region comes from the core's filesystem area (_FS_start.._FS_end), so
+  select a Flash Size option with at least JOURNAL_BYTES of FS and do not
+  mount LittleFS on it. Flash writes stall XIP on both cores, so callers
+  should only append while the unit is idle.
+*/
+
+#include <Arduino.h>
+#include <cstddef>
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+const uint8_t  JOURNAL_PAYLOAD = 8;
+const uint32_t JOURNAL_SECTORS = 4;
+const uint32_t JOURNAL_BYTES   = JOURNAL_SECTORS * FLASH_SECTOR_SIZE;
+
+typedef struct {
+  uint32_t seq;                        // 0xFFFFFFFF = erased slot
+  uint8_t  data[JOURNAL_PAYLOAD];
+  uint32_t crc;                        // CRC-32 of seq + data
+} JournalRecord;
+static_assert(sizeof(JournalRecord) == 16, "journal record must stay 16 bytes");
+static_assert(FLASH_PAGE_SIZE % sizeof(JournalRecord) == 0, "records must not straddle pages");
+
+const uint32_t JOURNAL_SLOTS = JOURNAL_BYTES / sizeof(JournalRecord);
+
+extern uint8_t _FS_start;             // from the core's linker script
+extern uint8_t _FS_end;
+
+static uint32_t journal_base = 0;     // flash offset of the region
+static uint32_t journal_next = 0;     // slot for the next append
+static uint32_t journal_seq  = 0;     // seq of the newest record
+static bool     journal_have = false; // a valid record exists
+static bool     journal_ok   = false;
+
+static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0) {
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+  }
+  return ~crc;
+}
+
+// Erase/program with the other core parked and interrupts off (XIP is gone
+// for the duration).
+static void flash_safe_erase(uint32_t off, uint32_t len) {
+  rp2040.idleOtherCore();
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_erase(off, len);
+  restore_interrupts(irq);
+  rp2040.resumeOtherCore();
+}
+
+static void flash_safe_program(uint32_t off, const uint8_t *data, uint32_t len) {
+  rp2040.idleOtherCore();
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_program(off, data, len);
+  restore_interrupts(irq);
+  rp2040.resumeOtherCore();
+}
+
+static const JournalRecord *journal_slot(uint32_t i) {
+  return (const JournalRecord *)(uintptr_t)(XIP_BASE + journal_base + i * sizeof(JournalRecord));
+}
+
+static bool journal_valid(const JournalRecord *r) {
+  return r->seq != 0xFFFFFFFFu && r->crc == crc32((const uint8_t *)r, offsetof(JournalRecord, crc));
+}
+
+static bool journal_blank(const JournalRecord *r) {
+  const uint8_t *p = (const uint8_t *)r;
+  for (size_t i = 0; i < sizeof(JournalRecord); i++) if (p[i] != 0xFF) return false;
+  return true;
+}
+
+// Locates the region and scans it for the newest valid record.
+static bool journal_init() {
+  uint32_t start = (uint32_t)((uintptr_t)&_FS_start - XIP_BASE);
+  uint32_t end   = (uint32_t)((uintptr_t)&_FS_end - XIP_BASE);
+  journal_ok = end > start && end - start >= JOURNAL_BYTES && (start % FLASH_SECTOR_SIZE) == 0;
+  if (!journal_ok) return false;
+  journal_base = start;
+
+  uint32_t newest = 0;
+  journal_have = false;
+  for (uint32_t i = 0; i < JOURNAL_SLOTS; i++) {
+    const JournalRecord *r = journal_slot(i);
+    if (!journal_valid(r)) continue;
+    if (!journal_have || (int32_t)(r->seq - journal_seq) > 0) { journal_seq = r->seq; newest = i; journal_have = true; }
+  }
+  journal_next = journal_have ? (newest + 1) % JOURNAL_SLOTS : 0;
+  return true;
+}
+
+static bool journal_latest(uint8_t *out) {
+  if (!journal_ok || !journal_have) return false;
+  uint32_t slot = (journal_next + JOURNAL_SLOTS - 1) % JOURNAL_SLOTS;
+  memcpy(out, journal_slot(slot)->data, JOURNAL_PAYLOAD);
+  return true;
+}
+
+// Programs one record. Erases a sector only when the ring enters it; a dirty
+// slot inside a sector (a torn write or an interrupted erase) is skipped, so
+// the records before it, the newest one included, stay until the ring wraps.
+static bool journal_append(const uint8_t *payload) {
+  if (!journal_ok) return false;
+  uint32_t slot = journal_next;
+  uint32_t off  = journal_base + slot * sizeof(JournalRecord);
+  while (off % FLASH_SECTOR_SIZE && !journal_blank(journal_slot(slot))) {
+    slot = (slot + 1) % JOURNAL_SLOTS;
+    off  = journal_base + slot * sizeof(JournalRecord);
+  }
+  if (off % FLASH_SECTOR_SIZE == 0) flash_safe_erase(off, FLASH_SECTOR_SIZE);
+
+  JournalRecord rec;
+  rec.seq = journal_have ? journal_seq + 1 : 1;
+  memcpy(rec.data, payload, JOURNAL_PAYLOAD);
+  rec.crc = crc32((const uint8_t *)&rec, offsetof(JournalRecord, crc));
+
+  static uint8_t page[FLASH_PAGE_SIZE];   // 0xFF outside the record leaves other slots untouched
+  memset(page, 0xFF, sizeof(page));
+  memcpy(page + off % FLASH_PAGE_SIZE, &rec, sizeof(rec));
+  flash_safe_program(off - off % FLASH_PAGE_SIZE, page, FLASH_PAGE_SIZE);
+
+  if (!journal_valid(journal_slot(slot))) return false;
+  journal_seq  = rec.seq;
+  journal_have = true;
+  journal_next = (slot + 1) % JOURNAL_SLOTS;
+  return true;
+}
+
+#endif // MILES_JOURNAL_H
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Builds a protocol registry image (MILES_REGISTRY.h) and loads it over Serial.
+#
+# Usage:
+#   python3 MILES_LOAD.py codes.json /dev/ttyACM0    # needs pyserial
+#   python3 MILES_LOAD.py codes.json -o image.bin    # write the image only
+#
+# codes.json:
+#   [ {"id": 0, "name": "Universal Kill", "bins": "11000101101"}, ... ]
+# "bins" lists bin 0 first, like miles_pack() in MILES_CODES.H.h, and sets
+# the word length (1..64; the standard MILES word is 11). The unit
+# must be in SAFE; it reboots into the new table once the image is stored.
+
+import argparse
+import json
+import struct
+import sys
+import time
+import zlib
+
+from MILES_TELEM import Decoder
+
+MAGIC, VERSION = 0x4745524D, 2
+MAX_ENTRIES, NAME_LEN, MAX_BITS = 64, 32, 64
+
+
+def pack_bins(bins):
+    if not 1 <= len(bins) <= MAX_BITS or set(bins) - {"0", "1"}:
+        raise ValueError(f"bins must be 1..{MAX_BITS} characters of 0/1: {bins!r}")
+    return sum(1 << i for i, b in enumerate(bins) if b == "1")
+
+
+def build_image(codes):
+    codes = sorted(codes, key=lambda c: c["id"])
+    ids = [c["id"] for c in codes]
+    if not 0 < len(codes) <= MAX_ENTRIES: raise ValueError(f"1..{MAX_ENTRIES} codes required")
+    if len(set(ids)) != len(ids): raise ValueError("duplicate id")
+    entries = b""
+    for c in codes:
+        name = c["name"].encode("ascii")[:NAME_LEN - 1]
+        entries += struct.pack("<QBBHI", pack_bins(c["bins"]), c["id"], len(c["bins"]), 0, 0) + name.ljust(NAME_LEN, b"\0")
+    header = struct.pack("<IBBHII", MAGIC, VERSION, len(codes), 0, zlib.crc32(entries), 0)
+    return header + entries
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("codes", help="codes.json")
+    ap.add_argument("port", nargs="?", help="serial port of the unit, e.g. /dev/ttyACM0")
+    ap.add_argument("-o", metavar="image.bin", help="write the image instead of loading it")
+    args = ap.parse_args()
+    if (args.port is None) == (args.o is None):
+        ap.error("give either a port or -o image.bin")
+
+    with open(args.codes) as f:
+        image = build_image(json.load(f))
+    if args.o:
+        with open(args.o, "wb") as f: f.write(image)
+        return 0
+
+    import serial   # pyserial
+    with serial.Serial(args.port, 115200, timeout=0.2) as port:
+        port.write(b"L" + image)
+        port.flush()
+        dec = Decoder()
+        deadline = time.time() + 3
+        while time.time() < deadline:   # the unit answers with a log record, then reboots
+            for kind, item in dec.feed(port.read(256)):
+                if kind == "record" and "Registry" in item:
+                    print(item)
+                    return 0 if "Registry stored" in item else 1
+    print("no reply from the unit", file=sys.stderr)
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,79 @@
+#ifndef MILES_POWER_H
+#define MILES_POWER_H
+
+/*
+  Standby helpers: deep sleep with gated clocks and a wake-on-GPIO edge.
+
+  A core that calls power_sleep_until() sets SLEEPDEEP and waits in WFE
+  until the wake flag is set. Once both cores are asleep this way, the
+  clock tree only feeds the blocks in the POWER_SLEEP_EN* masks: processor,
+  bus fabric, SRAM, XIP, IO/pads (edge detection), SIO and the timer (so
+  time_us_64() stays valid across the sleep). PIO, DMA, ADC, I2C, PWM, the
+  UARTs and SPI are stopped. USB can optionally be left clocked so an
+  attached host keeps its enumeration.
+
+  This is sleep rather than DORMANT: the crystal and PLLs keep running, so
+  the wake cost is an interrupt entry, not a PLL relock.
+*/
+
+#include <Arduino.h>
+#include "hardware/sync.h"
+#include "hardware/structs/clocks.h"
+#include "hardware/structs/scb.h"
+
+const uint32_t POWER_SLEEP_EN0 =
+  CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS |
+  CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS |
+  CLOCKS_SLEEP_EN0_CLK_SYS_PLL_SYS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS |
+  CLOCKS_SLEEP_EN0_CLK_SYS_VREG_AND_CHIP_RESET_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS |
+  CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_BUSCTRL_BITS |
+  CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SIO_BITS;
+const uint32_t POWER_SLEEP_EN1 =
+  CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_XIP_BITS |
+  CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS |
+  CLOCKS_SLEEP_EN1_CLK_SYS_SYSCFG_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS |
+  CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS;
+const uint32_t POWER_SLEEP_EN0_USB = CLOCKS_SLEEP_EN0_CLK_SYS_PLL_USB_BITS;
+const uint32_t POWER_SLEEP_EN1_USB = CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS;
+
+static volatile uint64_t power_wake_us = 0;   // edge time; 0 = not woken
+static uint8_t power_wake_pin = 0;
+
+static void power_wake_isr() {
+  if (!power_wake_us) power_wake_us = time_us_64();
+  __sev();
+}
+
+// Arms the wake edge (mode: FALLING / RISING) for the next sleep.
+static void power_arm_wake(uint8_t pin, int mode) {
+  power_wake_us = 0;
+  power_wake_pin = pin;
+  attachInterrupt(digitalPinToInterrupt(pin), power_wake_isr, mode);
+}
+
+static void power_disarm_wake() {
+  detachInterrupt(digitalPinToInterrupt(power_wake_pin));
+}
+
+// Sets the clocks that keep running while both cores sleep. Call from the
+// core that owns the standby decision, before it sleeps.
+static void power_gate_clocks(bool keep_usb) {
+  clocks_hw->sleep_en0 = POWER_SLEEP_EN0 | (keep_usb ? POWER_SLEEP_EN0_USB : 0);
+  clocks_hw->sleep_en1 = POWER_SLEEP_EN1 | (keep_usb ? POWER_SLEEP_EN1_USB : 0);
+}
+
+static void power_ungate_clocks() {
+  clocks_hw->sleep_en0 = 0xFFFFFFFFu;
+  clocks_hw->sleep_en1 = 0xFFFFFFFFu;
+}
+
+// Deep-sleeps the calling core until done() returns true. Any SEV or
+// interrupt re-evaluates it.
+template <typename Done>
+static void power_sleep_until(Done done) {
+  scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+  while (!done()) __wfe();
+  scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+}
+
+#endif // MILES_POWER_H
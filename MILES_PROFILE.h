@@ -0,0 +1,74 @@
+#ifndef MILES_PROFILE_H
+#define MILES_PROFILE_H
+
+/*
+  Timing profiles: every deployment-specific timing in one constexpr table,
+  picked at build time with MILES_PROFILE (an index into timing_profiles).
+
+  The sketch reads the chosen profile through constexpr aliases (BIN_US,
+  CONFIRM_WINDOW_MS, ...), so the transmit encoder, the echo check and the
+  FSM timers are compiled with the numbers folded in; nothing is looked up
+  at run time. A profile that cannot work (pulse wider than its bin, no
+  confirm window, a debounce longer than a hold) or reuses an id fails
+  the build; every row is checked.
+
+  The id is saved with the settings (SettingsRecord::profile_id), so a unit
+  reflashed with another profile says so at boot. Ids are stored in flash:
+  append new profiles, never renumber.
+*/
+
+#include <Arduino.h>
+#include <cstddef>
+
+typedef struct {
+  uint8_t     id;                  // == index in timing_profiles
+  const char *name;
+  uint32_t    bin_us;              // bin duration
+  uint32_t    pulse_us;            // '1' pulse width inside a bin
+  int         side_bit;            // bit of the 11-bit frame that encodes BLU/OPFOR
+  uint32_t    confirm_window_ms;   // after TX, accept the self-sense echo
+  uint32_t    expended_ms;         // EXPENDED before returning to SAFE
+  uint32_t    debounce_ms;         // buttons
+  uint32_t    sensor_debounce_ms;  // limit switch
+  uint32_t    pwr_hold_ms;         // PWR long press (SAFE <-> SAFE_READY)
+} TimingProfile;
+
+enum : uint8_t {
+  PROFILE_DEMO = 0,                // bench demo: fast bins, any IR receiver module
+  PROFILE_SLOW,                    // double-length bins for receivers with slow AGC
+  PROFILE_DRILL,                   // demo timing, short EXPENDED hold for repeated drops
+  NUM_PROFILES
+};
+
+constexpr TimingProfile timing_profiles[NUM_PROFILES] = {
+  // id             name     bin   pulse side confirm expended deb  sensor hold
+  { PROFILE_DEMO,  "demo",   500,  250,  5,   12,     5000,    20,  3,     800 },
+  { PROFILE_SLOW,  "slow",  1000,  500,  5,   24,     5000,    20,  3,     800 },
+  { PROFILE_DRILL, "drill",  500,  250,  5,   12,     1500,    20,  3,     800 },
+};
+
+#ifndef MILES_PROFILE
+#define MILES_PROFILE PROFILE_DEMO  // build option: -DMILES_PROFILE=PROFILE_SLOW
+#endif
+static_assert(MILES_PROFILE < NUM_PROFILES, "MILES_PROFILE is not in timing_profiles");
+
+constexpr const TimingProfile &TIMING = timing_profiles[MILES_PROFILE];
+
+constexpr bool profile_valid(const TimingProfile &p, uint8_t index) {
+  return p.id == index && p.bin_us > 0 && p.pulse_us > 0 && p.pulse_us < p.bin_us &&
+         p.side_bit >= 0 && p.confirm_window_ms > 0 && p.expended_ms > 0 &&
+         p.debounce_ms > 0 && p.sensor_debounce_ms > 0 && p.pwr_hold_ms > p.debounce_ms;
+}
+
+constexpr bool profile_id_unique(size_t i, size_t j = 0) {
+  return j == NUM_PROFILES ||
+         ((j == i || timing_profiles[j].id != timing_profiles[i].id) && profile_id_unique(i, j + 1));
+}
+
+constexpr bool profiles_valid(size_t i = 0) {
+  return i == NUM_PROFILES ||
+         (profile_valid(timing_profiles[i], (uint8_t)i) && profile_id_unique(i) && profiles_valid(i + 1));
+}
+static_assert(profiles_valid(), "timing_profiles has an inconsistent or duplicate row");
+
+#endif // MILES_PROFILE_H
@@ -0,0 +1,111 @@
+#ifndef MILES_QUEUE_H
+#define MILES_QUEUE_H
+
+/*
+  Fixed-size message rings, statically allocated, for the two RP2040 cores.
+
+  SpscQueue: one producer, one consumer, lock-free on both sides. Only
+  32-bit loads and stores are used (the M0+ has no atomic RMW), with
+  acquire/release ordering so the payload is visible before the index moves.
+
+  MpscQueue: any number of producers on either core, in thread or IRQ
+  context; one consumer. Without CAS on the M0+, a producer claims its
+  slot under a hardware spinlock with interrupts off. The section is only
+  the index bump. The payload copy and its publication (a per-slot sequence
+  number) happen outside it, and the consumer never takes the lock.
+
+  The SIO FIFO is left alone: the core's flash/EEPROM code uses it to park
+  the other core.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "hardware/sync.h"
+
+template <typename T, uint32_t N>
+class SpscQueue {
+  static_assert(N != 0 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  // Producer side. Returns false (and drops v) when full.
+  bool push(const T &v) {
+    uint32_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == N) { dropped_++; return false; }
+    buf_[h & (N - 1)] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when empty.
+  bool pop(T &out) {
+    uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[t & (N - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+  }
+
+  uint32_t dropped() const { return dropped_; }   // producer-side count
+
+private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  uint32_t dropped_ = 0;
+};
+
+template <typename T, uint32_t N>
+class MpscQueue {
+  static_assert(N != 0 && (N & (N - 1)) == 0, "MpscQueue size must be a power of two");
+
+public:
+  MpscQueue() : lock_(spin_lock_instance(next_striped_spin_lock_num())) {
+    for (uint32_t i = 0; i < N; i++) seq_[i].store(i, std::memory_order_relaxed);
+  }
+
+  // Any producer. Returns false (and drops v) when full. Slot i of lap k
+  // holds seq i + kN while free and i + kN + 1 once published.
+  bool push(const T &v) {
+    uint32_t irq = spin_lock_blocking(lock_);
+    uint32_t h = head_;
+    bool ok = seq_[h & (N - 1)].load(std::memory_order_acquire) == h;
+    if (ok) head_ = h + 1; else dropped_++;
+    spin_unlock(lock_, irq);
+    if (!ok) return false;
+    buf_[h & (N - 1)] = v;
+    seq_[h & (N - 1)].store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when empty (or the oldest slot is still
+  // being written).
+  bool pop(T &out) {
+    uint32_t t = tail_;
+    if (seq_[t & (N - 1)].load(std::memory_order_acquire) != t + 1) return false;
+    out = buf_[t & (N - 1)];
+    seq_[t & (N - 1)].store(t + N, std::memory_order_release);
+    tail_ = t + 1;
+    return true;
+  }
+
+  bool empty() const {   // consumer side
+    return seq_[tail_ & (N - 1)].load(std::memory_order_acquire) != tail_ + 1;
+  }
+
+  uint32_t dropped() const { return dropped_; }
+
+private:
+  T buf_[N];
+  std::atomic<uint32_t> seq_[N];
+  spin_lock_t *lock_;
+  uint32_t head_ = 0;               // under lock_
+  uint32_t tail_ = 0;               // consumer only
+  uint32_t dropped_ = 0;            // under lock_
+};
+
+#endif // MILES_QUEUE_H
@@ -0,0 +1,123 @@
+#ifndef MILES_REGISTRY_H
+#define MILES_REGISTRY_H
+
+/*
+  Protocol registry: the table of MILES codes the unit can send.
+
+  The table is a compact binary image kept in one flash sector right after
+  the settings journal (FS region, see MILES_JOURNAL.h):
+    RegistryHeader, then `count` RegistryEntry records sorted by id
+  Each entry carries its own word length. If the sector holds no valid image the compiled-in table passed to
+  registry_init() is used instead. Either way the table is chosen once at
+  boot and never changes while running: a new image is written by
+  registry_store() and takes effect after a reboot, so both cores can read
+  entries without locking.
+
+  Lookups by id are a binary search over the sorted entries.
+*/
+
+#include <Arduino.h>
+#include "MILES_JOURNAL.h"
+
+const uint32_t REGISTRY_MAGIC   = 0x4745524D;   // 'MREG'
+const uint8_t  REGISTRY_VERSION = 2;            // 2: 64-bit pattern + per-code length
+const uint8_t  REGISTRY_MAX     = 64;
+const uint8_t  REGISTRY_NAME    = 32;            // incl. terminator
+const uint8_t  REGISTRY_MAX_BITS = 64;           // = TX_MAX_BITS
+
+typedef struct {
+  uint64_t pattern;                        // packed with miles_pack(), bit i = bin i
+  uint8_t  id;
+  uint8_t  bits;                           // word length, 1..REGISTRY_MAX_BITS
+  uint16_t reserved;                       // 0
+  uint32_t reserved2;                      // 0
+  char     name[REGISTRY_NAME];
+} RegistryEntry;
+static_assert(sizeof(RegistryEntry) == 48, "registry entry must stay 48 bytes");
+
+typedef struct {
+  uint32_t magic;
+  uint8_t  version;
+  uint8_t  count;
+  uint16_t reserved;                       // 0
+  uint32_t crc;                            // CRC-32 of the entries
+  uint32_t reserved2;                      // 0
+} RegistryHeader;
+static_assert(sizeof(RegistryHeader) == 16, "registry header must stay 16 bytes");
+
+const uint32_t REGISTRY_BYTES = sizeof(RegistryHeader) + REGISTRY_MAX * sizeof(RegistryEntry);
+static_assert(REGISTRY_BYTES <= FLASH_SECTOR_SIZE, "registry must fit one sector");
+
+static const RegistryEntry *reg_entries = nullptr;
+static uint8_t reg_count = 0;
+static bool    reg_from_flash = false;
+
+static uint32_t registry_offset() {        // flash offset of the registry sector
+  return (uint32_t)((uintptr_t)&_FS_start - XIP_BASE) + JOURNAL_BYTES;
+}
+
+static bool registry_region_ok() {
+  uint32_t start = (uint32_t)((uintptr_t)&_FS_start - XIP_BASE);
+  uint32_t end   = (uint32_t)((uintptr_t)&_FS_end - XIP_BASE);
+  return end > start && end - start >= JOURNAL_BYTES + FLASH_SECTOR_SIZE && (start % FLASH_SECTOR_SIZE) == 0;
+}
+
+// Checks an image (in flash or RAM): magic, size, CRC, ids strictly rising,
+// word lengths in range.
+static bool registry_valid(const uint8_t *img, uint32_t len) {
+  if (len < sizeof(RegistryHeader)) return false;
+  const RegistryHeader *h = (const RegistryHeader *)img;
+  if (h->magic != REGISTRY_MAGIC || h->version != REGISTRY_VERSION) return false;
+  if (h->count == 0 || h->count > REGISTRY_MAX) return false;
+  if (len < sizeof(RegistryHeader) + h->count * sizeof(RegistryEntry)) return false;
+  const RegistryEntry *e = (const RegistryEntry *)(img + sizeof(RegistryHeader));
+  if (crc32((const uint8_t *)e, h->count * sizeof(RegistryEntry)) != h->crc) return false;
+  for (uint8_t i = 0; i < h->count; i++) {
+    if (e[i].name[REGISTRY_NAME - 1] != '\0') return false;
+    if (e[i].bits < 1 || e[i].bits > REGISTRY_MAX_BITS) return false;
+    if (i && e[i].id <= e[i - 1].id) return false;
+  }
+  return true;
+}
+
+// Core 0, in setup(), before anything reads the table. builtin must be
+// sorted by id and outlive the registry.
+static bool registry_init(const RegistryEntry *builtin, uint8_t n) {
+  reg_entries = builtin; reg_count = n; reg_from_flash = false;
+  if (!registry_region_ok()) return false;
+  const uint8_t *img = (const uint8_t *)(uintptr_t)(XIP_BASE + registry_offset());
+  if (!registry_valid(img, REGISTRY_BYTES)) return false;
+  reg_count = ((const RegistryHeader *)img)->count;
+  reg_entries = (const RegistryEntry *)(img + sizeof(RegistryHeader));
+  reg_from_flash = true;
+  return true;
+}
+
+// Index of id, or -1.
+static int registry_find(uint8_t id) {
+  int lo = 0, hi = (int)reg_count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (reg_entries[mid].id == id) return mid;
+    if (reg_entries[mid].id < id) lo = mid + 1; else hi = mid - 1;
+  }
+  return -1;
+}
+
+// Writes a validated image to the registry sector (both cores stall for the
+// erase). The running table is untouched until the next boot.
+static bool registry_store(const uint8_t *img, uint32_t len) {
+  if (!registry_region_ok() || !registry_valid(img, len)) return false;
+  static uint8_t page[FLASH_PAGE_SIZE];
+  uint32_t off = registry_offset();
+  flash_safe_erase(off, FLASH_SECTOR_SIZE);
+  for (uint32_t p = 0; p < len; p += FLASH_PAGE_SIZE) {
+    uint32_t n = len - p < FLASH_PAGE_SIZE ? len - p : FLASH_PAGE_SIZE;
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, img + p, n);
+    flash_safe_program(off + p, page, FLASH_PAGE_SIZE);
+  }
+  return registry_valid((const uint8_t *)(uintptr_t)(XIP_BASE + off), REGISTRY_BYTES);
+}
+
+#endif // MILES_REGISTRY_H
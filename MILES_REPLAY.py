@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# Scenario replay: the same scripted inputs through the firmware (host bench)
+# and the simulator, and a comparison of the state traces they print.
+#
+# Usage:
+#   ./miles_host -r host/replay/drop_fire.txt > fw.trace
+#   python3 MILES_GUI.py --replay host/replay/drop_fire.txt > sim.trace
+#   python3 MILES_REPLAY.py fw.trace sim.trace                # firmware vs simulator
+#   python3 MILES_REPLAY.py old.trace new.trace --limit 0.1   # two firmware builds
+#
+# A scenario is one "t_ms INPUT value" per line, '#' comments, times from
+# power-on: PWR, NEXT, SIDE, FIRE (1 down, 0 up), LIMIT (1 attached), ALT
+# (mm), and a last "t_ms END". A trace is one "t_ms STATE id" or "t_ms TX
+# attempt" line per state entry and burst.
+#
+# Both traces must hold the same events in the same order, or the exit
+# status is 1. Each event is then timed by its step, the time since the
+# event before it, so one slower step does not move every later event too.
+# With --limit, a step that differs by more than that many ms also fails.
+
+import argparse
+import sys
+
+INPUTS = ("PWR", "NEXT", "SIDE", "FIRE", "LIMIT", "ALT")   # InputId order in DROP_MILES.cpp
+
+
+def load_scenario(path):
+    """[(t_ms, input, value)] with input None for END, checked like replay_parse()."""
+    steps = []
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            words = line.split("#", 1)[0].split()
+            if not words: continue
+            try:
+                t = int(words[0])
+                if len(words) == 2 and words[1] == "END": step = (t, None, 0)
+                elif len(words) == 3 and words[1] in INPUTS: step = (t, words[1], int(words[2]))
+                else: raise ValueError
+                if steps and (t < steps[-1][0] or steps[-1][1] is None): raise ValueError
+            except ValueError:
+                raise ValueError(f"{path}: line {n}: {line.strip()}") from None
+            steps.append(step)
+    if not steps or steps[-1][1] is not None: raise ValueError(f"{path}: no END")
+    return steps
+
+
+def read_trace(path):
+    """[(t_ms, event)] with event as "STATE ARMED_FLY" or "TX 0"."""
+    out = []
+    with open(path) as f:
+        for line in f:
+            words = line.split()
+            if len(words) == 3: out.append((float(words[0]), f"{words[1]} {words[2]}"))
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("a", help="trace to compare against, e.g. the firmware's")
+    ap.add_argument("b")
+    ap.add_argument("--limit", type=float, help="allowed step difference in ms")
+    args = ap.parse_args()
+
+    a, b = read_trace(args.a), read_trace(args.b)
+    print(f"{'event':<22} {'a ms':>10} {'b ms':>10} {'a step':>9} {'b step':>9} {'b - a':>8}")
+    bad = []
+    prev_a = prev_b = 0.0
+    for i in range(max(len(a), len(b))):
+        if i >= len(a) or i >= len(b) or a[i][1] != b[i][1]:
+            ea = a[i][1] if i < len(a) else "(end)"
+            eb = b[i][1] if i < len(b) else "(end)"
+            print(f"event {i + 1} differs: {ea} vs {eb}")
+            bad.append(f"event {i + 1}")
+            break
+        (ta, ev), (tb, _) = a[i], b[i]
+        d = (tb - prev_b) - (ta - prev_a)
+        line = f"{ev:<22} {ta:>10.3f} {tb:>10.3f} {ta - prev_a:>9.3f} {tb - prev_b:>9.3f} {d:>+8.3f}"
+        if args.limit is not None and abs(d) > args.limit:
+            line += "  OVER"
+            bad.append(ev)
+        print(line)
+        prev_a, prev_b = ta, tb
+    if bad:
+        print(f"{len(bad)} difference(s): {', '.join(bad)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
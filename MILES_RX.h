@@ -0,0 +1,270 @@
+#ifndef MILES_RX_H
+#define MILES_RX_H
+
+/*
+  IR receiver: decodes incoming 11-bit MILES frames on the sense pin.
+
+  A state machine on the second PIO block times the receiver's envelope
+  output the way the scope does (MILES_SCOPE.h): one word per high segment
+  and per low segment, here at 0.5 us per cycle. A low segment longer than
+  a whole frame ends in an idle marker, and the program waits for the next
+  rising edge, which raises PIO IRQ 0 (the wake-up for rx_poll()).
+  DMA moves the words into a 1 KB ring; the CPU does nothing per edge.
+
+  rx_poll() turns the words back into pulses and samples 11 bins from each
+  frame's first rise, in the middle of each pulse slot. The 11-bit window
+  indexes rx_table, built from the registry by rx_table_add() for both
+  sides, so matching is one lookup. A code whose first bins are 0 matches
+  on its bins from the first '1' on; the bins after it belong to the next
+  frame, which lets back-to-back frames (no gap) decode at full bin rate.
+  Longer codes have no table entry and decode as unmatched windows.
+*/
+
+#include <Arduino.h>
+#include <string.h>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "MILES_CODES_H.h"   // MILES_FRAME_BITS, same name as the sketch
+
+// -------------------- PIO program --------------------
+//   0: pull block          ; idle timeout in loop passes, once
+//   1: wait 0 pin 0
+//   2: wait 1 pin 0        ; first rising edge after idle
+//   3: irq nowait 0
+//   4: mov x, ~null        ; high segment (wrap target)
+//   5: jmp x-- 6
+//   6: jmp pin 5
+//   7: in x, 32            ; autopush
+//   8: mov y, osr          ; low segment, at most the timeout
+//   9: jmp pin 13
+//  10: jmp y-- 9
+//  11: in y, 32            ; timed out: y = 0xFFFFFFFF
+//  12: jmp 2
+//  13: in y, 32            ; wrap
+static const uint16_t miles_rx_program_instructions[] = {
+  0x80a0, 0x2020, 0x20a0, 0xc000, 0xa02b, 0x0046, 0x00c5,
+  0x4020, 0xa047, 0x00cd, 0x0089, 0x4040, 0x0002, 0x4040
+};
+static const pio_program_t miles_rx_program = {
+  miles_rx_program_instructions,
+  sizeof(miles_rx_program_instructions) / sizeof(miles_rx_program_instructions[0]),
+  -1
+};
+const uint32_t RX_WRAP_TARGET   = 4;
+const uint32_t RX_HIGH_CYCLES   = 2;       // high: 2k + 2 cycles for ~word = k
+const uint32_t RX_LOW_CYCLES    = 3;       // low: 2j + 3 cycles for word = timeout - j
+const uint32_t RX_CYCLES_PER_US = 2;
+const uint32_t RX_IDLE          = 0xFFFFFFFFu;
+
+const uint32_t RX_RING_BITS  = 10;         // 1 KB: 256 segments, 64 ms of back-to-back frames
+const uint32_t RX_RING_WORDS = (1u << RX_RING_BITS) / 4;
+const uint32_t RX_DMA_COUNT  = 0xFFFFFFFFu;
+const uint32_t RX_REARM      = 0x80000000u;   // words before the DMA count is reset (when idle)
+const uint8_t  RX_PULSES     = 32;         // pulses waiting for their frame to complete
+const uint8_t  RX_GROUPS     = 8;          // frame-group start stamps not yet consumed
+const uint32_t RX_TABLE_SIZE = 1u << MILES_FRAME_BITS;
+const uint8_t  RX_NONE       = 0xFF;       // no code / slot
+
+typedef struct {
+  uint32_t t_us;         // start of bin 0
+  uint16_t bits;         // bit i = bin i: the matched code, else the sampled window
+  uint8_t  slot;         // as passed to rx_table_add(), RX_NONE if nothing matched
+} RxFrame;
+
+typedef void (*rx_start_cb_t)(void);
+
+static PIO  rx_pio = pio1;
+const uint  RX_IRQ = PIO1_IRQ_0;
+static int  rx_sm = -1;
+static int  rx_dma = -1;
+static uint32_t rx_raw[RX_RING_WORDS] __attribute__((aligned(1 << RX_RING_BITS)));
+static rx_start_cb_t rx_start_cb = nullptr;
+
+static uint8_t rx_table[RX_TABLE_SIZE];    // 11-bit window -> slot
+static uint8_t rx_lead[RX_NONE];           // per slot: '0' bins before the first '1'
+
+// Decoder, core 0 only. Times are PIO cycles since the group's first rise.
+typedef struct { uint32_t rise, fall; } RxPulse;
+static uint32_t rx_timeout = 0;            // low-loop passes before the idle marker
+static uint32_t rx_bin_us = 0, rx_bin_cyc = 0, rx_mid_cyc = 0;
+static uint32_t rx_read = 0;               // ring words consumed (DMA write count)
+static bool     rx_synced = true;          // false after an overrun, until the next idle marker
+static bool     rx_in_group = false;
+static bool     rx_high_next = true;
+static uint32_t rx_t = 0;                  // end of the last segment
+static uint32_t rx_base_us = 0;            // time of the group's first rise
+static RxPulse  rx_pulse[RX_PULSES];
+static uint8_t  rx_np = 0;
+static uint32_t rx_frames = 0, rx_overruns = 0;
+
+static volatile uint32_t rx_group_us[RX_GROUPS];
+static volatile uint32_t rx_groups_head = 0;   // written by the IRQ
+static uint32_t rx_groups_tail = 0;
+
+// -------------------- Code table --------------------
+static void rx_table_clear() {
+  memset(rx_table, RX_NONE, sizeof(rx_table));
+}
+
+// Adds a standard-length code under `slot`. A window that two codes share
+// goes to the one with fewer leading '0' bins (the longer match). Returns
+// false for codes the table cannot hold.
+static bool rx_table_add(uint8_t slot, uint64_t bits, uint8_t len) {
+  if (slot == RX_NONE || len != MILES_FRAME_BITS || bits == 0) return false;
+  uint8_t f = 0;
+  while (!((bits >> f) & 1)) f++;
+  uint8_t n = MILES_FRAME_BITS - f;
+  uint32_t s = (uint32_t)(bits >> f);
+  rx_lead[slot] = f;
+  for (uint32_t hi = 0; hi < (1u << f); hi++) {
+    uint8_t &e = rx_table[s | (hi << n)];
+    if (e == RX_NONE || rx_lead[e] > f) e = slot;
+  }
+  return true;
+}
+
+// -------------------- Capture --------------------
+static void rx_pio_irq() {
+  if (!pio_interrupt_get(rx_pio, 0)) return;
+  pio_interrupt_clear(rx_pio, 0);
+  uint32_t h = rx_groups_head;
+  rx_group_us[h % RX_GROUPS] = (uint32_t)time_us_64();
+  rx_groups_head = h + 1;
+  if (rx_start_cb) rx_start_cb();
+}
+
+static void rx_dma_start() {
+  dma_channel_config d = dma_channel_get_default_config(rx_dma);
+  channel_config_set_transfer_data_size(&d, DMA_SIZE_32);
+  channel_config_set_read_increment(&d, false);
+  channel_config_set_write_increment(&d, true);
+  channel_config_set_ring(&d, true, RX_RING_BITS);
+  channel_config_set_dreq(&d, pio_get_dreq(rx_pio, rx_sm, false));
+  dma_channel_configure(rx_dma, &d, rx_raw, &rx_pio->rxf[rx_sm], RX_DMA_COUNT, true);
+  rx_read = 0;
+}
+
+// Like scope_init(), leaves the pin's function alone. on_start runs in IRQ
+// context at the first edge of each frame group.
+static bool rx_init(uint8_t pin, uint32_t bin_us, uint32_t pulse_us, rx_start_cb_t on_start) {
+  if (!pio_can_add_program(rx_pio, &miles_rx_program)) return false;
+  uint offset = pio_add_program(rx_pio, &miles_rx_program);
+  rx_sm = pio_claim_unused_sm(rx_pio, false);
+  rx_dma = dma_claim_unused_channel(false);
+  if (rx_sm < 0 || rx_dma < 0) { rx_sm = -1; return false; }
+
+  rx_bin_us  = bin_us;
+  rx_bin_cyc = bin_us * RX_CYCLES_PER_US;
+  rx_mid_cyc = pulse_us * RX_CYCLES_PER_US / 2;
+  rx_timeout = (MILES_FRAME_BITS * rx_bin_cyc - RX_LOW_CYCLES) / 2;
+  rx_start_cb = on_start;
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, offset + RX_WRAP_TARGET, offset + miles_rx_program.length - 1);
+  sm_config_set_in_pins(&c, pin);
+  sm_config_set_jmp_pin(&c, pin);
+  sm_config_set_in_shift(&c, false, true, 32);   // autopush every word
+  sm_config_set_clkdiv(&c, (float)clock_get_hz(clk_sys) / (RX_CYCLES_PER_US * 1000000.0f));
+  pio_sm_init(rx_pio, rx_sm, offset, &c);
+  pio_sm_put(rx_pio, rx_sm, rx_timeout);         // the program's first pull
+  rx_dma_start();
+
+  pio_set_irq0_source_enabled(rx_pio, pis_interrupt0, true);
+  irq_add_shared_handler(RX_IRQ, rx_pio_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(RX_IRQ, true);
+  pio_sm_set_enabled(rx_pio, rx_sm, true);
+  return true;
+}
+
+// -------------------- Decoder --------------------
+// Samples the frame starting at the oldest pending pulse, reports it and
+// drops its pulses.
+template <typename Emit>
+static void rx_decode_head(Emit &emit) {
+  uint32_t r0 = rx_pulse[0].rise;
+  uint32_t w = 0;
+  uint8_t p = 0;
+  for (uint8_t i = 0; i < MILES_FRAME_BITS; i++) {
+    uint32_t m = r0 + i * rx_bin_cyc + rx_mid_cyc;
+    while (p < rx_np && rx_pulse[p].fall <= m) p++;
+    if (p < rx_np && rx_pulse[p].rise <= m) w |= 1u << i;
+  }
+  RxFrame f;
+  f.slot = rx_table[w];
+  uint8_t lead = f.slot == RX_NONE ? 0 : rx_lead[f.slot];
+  uint8_t n = MILES_FRAME_BITS - lead;
+  f.bits = (uint16_t)((w & ((1u << n) - 1)) << lead);
+  f.t_us = rx_base_us + r0 / RX_CYCLES_PER_US - lead * rx_bin_us;
+  rx_frames++;
+  emit(f);
+
+  uint32_t end = r0 + n * rx_bin_cyc - rx_bin_cyc / 2;   // the next frame's first rise is at or after n bins
+  uint8_t k = 0;
+  while (k < rx_np && rx_pulse[k].rise < end) k++;
+  memmove(rx_pulse, rx_pulse + k, (rx_np - k) * sizeof(rx_pulse[0]));
+  rx_np -= k;
+}
+
+template <typename Emit>
+static void rx_word(uint32_t w, Emit &emit) {
+  if (!rx_in_group) {                      // words start with a high after every idle marker
+    uint32_t h = rx_groups_head;
+    if (h - rx_groups_tail > RX_GROUPS) rx_groups_tail = h - RX_GROUPS;
+    rx_base_us = rx_groups_tail != h ? rx_group_us[rx_groups_tail++ % RX_GROUPS] : (uint32_t)time_us_64();
+    rx_in_group = true;
+    rx_high_next = true;
+    rx_t = 0;
+    rx_np = 0;
+  }
+  bool idle = false;
+  if (rx_high_next) {
+    uint32_t len = 2 * ~w + RX_HIGH_CYCLES;
+    if (rx_np == RX_PULSES) rx_decode_head(emit);   // noise: no frame completes
+    rx_pulse[rx_np++] = RxPulse{ rx_t, rx_t + len };
+    rx_t += len;
+  } else if (w == RX_IDLE) {
+    idle = true;
+  } else {
+    rx_t += 2 * (rx_timeout - w) + RX_LOW_CYCLES;
+  }
+  rx_high_next = !rx_high_next;
+
+  // A frame is complete once the line is known past its last bin's sample.
+  while (rx_np && (idle || rx_t > rx_pulse[0].rise + (MILES_FRAME_BITS - 1) * rx_bin_cyc + rx_mid_cyc))
+    rx_decode_head(emit);
+  if (idle) rx_in_group = false;
+}
+
+// Core 0: decodes everything the DMA has written since the last call and
+// calls emit(const RxFrame &) per frame.
+template <typename Emit>
+static void rx_poll(Emit emit) {
+  if (rx_sm < 0) return;
+  uint32_t written = RX_DMA_COUNT - dma_channel_hw_addr(rx_dma)->transfer_count;
+  if (written - rx_read > RX_RING_WORDS) {   // lapped: resynchronize on the next idle marker
+    rx_overruns++;
+    rx_read = written - RX_RING_WORDS;
+    rx_synced = false;
+    rx_in_group = false;
+    rx_groups_tail = rx_groups_head;
+  }
+  while (rx_read != written) {
+    uint32_t w = rx_raw[rx_read++ % RX_RING_WORDS];
+    if (rx_synced) rx_word(w, emit);
+    else if (w == RX_IDLE) rx_synced = true;   // highs are never all ones
+  }
+  if (!rx_in_group && rx_synced && written >= RX_REARM) {
+    dma_channel_abort(rx_dma);             // new words wait in the RX FIFO meanwhile
+    rx_dma_start();
+  }
+}
+
+// True while a frame group has started or is open: poll again before the
+// ring can fill.
+static bool rx_busy() {
+  return rx_in_group || !rx_synced || rx_groups_head != rx_groups_tail;
+}
+
+#endif // MILES_RX_H
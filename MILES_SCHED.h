@@ -0,0 +1,86 @@
+#ifndef MILES_SCHED_H
+#define MILES_SCHED_H
+
+/*
+  Tickless event scheduler for core 0.
+
+  Input sampling ISRs, one-shot alarms, the TX/RX IRQs and core 1 post small
+  events into one MPSC ring (MILES_QUEUE.h); it is the only way into the
+  FSM. loop() drains it, re-evaluates the FSM and then sleeps in WFE until
+  the next post.
+  Every post ends with SEV, so an event that lands between the empty check
+  and the WFE still wakes the core. loop() has no polling period: input
+  latency is one sample tick (MILES_INPUT.h) + one loop pass, and timed
+  states wake on their alarm.
+*/
+
+#include <Arduino.h>
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "MILES_QUEUE.h"
+
+enum EventType : uint8_t {
+  EV_NONE = 0,
+  EV_PRESS,        // debounced input became active   (arg = input id)
+  EV_RELEASE,      // debounced input became inactive (arg = input id)
+  EV_LONG_PRESS,   // input held for its long_press_ms (arg = input id)
+  EV_TX_DONE,      // PIO end-of-frame (wakes core 0; the completion itself is latched)
+  EV_RX,           // IR receiver: first edge of a frame group
+  EV_TIMER,        // timed-state deadline (arg = timer id)
+  EV_INJECT        // core 1, GUI bridge: drive an input (arg = input id, val = level / mm)
+};
+
+typedef struct {
+  EventType type;
+  uint8_t   arg;
+  int16_t   val;
+  uint32_t  t_us;  // when it was posted
+} Event;
+
+const uint32_t SCHED_QUEUE_SIZE = 32;       // power of two
+
+static MpscQueue<Event, SCHED_QUEUE_SIZE> sched_queue;
+
+// Any core, thread or IRQ (producers may nest at different priorities).
+// False if the ring was full: the event is lost (counted in
+// sched_queue.dropped(), 't' on Serial), but the SEV still wakes core 0.
+static bool sched_post(EventType type, uint8_t arg = 0, int16_t val = 0) {
+  Event e;
+  e.type = type;
+  e.arg  = arg;
+  e.val  = val;
+  e.t_us = (uint32_t)time_us_64();
+  bool ok = sched_queue.push(e);
+  __sev();
+  return ok;
+}
+
+// Core 0 only.
+static bool sched_pop(Event &out) { return sched_queue.pop(out); }
+
+static bool sched_empty() { return sched_queue.empty(); }
+
+static int64_t sched_alarm_cb(alarm_id_t, void *user) {
+  uintptr_t v = (uintptr_t)user;
+  sched_post((EventType)(v & 0xff), (uint8_t)(v >> 8));
+  return 0;   // one-shot
+}
+
+// Posts (type, arg) after ms. Returns an id for sched_cancel(), or 0 if no
+// alarm slot was free (the caller's timed state then waits for the next event).
+static alarm_id_t sched_after_ms(uint32_t ms, EventType type, uint8_t arg = 0) {
+  alarm_id_t id = add_alarm_in_ms(ms, sched_alarm_cb, (void *)(uintptr_t)(type | (arg << 8)), true);
+  return id > 0 ? id : 0;
+}
+
+static void sched_cancel(alarm_id_t &id) {
+  if (id > 0) cancel_alarm(id);
+  id = 0;
+}
+
+// Sleeps until something has been posted.
+static void sched_wait() {
+  while (sched_empty()) __wfe();
+}
+
+#endif // MILES_SCHED_H
@@ -0,0 +1,175 @@
+#ifndef MILES_SCOPE_H
+#define MILES_SCOPE_H
+
+/*
+  Output self-test: a PIO edge timer on the TX pin.
+
+  A state machine on the second PIO block reads the pad of PIN_OUT. PIO
+  inputs see every GPIO, so there is no jumper and the pin keeps its TX
+  function. The program pushes one word per level segment (high, low,
+  high, ...) from the first rising edge on. DMA moves the words into
+  scope_raw. scope_arm() runs before each burst's DMA kick and
+  scope_stop() after the confirm window, so every shot is captured.
+
+  A word is ~k after k two-cycle loop passes. A high segment lasted
+  2k + 2 cycles and a low one 2k + 3. Every cycle is counted once, so
+  each edge lands within 2 cycles and the sum does not drift.
+
+  scope_report() compares the segments with the nominal pulses of the
+  burst. It prints the start and width error per '1' bin, the cumulative
+  drift and the worst-case jitter.
+*/
+
+#include <Arduino.h>
+#include <atomic>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "MILES_TX.h"
+
+// -------------------- PIO program --------------------
+//   0: wait 0 pin 0
+//   1: wait 1 pin 0 [1]   ; first rising edge
+//   2: mov x, ~null       ; high segment (wrap target)
+//   3: jmp x-- 4
+//   4: jmp pin 3
+//   5: in x, 32           ; autopush
+//   6: mov x, ~null       ; low segment
+//   7: jmp pin 9
+//   8: jmp x-- 7
+//   9: in x, 32           ; wrap
+static const uint16_t miles_scope_program_instructions[] = {
+  0x2020, 0x21a0, 0xa02b, 0x0044, 0x00c3, 0x4020, 0xa02b, 0x00c9, 0x0047, 0x4020
+};
+static const pio_program_t miles_scope_program = {
+  miles_scope_program_instructions,
+  sizeof(miles_scope_program_instructions) / sizeof(miles_scope_program_instructions[0]),
+  -1
+};
+const uint32_t SCOPE_WRAP_TARGET = 2;
+const uint32_t SCOPE_HIGH_CYCLES = 2;      // fixed part of a high segment
+const uint32_t SCOPE_LOW_CYCLES  = 3;
+const uint32_t SCOPE_RES_CYCLES  = 2;      // edge placement resolution
+const uint32_t SCOPE_MAX         = TX_MAX_WORDS;   // segments per capture
+
+// One nominal '1' bin, relative to the first pulse of the burst.
+typedef struct {
+  uint32_t rise_ns, width_ns;
+  uint8_t  frame, bin;
+} ScopePulse;
+
+static PIO  scope_pio = pio1;
+static int  scope_sm = -1;
+static int  scope_dma = -1;
+static uint scope_offset = 0;
+static pio_sm_config scope_cfg;
+static uint32_t scope_raw[SCOPE_MAX];
+static uint32_t scope_n = 0;               // segments in the last complete capture
+static std::atomic<uint32_t> scope_seq(0); // odd while a capture runs; written by core 0 only
+
+// Does not touch the pin's function: it stays on the TX state machine.
+static bool scope_init(uint8_t pin) {
+  if (!pio_can_add_program(scope_pio, &miles_scope_program)) return false;
+  scope_offset = pio_add_program(scope_pio, &miles_scope_program);
+  scope_sm = pio_claim_unused_sm(scope_pio, false);
+  scope_dma = dma_claim_unused_channel(false);
+  if (scope_sm < 0 || scope_dma < 0) { scope_sm = -1; return false; }
+
+  scope_cfg = pio_get_default_sm_config();
+  sm_config_set_wrap(&scope_cfg, scope_offset + SCOPE_WRAP_TARGET, scope_offset + miles_scope_program.length - 1);
+  sm_config_set_in_pins(&scope_cfg, pin);
+  sm_config_set_jmp_pin(&scope_cfg, pin);
+  sm_config_set_in_shift(&scope_cfg, false, true, 32);   // autopush every word
+  sm_config_set_fifo_join(&scope_cfg, PIO_FIFO_JOIN_RX);
+  sm_config_set_clkdiv(&scope_cfg, 1.0f);
+  return true;
+}
+
+// Core 0, while the pin is still low (before the TX guard segment ends).
+static void scope_arm() {
+  if (scope_sm < 0) return;
+  scope_seq.store(scope_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  pio_sm_set_enabled(scope_pio, scope_sm, false);
+  dma_channel_abort(scope_dma);
+  pio_sm_init(scope_pio, scope_sm, scope_offset, &scope_cfg);   // FIFOs cleared, PC at the first wait
+
+  dma_channel_config d = dma_channel_get_default_config(scope_dma);
+  channel_config_set_transfer_data_size(&d, DMA_SIZE_32);
+  channel_config_set_read_increment(&d, false);
+  channel_config_set_write_increment(&d, true);
+  channel_config_set_dreq(&d, pio_get_dreq(scope_pio, scope_sm, false));
+  dma_channel_configure(scope_dma, &d, scope_raw, &scope_pio->rxf[scope_sm], SCOPE_MAX, true);
+  pio_sm_set_enabled(scope_pio, scope_sm, true);
+}
+
+// Core 0, once the last falling edge is well past. The trailing low
+// segment never ends and is not part of the capture.
+static void scope_stop() {
+  if (scope_sm < 0) return;
+  pio_sm_set_enabled(scope_pio, scope_sm, false);
+  scope_n = SCOPE_MAX - dma_channel_hw_addr(scope_dma)->transfer_count;
+  dma_channel_abort(scope_dma);
+  scope_seq.store(scope_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Any core: the last complete capture as segment lengths in cycles.
+// copy() runs inside the same check, for whatever else describes the shot.
+// Returns 0 if there is none yet or a new capture started meanwhile.
+template <typename Copy>
+static uint32_t scope_snapshot(uint32_t *cycles, Copy copy) {
+  uint32_t s = scope_seq.load(std::memory_order_acquire);
+  if (s == 0 || (s & 1)) return 0;
+  uint32_t n = scope_n;
+  for (uint32_t i = 0; i < n; i++)
+    cycles[i] = 2 * ~scope_raw[i] + ((i & 1) ? SCOPE_LOW_CYCLES : SCOPE_HIGH_CYCLES);
+  copy();
+  return scope_seq.load(std::memory_order_acquire) == s ? n : 0;
+}
+
+template <typename Out>
+static void scope_print_signed(Out &out, int32_t v) {
+  if (v >= 0) out.print("+");
+  out.print(v);
+}
+
+// Edge times are taken from the first rising edge, on both sides. Errors
+// are measured minus nominal; jitter is the spread of all edge errors.
+template <typename Out>
+static void scope_report(Out &out, const uint32_t *cycles, uint32_t n,
+                         const ScopePulse *ideal, uint32_t n_ideal, uint32_t hz) {
+  uint32_t pulses = (n + 1) / 2;
+  out.print("scope: "); out.print(pulses); out.print(" pulses, ");
+  out.print(n_ideal); out.print(" expected, resolution ");
+  out.print((uint32_t)(SCOPE_RES_CYCLES * 1000000000ull / hz)); out.println(" ns");
+
+  uint32_t m = pulses < n_ideal ? pulses : n_ideal;
+  uint64_t t = 0;                          // cycles since the first rising edge
+  int32_t emin = 0, emax = 0, drift = 0;
+  uint32_t wmax = 0;
+  for (uint32_t j = 0; j < m; j++) {
+    int32_t start = (int32_t)(t * 1000000000ull / hz) - (int32_t)ideal[j].rise_ns;
+    int32_t width = (int32_t)(cycles[2 * j] * 1000000000ull / hz) - (int32_t)ideal[j].width_ns;
+    drift = start + width;                 // error of the falling edge
+    if (start < emin) emin = start;
+    if (start > emax) emax = start;
+    if (drift < emin) emin = drift;
+    if (drift > emax) emax = drift;
+    uint32_t aw = width < 0 ? (uint32_t)-width : (uint32_t)width;
+    if (aw > wmax) wmax = aw;
+
+    out.print("  f"); out.print(ideal[j].frame);
+    out.print(" b"); out.print(ideal[j].bin);
+    if (ideal[j].bin < 10) out.print(" ");
+    out.print("  start "); scope_print_signed(out, start);
+    out.print(" ns  width "); scope_print_signed(out, width);
+    out.println(" ns");
+    t += cycles[2 * j] + (2 * j + 1 < n ? cycles[2 * j + 1] : 0);
+  }
+  out.print("scope: edge error "); scope_print_signed(out, emin);
+  out.print(".."); scope_print_signed(out, emax);
+  out.print(" ns, jitter "); out.print(emax - emin);
+  out.print(" ns p-p, drift "); scope_print_signed(out, drift);
+  out.print(" ns at last edge, width error max "); out.print(wmax);
+  out.println(" ns");
+}
+
+#endif // MILES_SCOPE_H
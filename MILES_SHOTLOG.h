@@ -0,0 +1,167 @@
+#ifndef MILES_SHOTLOG_H
+#define MILES_SHOTLOG_H
+
+/*
+  Persistent shot log: one 16-byte record per burst, in a flash ring right
+  after the registry sector (FS region, see MILES_JOURNAL.h).
+
+  A record holds the protocol id, side, millis() at TX, confirm latency,
+  bit errors and the echo result, plus a sequence number that keeps rising
+  across power cycles and a boot number (mod 256) to group the shots of one
+  run. A CRC-16 over the rest of the record rejects blank and torn slots.
+  Records are collected in RAM and programmed a page at a time by
+  shotlog_flush(), so a typical session costs one page program and, when
+  the ring enters a new sector, one erase. Records still in RAM at power
+  loss are lost; the caller flushes as soon as the unit is idle.
+
+  On boot the ring is scanned for the newest valid record. Reading it back
+  (shotlog_at) walks from the oldest slot, skipping blank or torn ones.
+  Single user: core 1.
+*/
+
+#include <Arduino.h>
+#include <cstddef>
+#include "MILES_JOURNAL.h"
+#include "MILES_REGISTRY.h"
+
+const uint32_t SHOTLOG_SECTORS = 8;
+const uint32_t SHOTLOG_BYTES   = SHOTLOG_SECTORS * FLASH_SECTOR_SIZE;
+
+enum ShotFlags : uint8_t {
+  SHOT_OPFOR     = 1,
+  SHOT_CONFIRMED = 2,                  // self-sense saw at least one frame
+  SHOT_NO_TX     = 4,                  // no TX engine: nothing went on air
+  SHOT_RETRY     = 8                   // resent after a failed echo check
+};
+
+typedef struct {
+  uint32_t seq;                        // 0xFFFFFFFF = erased slot
+  uint32_t t_ms;                       // millis() at TX, since `boot`
+  uint16_t latency_us;                 // first echo edge vs. first pulse, 0xFFFF = none
+  uint8_t  boot;                       // power cycles since the log was created, mod 256
+  uint8_t  pid;
+  uint8_t  flags;                      // ShotFlags
+  uint8_t  bit_errors;
+  uint16_t crc;                        // CRC-16/CCITT of the fields above
+} ShotRecord;
+static_assert(sizeof(ShotRecord) == 16, "shot record must stay 16 bytes");
+static_assert(offsetof(ShotRecord, crc) == 14, "no padding ahead of the CRC");
+static_assert(FLASH_PAGE_SIZE % sizeof(ShotRecord) == 0, "records must not straddle pages");
+
+const uint32_t SHOTLOG_SLOTS   = SHOTLOG_BYTES / sizeof(ShotRecord);
+const uint32_t SHOTLOG_PENDING = FLASH_PAGE_SIZE / sizeof(ShotRecord);   // RAM records before a flush
+
+static uint32_t   shotlog_base = 0;      // flash offset of the ring
+static uint32_t   shotlog_next = 0;      // slot for the next record
+static uint32_t   shotlog_seq  = 0;      // seq of the newest record
+static uint8_t    shotlog_boot = 0;      // this power cycle
+static bool       shotlog_ok   = false;
+static ShotRecord shotlog_ram[SHOTLOG_PENDING];
+static uint32_t   shotlog_ram_n = 0;
+static uint32_t   shotlog_dropped = 0;   // records that found the RAM buffer full
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+static uint16_t shotlog_crc(const ShotRecord *r) {
+  const uint8_t *p = (const uint8_t *)r;
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < offsetof(ShotRecord, crc); i++) {
+    crc ^= (uint16_t)(p[i] << 8);
+    for (uint8_t k = 0; k < 8; k++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+static const ShotRecord *shotlog_slot(uint32_t i) {
+  return (const ShotRecord *)(uintptr_t)(XIP_BASE + shotlog_base + i * sizeof(ShotRecord));
+}
+
+static bool shotlog_valid(const ShotRecord *r) {
+  return r->seq != 0xFFFFFFFFu && r->crc == shotlog_crc(r);
+}
+
+// Locates the ring behind the registry sector and picks up seq and boot
+// from the newest record.
+static bool shotlog_init() {
+  uint32_t start = (uint32_t)((uintptr_t)&_FS_start - XIP_BASE);
+  uint32_t end   = (uint32_t)((uintptr_t)&_FS_end - XIP_BASE);
+  shotlog_ok = registry_region_ok() && end - start >= JOURNAL_BYTES + FLASH_SECTOR_SIZE + SHOTLOG_BYTES;
+  if (!shotlog_ok) return false;
+  shotlog_base = registry_offset() + FLASH_SECTOR_SIZE;
+
+  bool have = false;
+  uint32_t newest = 0;
+  for (uint32_t i = 0; i < SHOTLOG_SLOTS; i++) {
+    const ShotRecord *r = shotlog_slot(i);
+    if (!shotlog_valid(r)) continue;
+    if (!have || (int32_t)(r->seq - shotlog_seq) > 0) { shotlog_seq = r->seq; newest = i; have = true; }
+  }
+  shotlog_next = have ? (newest + 1) % SHOTLOG_SLOTS : 0;
+  shotlog_boot = have ? (uint8_t)(shotlog_slot(newest)->boot + 1) : 0;
+  if (!have) shotlog_seq = 0;
+  shotlog_ram_n = 0;
+  return true;
+}
+
+// Queues one record in RAM; seq, boot and crc are filled in here.
+static bool shotlog_add(ShotRecord r) {
+  if (!shotlog_ok) return false;
+  if (shotlog_ram_n == SHOTLOG_PENDING) { shotlog_dropped++; return false; }
+  r.seq  = shotlog_seq + shotlog_ram_n + 1;
+  r.boot = shotlog_boot;
+  r.crc  = shotlog_crc(&r);
+  shotlog_ram[shotlog_ram_n++] = r;
+  return true;
+}
+
+static bool shotlog_pending() { return shotlog_ram_n != 0; }
+
+static bool shotlog_blank(uint32_t slot) {
+  const uint8_t *p = (const uint8_t *)shotlog_slot(slot);
+  for (size_t i = 0; i < sizeof(ShotRecord); i++) if (p[i] != 0xFF) return false;
+  return true;
+}
+
+// Programs the RAM records, one page per program call. A sector is erased
+// when the ring enters it; a dirty slot inside a sector (a torn write) is
+// skipped rather than erasing the records around it. Stalls both cores, so
+// only call it while the unit is idle.
+static bool shotlog_flush() {
+  if (!shotlog_ok) return false;
+  static uint8_t page[FLASH_PAGE_SIZE];   // 0xFF outside the new records leaves other slots untouched
+  while (shotlog_ram_n) {
+    uint32_t slot = shotlog_next;
+    uint32_t off  = shotlog_base + slot * sizeof(ShotRecord);
+    if (off % FLASH_SECTOR_SIZE == 0) flash_safe_erase(off, FLASH_SECTOR_SIZE);
+    else if (!shotlog_blank(slot)) { shotlog_next = (slot + 1) % SHOTLOG_SLOTS; continue; }
+
+    uint32_t n = 1;                          // blank slots left in this page
+    while (n < shotlog_ram_n && (off + n * sizeof(ShotRecord)) % FLASH_PAGE_SIZE && shotlog_blank(slot + n)) n++;
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page + off % FLASH_PAGE_SIZE, shotlog_ram, n * sizeof(ShotRecord));
+    flash_safe_program(off - off % FLASH_PAGE_SIZE, page, FLASH_PAGE_SIZE);
+
+    shotlog_next = (slot + n) % SHOTLOG_SLOTS;
+    uint32_t good = 0;
+    while (good < n && shotlog_valid(shotlog_slot(slot + good))) good++;
+    if (good) shotlog_seq = shotlog_ram[good - 1].seq;
+    shotlog_ram_n -= good;
+    memmove(shotlog_ram, shotlog_ram + good, shotlog_ram_n * sizeof(ShotRecord));
+    if (good < n) return false;              // the rest stays in RAM for fresh slots
+  }
+  return true;
+}
+
+// Records in read-back order: flash from the oldest slot, then RAM. i runs
+// 0..shotlog_span(); blank or torn slots return false and are skipped.
+static uint32_t shotlog_span() { return shotlog_ok ? SHOTLOG_SLOTS + shotlog_ram_n : 0; }
+
+static bool shotlog_at(uint32_t i, ShotRecord *out) {
+  if (i >= shotlog_span()) return false;
+  if (i >= SHOTLOG_SLOTS) { *out = shotlog_ram[i - SHOTLOG_SLOTS]; return true; }
+  const ShotRecord *r = shotlog_slot((shotlog_next + i) % SHOTLOG_SLOTS);
+  if (!shotlog_valid(r)) return false;
+  *out = *r;
+  return true;
+}
+
+#endif // MILES_SHOTLOG_H
@@ -0,0 +1,138 @@
+#ifndef MILES_TELEM_H
+#define MILES_TELEM_H
+
+/*
+  Compact binary telemetry, decoded on the host by MILES_TELEM.py.
+
+  Record layout (little-endian):
+    0xA5, len, type, payload[len - 1], crc8
+  len counts type + payload; crc8 (poly 0x07) covers len, type and payload.
+  Anything outside a record (boot messages, trace dumps) is plain ASCII,
+  which never contains the sync byte, so the decoder passes it through.
+
+  Records are encoded into a byte ring and sent with non-blocking writes of
+  at most availableForWrite() bytes, only when the caller says the link is
+  idle. Single producer and consumer: core 1.
+
+  Commands from the host (Serial GUI bridge) use the same framing with
+  their own type space (HostCmd). They share the port with the one-letter
+  text commands: a byte is only taken as a frame start while no frame is
+  in progress and it is the sync byte.
+*/
+
+#include <Arduino.h>
+
+const uint8_t  TELEM_SYNC      = 0xA5;
+const uint32_t TELEM_RING_SIZE = 512;      // power of two
+const uint8_t  TELEM_MAX_BODY  = 32;       // type + payload
+
+enum TelemType : uint8_t {
+  TM_STATE = 1,    // u32 t_us, u8 state, u32 shot_count
+  TM_TX    = 2,    // u32 t_us, u8 bitlen, u64 bits (bit i = frame bit i)
+  TM_ECHO  = 3,    // u32 t_us, u8 seen, u8 bit_errors, u32 latency_us
+  TM_TEXT  = 4,    // ASCII, no terminator
+  TM_WAKE  = 5,    // u32 t_us (wake edge), u32 wake_us (edge to inputs live), u32 standby_ms
+  TM_RX    = 6,    // u32 t_us (bin 0), u16 bits, u8 pid, u8 side, u8 flags (1 matched, 2 own echo, 4 friendly)
+  TM_SHOT  = 7,    // u32 seq, u32 t_ms, u16 boot, u16 latency_us, u8 pid, u8 flags (1 OPFOR, 2 confirmed, 4 no TX, 8 retry), u8 bit_errors
+  TM_UI    = 8,    // u32 t_ms, u8 state, u8 index, u8 pid, u8 flags (1 OPFOR, 2 limit, 4 alt, 8 confirmed), u8 bit_errors,
+                   // u32 shot_count, u32 flash_ms, u32 confirmed_ms, u32 expended_ms (all ms on the t_ms clock)
+  TM_BOOT  = 9,    // u32 armable_us, u32 first_frame_us, u32 usb_us (all since reset)
+  TM_FUSE  = 10    // u32 t_us, u8 signal (0 released, 1 at altitude), u8 sources (1 limit, 2 free fall,
+                   // 4 range, 8 fall time), u32 latency_us, u16 fall_ms, u16 peak_mg
+};
+
+enum HostCmd : uint8_t {
+  HC_MIRROR = 1,   // u8 on: send TM_UI whenever the GUI changes
+  HC_INJECT = 2    // n x (u8 input id, i16 value); see inject_event() in DROP_MILES.cpp
+};
+
+static uint8_t  telem_ring[TELEM_RING_SIZE];
+static uint32_t telem_head = 0, telem_tail = 0;   // free-running byte counts
+static uint32_t telem_dropped = 0;                 // records that did not fit
+
+static uint8_t telem_crc8(const uint8_t *p, size_t n, uint8_t crc = 0) {
+  while (n--) {
+    crc ^= *p++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+// Builds one record body in place; put_*() append little-endian fields.
+typedef struct {
+  uint8_t  b[TELEM_MAX_BODY];
+  uint8_t  n;
+} TelemBody;
+
+static inline void telem_begin(TelemBody &r, TelemType t) { r.b[0] = t; r.n = 1; }
+static inline void telem_put(TelemBody &r, uint64_t v, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes && r.n < TELEM_MAX_BODY; i++) r.b[r.n++] = (uint8_t)(v >> (8 * i));
+}
+
+// Queues a whole record or nothing.
+static bool telem_commit(const TelemBody &r) {
+  if (TELEM_RING_SIZE - (telem_head - telem_tail) < (uint32_t)r.n + 3) { telem_dropped++; return false; }
+  uint8_t len = r.n;
+  uint8_t crc = telem_crc8(r.b, r.n, telem_crc8(&len, 1));
+  telem_ring[telem_head++ % TELEM_RING_SIZE] = TELEM_SYNC;
+  telem_ring[telem_head++ % TELEM_RING_SIZE] = len;
+  for (uint8_t i = 0; i < r.n; i++) telem_ring[telem_head++ % TELEM_RING_SIZE] = r.b[i];
+  telem_ring[telem_head++ % TELEM_RING_SIZE] = crc;
+  return true;
+}
+
+static bool telem_text(const char *s) {
+  TelemBody r;
+  telem_begin(r, TM_TEXT);
+  while (*s && r.n < TELEM_MAX_BODY) r.b[r.n++] = (uint8_t)*s++;
+  return telem_commit(r);
+}
+
+// Incoming frame decoder, one byte at a time. A bad length or CRC drops the
+// frame; the caller resets stale partial frames with telem_rx_reset().
+typedef struct {
+  uint8_t b[TELEM_MAX_BODY];           // type + payload once complete
+  uint8_t len, n, stage;               // stage: 0 idle, 1 length, 2 body, 3 crc
+} TelemRx;
+
+static inline bool telem_rx_busy(const TelemRx &p) { return p.stage != 0; }
+static inline void telem_rx_reset(TelemRx &p) { p.stage = 0; }
+
+// Returns true when c completed a valid frame (body in p.b[0 .. p.len)).
+static bool telem_rx_byte(TelemRx &p, uint8_t c) {
+  switch (p.stage) {
+    case 0: if (c == TELEM_SYNC) p.stage = 1; return false;
+    case 1:
+      if (c == 0 || c > TELEM_MAX_BODY) { p.stage = 0; return false; }
+      p.len = c; p.n = 0; p.stage = 2;
+      return false;
+    case 2:
+      p.b[p.n++] = c;
+      if (p.n == p.len) p.stage = 3;
+      return false;
+    default:
+      p.stage = 0;
+      return c == telem_crc8(p.b, p.len, telem_crc8(&p.len, 1));
+  }
+}
+
+static bool telem_empty() { return telem_head == telem_tail; }
+static uint32_t telem_room() { return TELEM_RING_SIZE - (telem_head - telem_tail); }
+
+// Writes what the port can take right now without blocking.
+template <typename Port>
+static void telem_flush(Port &port) {
+  while (!telem_empty()) {
+    int room = port.availableForWrite();
+    if (room <= 0) return;
+    uint32_t off = telem_tail % TELEM_RING_SIZE;
+    uint32_t n = telem_head - telem_tail;
+    if (n > TELEM_RING_SIZE - off) n = TELEM_RING_SIZE - off;   // up to the wrap
+    if (n > (uint32_t)room) n = (uint32_t)room;
+    size_t sent = port.write(telem_ring + off, n);
+    if (sent == 0) return;
+    telem_tail += sent;
+  }
+}
+
+#endif // MILES_TELEM_H
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# Host decoder for the firmware's binary telemetry (MILES_TELEM.h).
+#
+# Usage:
+#   python3 MILES_TELEM.py /dev/ttyACM0     # live, needs pyserial
+#   python3 MILES_TELEM.py capture.bin      # a raw capture of the port
+#   cat /dev/ttyACM0 | python3 MILES_TELEM.py -
+#
+# Records are printed one per line; plain text between records (boot
+# messages, the 't' trace dump) is passed through unchanged.
+
+import os
+import struct
+import sys
+
+from MILES_GUI import STATE_NAMES   # same MILES_FSM.h parse as the simulator
+
+SYNC = 0xA5
+TM_STATE, TM_TX, TM_ECHO, TM_TEXT, TM_WAKE, TM_RX, TM_SHOT, TM_UI, TM_BOOT, TM_FUSE = 1, 2, 3, 4, 5, 6, 7, 8, 9, 10
+HC_MIRROR, HC_INJECT = 1, 2          # host -> device commands, same framing
+UI_FORMAT = "<IBBBBBIIII"            # TM_UI payload
+
+
+def crc8(data, crc=0):
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_record(rtype, payload=b""):
+    body = bytes([rtype]) + bytes(payload)
+    return bytes([SYNC, len(body)]) + body + bytes([crc8(body, crc8(bytes([len(body)])))])
+
+
+def format_record(rtype, p):
+    if rtype == TM_STATE:
+        t, state, shots = struct.unpack_from("<IBI", p)
+        return f"{t:>10} us  STATE {STATE_NAMES.get(state, state)}  shots={shots}"
+    if rtype == TM_TX:
+        t, n, bits = struct.unpack_from("<IBQ", p)
+        frame = "".join("1" if (bits >> i) & 1 else "0" for i in range(n))
+        return f"{t:>10} us  TX    {frame}"
+    if rtype == TM_ECHO:
+        t, seen, errors, latency = struct.unpack_from("<IBBI", p)
+        return f"{t:>10} us  ECHO  {'seen' if seen else 'none'} errors={errors} latency_us={latency}"
+    if rtype == TM_WAKE:
+        t, wake, slept = struct.unpack_from("<III", p)
+        return f"{t:>10} us  WAKE  after {slept} ms standby, responsive in {wake} us"
+    if rtype == TM_RX:
+        t, bits, pid, side, flags = struct.unpack_from("<IHBBB", p)
+        frame = "".join("1" if (bits >> i) & 1 else "0" for i in range(11))
+        if not flags & 1:
+            return f"{t:>10} us  RX    {frame}  no match"
+        kind = "own echo" if flags & 2 else ("friendly" if flags & 4 else "HIT")
+        return f"{t:>10} us  RX    {frame}  id={pid} {'OPFOR' if side else 'BLUFOR'} {kind}"
+    if rtype == TM_SHOT:
+        seq, t_ms, boot, latency, pid, flags, errors = struct.unpack_from("<IIHHBBB", p)
+        side = "OPFOR" if flags & 1 else "BLUFOR"
+        if flags & 4: result = "no TX"
+        elif flags & 2: result = f"confirmed latency_us={latency} errors={errors}"
+        else: result = "unconfirmed"
+        retry = "  (retry)" if flags & 8 else ""
+        return f"SHOT {seq:>6}  boot {boot} +{t_ms} ms  id={pid} {side}  {result}{retry}"
+    if rtype == TM_UI:
+        t, state, index, pid, flags, errors, shots, _flash, _conf, _exp = struct.unpack_from(UI_FORMAT, p)
+        return (f"{t:>10} ms  UI    {STATE_NAMES.get(state, state)}  id={pid} {'OPFOR' if flags & 1 else 'BLUFOR'}"
+                f"  LIM={'ON' if flags & 2 else 'OFF'} ALT={'YES' if flags & 4 else 'NO'} shots={shots}")
+    if rtype == TM_BOOT:
+        armable, frame, usb = struct.unpack_from("<III", p)
+        return f"BOOT  armable at {armable} us, first frame at {frame} us, USB at {usb} us"
+    if rtype == TM_FUSE:
+        t, signal, sources, latency, fall, peak = struct.unpack_from("<IBBIHH", p)
+        names = [n for bit, n in ((1, "limit"), (2, "free fall"), (4, "range"), (8, "fall time")) if sources & bit]
+        return (f"{t:>10} us  FUSE  {'at altitude' if signal else 'released'} from {'+'.join(names) or 'none'}"
+                f" in {latency} us, fall {fall} ms, peak {peak} mg")
+    if rtype == TM_TEXT:
+        return "LOG   " + p.decode("ascii", "replace")
+    return f"?type {rtype}: {p.hex()}"
+
+
+class Decoder:
+    """Feeds bytes in, yields ('record', text) / ('text', str) items."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        for kind, item in self.feed_raw(data):
+            if kind == "text":
+                yield kind, item
+                continue
+            try:
+                yield "record", format_record(*item)
+            except struct.error:
+                self.bad += 1
+
+    def feed_raw(self, data):
+        """As feed(), but records come out as (type, payload bytes)."""
+        self.buf += data
+        while self.buf:
+            i = self.buf.find(SYNC)
+            if i != 0:
+                text = self.buf if i < 0 else self.buf[:i]
+                yield "text", text.decode("ascii", "replace")
+                del self.buf[:len(text)]
+                continue
+            if len(self.buf) < 2: return
+            n = self.buf[1]
+            if len(self.buf) < n + 3: return
+            body, crc = bytes(self.buf[2:2 + n]), self.buf[2 + n]
+            if n == 0 or crc8(body, crc8(bytes([n]))) != crc:
+                self.bad += 1
+                del self.buf[:1]   # resync on the next sync byte
+                continue
+            del self.buf[:n + 3]
+            yield "record", (body[0], body[1:])
+
+
+def open_source(arg):
+    if arg == "-":
+        return sys.stdin.buffer
+    if os.path.isfile(arg):
+        return open(arg, "rb")
+    import serial   # pyserial, only needed for a live port
+    return serial.Serial(arg, 115200, timeout=0.1)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: MILES_TELEM.py <port | file | ->", file=sys.stderr)
+        return 2
+    src = open_source(sys.argv[1])
+    dec = Decoder()
+    try:
+        while True:
+            data = src.read(256)
+            if not data:
+                if not hasattr(src, "in_waiting"): break   # end of file / pipe
+                continue
+            for kind, item in dec.feed(data):
+                if kind == "record": print(item)
+                else: sys.stdout.write(item)
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    if dec.bad: print(f"[{dec.bad} corrupt records skipped]", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,150 @@
+#ifndef MILES_TRACE_H
+#define MILES_TRACE_H
+
+/*
+  On-device latency tracing.
+
+  trace() stamps a point with the 64-bit microsecond timer into a ring owned
+  by the calling core. Each ring has exactly one writer (its core; IRQs on
+  that core are masked only for the slot claim), so the two cores never
+  contend and the hot path is a few stores. The reader takes a snapshot and
+  discards any slot the writer may have lapped meanwhile.
+
+  trace_dump() pairs points into the caller's span table and prints
+  min/p50/p99/max per span. Spans always start and end on the same core.
+*/
+
+#include <Arduino.h>
+#include <atomic>
+#include "hardware/sync.h"
+
+enum TracePoint : uint8_t {
+  TR_STATE = 0,    // FSM entered a state        (arg = State)
+  TR_PRESS,        // debounced input edge       (arg = input id)
+  TR_RELEASE,
+  TR_TX_START,     // DMA burst kicked            (arg = attempt, 0 = first)
+  TR_TX_END,       // PIO end-of-frame IRQ
+  TR_RETRY,        // echo check failed, resending (arg = attempt)
+  TR_SHOT_DONE,    // shot resolved               (arg = retries used)
+  TR_GUI_BEGIN,    // draw_gui() render
+  TR_GUI_END,
+  TR_FLUSH_BEGIN,  // display flush (DMA kick or blocking display())
+  TR_FLUSH_END,
+  TR_WAKE_EDGE,    // standby wake-up GPIO edge
+  TR_WAKE_READY    // inputs sampling again after standby
+};
+
+typedef struct {
+  uint64_t t_us;
+  TracePoint point;
+  uint8_t    arg;
+} TraceRecord;
+
+const uint32_t TRACE_DEPTH = 128;          // per core, power of two
+const uint8_t  TRACE_ANY   = 0xff;         // span arg wildcard
+
+typedef struct {
+  TraceRecord buf[TRACE_DEPTH];
+  std::atomic<uint32_t> head;              // records written (free-running)
+} TraceRing;
+
+static TraceRing trace_ring[2];
+
+static void trace_at(TracePoint p, uint8_t arg, uint64_t t_us) {
+  TraceRing &r = trace_ring[rp2040.cpuid() & 1];
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t h = r.head.load(std::memory_order_relaxed);
+  TraceRecord &rec = r.buf[h & (TRACE_DEPTH - 1)];
+  rec.t_us  = t_us;
+  rec.point = p;
+  rec.arg   = arg;
+  r.head.store(h + 1, std::memory_order_release);
+  restore_interrupts(irq);
+}
+
+static inline void trace(TracePoint p, uint8_t arg = 0) {
+  trace_at(p, arg, time_us_64());
+}
+
+// Converts a 32-bit event stamp (MILES_SCHED.h) taken within the last ~71
+// minutes back to the 64-bit timebase.
+static inline uint64_t trace_widen_us(uint32_t t32) {
+  uint64_t now = time_us_64();
+  return now - (uint32_t)((uint32_t)now - t32);
+}
+
+// One histogram: each end point is paired with the latest start before it.
+typedef struct {
+  const char *name;
+  TracePoint  start;
+  uint8_t     start_arg;
+  TracePoint  end;
+  uint8_t     end_arg;
+} TraceSpan;
+
+// Copies ring `core` oldest-first into out; returns the number of records
+// that were not overwritten while copying.
+static uint32_t trace_snapshot(uint8_t core, TraceRecord *out) {
+  TraceRing &r = trace_ring[core & 1];
+  uint32_t h1 = r.head.load(std::memory_order_acquire);
+  uint32_t first = h1 > TRACE_DEPTH ? h1 - TRACE_DEPTH : 0;
+  for (uint32_t i = first; i < h1; i++) out[i - first] = r.buf[i & (TRACE_DEPTH - 1)];
+  uint32_t h2 = r.head.load(std::memory_order_acquire);
+  // the writer may be filling slot h2, which aliases record h2 - TRACE_DEPTH
+  uint32_t safe = h2 >= TRACE_DEPTH ? h2 - TRACE_DEPTH + 1 : 0;
+  if (safe <= first) return h1 - first;
+  if (safe >= h1) return 0;
+  memmove(out, out + (safe - first), (h1 - safe) * sizeof(TraceRecord));
+  return h1 - safe;
+}
+
+static inline bool trace_match(const TraceRecord &r, TracePoint p, uint8_t arg) {
+  return r.point == p && (arg == TRACE_ANY || r.arg == arg);
+}
+
+static void trace_sort(uint32_t *v, uint32_t n) {   // insertion sort, n <= TRACE_DEPTH
+  for (uint32_t i = 1; i < n; i++) {
+    uint32_t x = v[i], j = i;
+    while (j > 0 && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+    v[j] = x;
+  }
+}
+
+// Prints one line per span: samples, min/p50/p99/max in microseconds. The
+// latest start before an end wins, so a start with no end is dropped.
+template <typename Out>
+static void trace_dump(Out &out, const TraceSpan *spans, size_t n_spans) {
+  static TraceRecord snap[2][TRACE_DEPTH];
+  static uint32_t samples[TRACE_DEPTH];
+  uint32_t len[2] = { trace_snapshot(0, snap[0]), trace_snapshot(1, snap[1]) };
+
+  for (size_t s = 0; s < n_spans; s++) {
+    const TraceSpan &sp = spans[s];
+    uint32_t n = 0;
+    for (uint8_t core = 0; core < 2; core++) {
+      bool open = false;
+      uint64_t t0 = 0;
+      for (uint32_t i = 0; i < len[core]; i++) {
+        const TraceRecord &r = snap[core][i];
+        if (trace_match(r, sp.end, sp.end_arg) && open) {
+          uint64_t d = r.t_us - t0;
+          if (n < TRACE_DEPTH) samples[n++] = d > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)d;
+          open = false;
+        }
+        if (trace_match(r, sp.start, sp.start_arg)) { open = true; t0 = r.t_us; }
+      }
+    }
+    out.print(sp.name); out.print(": n="); out.print(n);
+    if (n) {
+      trace_sort(samples, n);
+      out.print(" min="); out.print(samples[0]);
+      out.print(" p50="); out.print(samples[(n - 1) / 2]);
+      out.print(" p99="); out.print(samples[(n - 1) * 99 / 100]);
+      out.print(" max="); out.print(samples[n - 1]);
+      out.print(" us");
+    }
+    out.println();
+  }
+}
+
+#endif // MILES_TRACE_H
@@ -0,0 +1,196 @@
+#ifndef MILES_TX_H
+#define MILES_TX_H
+
+/*
+  PIO + DMA MILES transmitter.
+
+  A frame is precomputed into a pulse/space word buffer once; each word is
+    bit 31     : PIN_OUT level for this segment
+    bit 30     : last-segment flag (raises PIO IRQ 0 when the segment ends)
+    bits 29..0 : segment length in PIO cycles, minus TX_LOOP_OVERHEAD
+  DMA streams the buffer into the state machine's TX FIFO, the PIO holds each
+  level for exactly its cycle count, and the end-of-frame IRQ calls the
+  completion callback. tx_start() returns immediately.
+
+  A burst is several frames in one buffer separated by low gap segments
+  (tx_burst_begin/append/end), so the whole salvo is a single DMA transfer
+  and the CPU is not involved between frames.
+
+  Frames are 1..TX_MAX_BITS bins. tx_burst_append_fixed<N>() encodes a
+  length known at compile time with a fully unrolled loop, for the standard
+  word length; tx_burst_append() takes any length.
+*/
+
+#include <Arduino.h>
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+
+// -------------------- PIO program --------------------
+//   0: pull block
+//   1: out pins, 1      ; level
+//   2: out y, 1         ; last flag
+//   3: out x, 30        ; hold count
+//   4: jmp x-- 4
+//   5: jmp !y 0
+//   6: irq nowait 0     ; end of frame
+// Pin-to-pin period of one segment is (x + 6) cycles.
+static const uint16_t miles_tx_program_instructions[] = {
+  0x80a0, 0x6001, 0x6041, 0x603e, 0x0044, 0x0060, 0xc000
+};
+static const pio_program_t miles_tx_program = {
+  miles_tx_program_instructions,
+  sizeof(miles_tx_program_instructions) / sizeof(miles_tx_program_instructions[0]),
+  -1
+};
+const uint32_t TX_LOOP_OVERHEAD = 6;
+const uint32_t TX_LEVEL_BIT     = 1u << 31;
+const uint32_t TX_LAST_BIT      = 1u << 30;
+const uint32_t TX_COUNT_MASK    = TX_LAST_BIT - 1;
+
+// Leading low guard and trailing low segment (matches the old stub's 10 µs lead-in)
+const uint32_t TX_GUARD_US = 10;
+
+// Longest frame, and buffer room for a burst: worst case (pulse, space) per
+// bit + one gap per frame + guard + trailer. 256 words hold four 11-bit
+// frames or one 64-bit frame with room to spare.
+const size_t TX_MAX_BITS  = 64;
+const size_t TX_MAX_WORDS = 256;
+static_assert(TX_MAX_WORDS >= 2 * TX_MAX_BITS + 2, "TxBuffer must hold one maximum-length frame");
+
+typedef void (*tx_done_cb_t)(void);
+
+typedef struct {
+  uint32_t words[TX_MAX_WORDS];
+  size_t   len;
+} TxBuffer;
+
+static PIO  tx_pio = pio0;
+static int  tx_sm = -1;
+static int  tx_dma = -1;
+static uint32_t tx_cycles_per_us = 125;
+static volatile bool tx_busy = false;
+static volatile uint64_t tx_start_us = 0;
+static volatile uint64_t tx_end_us = 0;
+static tx_done_cb_t tx_done_cb = nullptr;
+
+static inline uint32_t tx_word(bool level, uint32_t us, bool last) {
+  uint32_t cyc = us * tx_cycles_per_us;
+  cyc = (cyc > TX_LOOP_OVERHEAD) ? cyc - TX_LOOP_OVERHEAD : 0;
+  return (level ? TX_LEVEL_BIT : 0) | (last ? TX_LAST_BIT : 0) | (cyc & TX_COUNT_MASK);
+}
+
+// Appends a segment, merging it into the previous one when the level matches.
+static void tx_push(TxBuffer *b, bool level, uint32_t us) {
+  uint32_t cyc = us * tx_cycles_per_us;
+  if (b->len > 0 && ((b->words[b->len - 1] & TX_LEVEL_BIT) != 0) == level) {
+    b->words[b->len - 1] += cyc;
+    return;
+  }
+  if (b->len < TX_MAX_WORDS) b->words[b->len++] = tx_word(level, us, false);
+}
+
+static void tx_burst_begin(TxBuffer *b) {
+  b->len = 0;
+  tx_push(b, false, TX_GUARD_US);
+}
+
+static inline void tx_push_bin(TxBuffer *b, bool one, uint32_t bin_us, uint32_t pulse_us) {
+  if (one) {
+    tx_push(b, true, pulse_us);
+    if (bin_us > pulse_us) tx_push(b, false, bin_us - pulse_us);
+  } else {
+    tx_push(b, false, bin_us);
+  }
+}
+
+// True if a bitlen-bin frame (plus its gap and the trailer) still fits.
+static inline bool tx_burst_room(const TxBuffer *b, size_t bitlen) {
+  return bitlen >= 1 && bitlen <= TX_MAX_BITS && b->len + 2 * bitlen + 2 <= TX_MAX_WORDS;
+}
+
+// Appends one frame's bins, preceded by gap_us of low (use 0 for the first
+// frame). Frame k's bin 0 therefore starts TX_GUARD_US + the sum of the
+// preceding frames' bins and gaps after TX start. Returns false (buffer
+// unchanged) if the frame does not fit.
+static bool tx_burst_append(TxBuffer *b, uint64_t bits, size_t bitlen, uint32_t bin_us, uint32_t pulse_us,
+                            uint32_t gap_us) {
+  if (!tx_burst_room(b, bitlen)) return false;
+  if (gap_us) tx_push(b, false, gap_us);
+  for (size_t i = 0; i < bitlen; i++) tx_push_bin(b, (bits >> i) & 1, bin_us, pulse_us);
+  return true;
+}
+
+template <size_t N>
+static bool tx_burst_append_fixed(TxBuffer *b, uint64_t bits, uint32_t bin_us, uint32_t pulse_us, uint32_t gap_us) {
+  static_assert(N >= 1 && N <= TX_MAX_BITS, "frame length out of range");
+  if (!tx_burst_room(b, N)) return false;
+  if (gap_us) tx_push(b, false, gap_us);
+#pragma GCC unroll 64
+  for (size_t i = 0; i < N; i++) tx_push_bin(b, (bits >> i) & 1, bin_us, pulse_us);
+  return true;
+}
+
+static void tx_burst_end(TxBuffer *b) {
+  if (b->len < TX_MAX_WORDS && (b->words[b->len - 1] & TX_LEVEL_BIT)) tx_push(b, false, TX_GUARD_US);
+  b->words[b->len - 1] |= TX_LAST_BIT;
+}
+
+static void tx_pio_irq() {
+  if (!pio_interrupt_get(tx_pio, 0)) return;
+  pio_interrupt_clear(tx_pio, 0);
+  tx_end_us = time_us_64();
+  tx_busy = false;
+  if (tx_done_cb) tx_done_cb();
+}
+
+// Claims a state machine and DMA channel and parks the pin LOW.
+static bool tx_init(uint8_t pin) {
+  if (!pio_can_add_program(tx_pio, &miles_tx_program)) return false;
+  uint offset = pio_add_program(tx_pio, &miles_tx_program);
+  tx_sm = pio_claim_unused_sm(tx_pio, false);
+  tx_dma = dma_claim_unused_channel(false);
+  if (tx_sm < 0 || tx_dma < 0) return false;
+
+  tx_cycles_per_us = clock_get_hz(clk_sys) / 1000000u;
+
+  pio_gpio_init(tx_pio, pin);
+  pio_sm_set_pins_with_mask(tx_pio, tx_sm, 0, 1u << pin);
+  pio_sm_set_consecutive_pindirs(tx_pio, tx_sm, pin, 1, true);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, offset, offset + miles_tx_program.length - 1);
+  sm_config_set_out_pins(&c, pin, 1);
+  sm_config_set_out_shift(&c, false, false, 32);   // MSB first, manual pull
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+  sm_config_set_clkdiv(&c, 1.0f);
+  pio_sm_init(tx_pio, tx_sm, offset, &c);
+  pio_sm_set_enabled(tx_pio, tx_sm, true);
+
+  dma_channel_config d = dma_channel_get_default_config(tx_dma);
+  channel_config_set_transfer_data_size(&d, DMA_SIZE_32);
+  channel_config_set_read_increment(&d, true);
+  channel_config_set_write_increment(&d, false);
+  channel_config_set_dreq(&d, pio_get_dreq(tx_pio, tx_sm, true));
+  dma_channel_configure(tx_dma, &d, &tx_pio->txf[tx_sm], nullptr, 0, false);
+
+  pio_set_irq0_source_enabled(tx_pio, pis_interrupt0, true);
+  irq_add_shared_handler(PIO0_IRQ_0, tx_pio_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(PIO0_IRQ_0, true);
+  return true;
+}
+
+// Starts streaming a prebuilt buffer. Returns false if a frame is in flight.
+static bool tx_start(const TxBuffer *b, tx_done_cb_t on_done) {
+  if (tx_busy || tx_dma < 0 || b->len == 0) return false;
+  tx_done_cb = on_done;
+  tx_busy = true;
+  tx_start_us = time_us_64();
+  dma_channel_transfer_from_buffer_now(tx_dma, b->words, b->len);
+  return true;
+}
+
+static bool tx_is_busy() { return tx_busy; }
+
+#endif // MILES_TX_H
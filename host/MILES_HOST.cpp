@@ -0,0 +1,1241 @@
+/*
+  Host-side test bench: DROP_MILES.cpp compiled natively against the shims
+  in host/shim and driven by scripted scenarios on a virtual clock.
+
+  Build and run from the repository root (nothing here is part of the
+  Arduino build, which ignores this folder):
+
+    g++ -std=gnu++17 -O2 -Wall -Ihost/shim -I. host/MILES_HOST.cpp -o miles_host
+    ./miles_host                          # every scenario, seed 0
+    ./miles_host -n 1000 arm_drop_fire    # seeds 0..999
+    ./miles_host -v -t telem.bin arm_drop_fire && python3 MILES_TELEM.py telem.bin
+
+  Both cores run the real setup()/loop() and setup1()/loop1() as coroutines
+  on the discrete-event model in host/shim/host_sim.h: the input sampler,
+  altitude filter, alarms, PIO/DMA transmitter, OLED DMA, flash journal and
+  USB telemetry all see virtual time, so every transition can be timed to the
+  microsecond and a run takes the same path every time for a given seed.
+  Each run is forked from a process that has not booted yet, so it starts
+  from power-on with fresh statics and erased flash.
+
+  Options: -n N runs seeds 0..N-1, -s S starts at seed S, -v prints the
+  measured timings of each run, -t FILE appends every run's Serial bytes to
+  FILE, -l lists the scenarios. -r FILE replays a scenario file once and
+  prints its state trace instead (see replay() and MILES_REPLAY.py).
+
+  Built with -DMILES_BENCH=1, the only scenario is the firmware's boot-time
+  benchmark suite. Its JSON lines go to stdout for MILES_BENCH.py:
+
+    g++ -std=gnu++17 -O2 -Wall -DMILES_BENCH=1 -Ihost/shim -I. host/MILES_HOST.cpp -o miles_bench
+    ./miles_bench > host.json && python3 MILES_BENCH.py host.json
+
+  CPU paths are timed in host nanoseconds, since the modelled cycle counter
+  does not move inside a call. Flash, flush and time on air come out in
+  modelled microseconds.
+*/
+
+#include <chrono>
+
+#if MILES_BENCH
+#define BENCH_CLOCK()    ((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>( \
+                            std::chrono::steady_clock::now().time_since_epoch()).count())
+#define BENCH_CLOCK_UNIT "ns"
+#endif
+
+#include <climits>
+#include <cstdarg>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "DROP_MILES.cpp"   // poisons malloc() and friends from here on
+
+namespace bench {
+
+const char *scenario = "";
+uint32_t seed = 0;
+bool verbose = false;
+
+[[noreturn]] void fail(const char *file, int line, const char *what) {
+  fflush(stdout);
+  fprintf(stderr, "FAIL %s seed=%u at t=%.3f ms: %s:%d: %s\n", scenario, seed, host::now_ns / 1e6, file, line, what);
+  fflush(stderr);
+  _exit(1);
+}
+#define EXPECT(c) do { if (!(c)) bench::fail(__FILE__, __LINE__, #c); } while (0)
+
+void note(const char *fmt, ...) {
+  if (!verbose) return;
+  va_list ap;
+  va_start(ap, fmt);
+  printf("  %s/%u: ", scenario, seed);
+  vprintf(fmt, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+// xorshift32, seeded per run
+uint32_t rng = 1;
+uint32_t rnd(uint32_t lo, uint32_t hi) {
+  rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+  return lo + rng % (hi - lo + 1);
+}
+
+uint64_t now_us() { return host::now_ns / 1000; }
+
+// Moves the next stimulus off the 1 ms sampler grid.
+void phase() { host::run_until(host::now_ns + rnd(0, 999999)); }
+
+// -------------------- Stimuli --------------------
+void boot() {
+  host::boot(setup, loop, setup1, loop1);
+  host::run_ms(50);
+}
+
+void button(uint8_t pin, bool down) { host::drive(pin, !down); }   // buttons are active low
+
+// Contact bounce: n toggles 150 us apart, settling on `level`.
+void bounce(uint8_t pin, bool level, uint8_t n) {
+  for (uint8_t k = 0; k < n; k++) { bool l = (k & 1) ? !level : level; host::after_us(150 * k, [pin, l] { host::drive(pin, l); }); }
+  host::after_us(150 * n, [pin, level] { host::drive(pin, level); });
+}
+
+void altitude_mm(int32_t mm) {
+  int32_t counts = (mm - alt_config.offset_mm) * 1000 / (int32_t)alt_config.um_per_count;
+  host::set_adc(PIN_ALT_ADC - 26, (uint16_t)(counts < 0 ? 0 : counts > 4095 ? 4095 : counts));
+}
+
+// Free fall from now for ms: the accelerometer reads near 0 g with noise
+// and, if `range`, the range sensor follows 1/2 g t^2. With impact_ms the
+// unit hits the ground then (8 g for 5 ms) and tumbles: 0 g or 2 g at random.
+void fall(uint32_t ms, bool range, uint32_t impact_ms = 0) {
+  for (uint32_t k = 0; k <= ms; k++) {
+    int16_t x = (int16_t)rnd(-80, 80), y = (int16_t)rnd(-80, 80), z = (int16_t)rnd(-80, 80);
+    if (impact_ms && k >= impact_ms) { x = y = 0; z = k < impact_ms + 5 ? 8000 : rnd(0, 9) < 6 ? 0 : 2000; }
+    host::at_ns(host::now_ns + (uint64_t)k * 1000000, [x, y, z] { host::accel.mg[0] = x; host::accel.mg[1] = y; host::accel.mg[2] = z; });
+  }
+  if (!range) return;
+  uint32_t steps = ms * 1000 / alt_config.period_us, stop = impact_ms ? impact_ms : ms;
+  for (uint32_t k = 0; k <= steps; k++) {
+    uint64_t t = (uint64_t)k * alt_config.period_us / 1000;   // ms
+    int32_t mm = (int32_t)(9807 * (t < stop ? t : stop) * (t < stop ? t : stop) / 2000000);
+    host::at_ns(host::now_ns + t * 1000000, [mm] { altitude_mm(mm); });
+  }
+}
+
+// Linear climb from a to b over ms, one ADC step per filter period.
+void climb(int32_t a, int32_t b, uint32_t ms) {
+  uint32_t steps = ms * 1000 / alt_config.period_us;
+  for (uint32_t k = 0; k <= steps; k++) {
+    int32_t mm = a + (int32_t)((int64_t)(b - a) * k / (steps ? steps : 1));
+    host::at_ns(host::now_ns + (uint64_t)k * alt_config.period_us * 1000, [mm] { altitude_mm(mm); });
+  }
+}
+
+bool run_until_state(State s, uint32_t timeout_ms) {
+  return host::run_while_not([s] { return state == s; }, timeout_ms);
+}
+
+// -------------------- Observation --------------------
+// Newest trace point on core 0 matching (p, arg) at or after t_us, or 0.
+uint64_t traced(TracePoint p, uint8_t arg = TRACE_ANY, uint64_t after_us = 0, uint8_t core = 0) {
+  static TraceRecord snap[TRACE_DEPTH];
+  uint32_t n = trace_snapshot(core, snap);
+  for (uint32_t i = n; i-- > 0;)
+    if (trace_match(snap[i], p, arg) && snap[i].t_us >= after_us) return snap[i].t_us;
+  return 0;
+}
+
+struct Record {
+  uint8_t type;
+  std::vector<uint8_t> b;   // payload after the type byte
+  uint32_t u32(size_t at) const { return at + 4 <= b.size() ? (uint32_t)b[at] | b[at + 1] << 8 | b[at + 2] << 16 | (uint32_t)b[at + 3] << 24 : 0; }
+  uint16_t u16(size_t at) const { return at + 2 <= b.size() ? (uint16_t)(b[at] | b[at + 1] << 8) : 0; }
+  uint8_t u8(size_t at) const { return at < b.size() ? b[at] : 0; }
+};
+
+// Telemetry records in the Serial stream so far (MILES_TELEM.h framing).
+std::vector<Record> records(uint8_t type) {
+  std::vector<Record> out;
+  const std::string &s = host::serial_out;
+  for (size_t i = 0; i + 3 < s.size(); i++) {
+    if ((uint8_t)s[i] != TELEM_SYNC) continue;
+    uint8_t len = (uint8_t)s[i + 1];
+    if (len == 0 || len > TELEM_MAX_BODY || i + 3 + len > s.size()) continue;
+    const uint8_t *body = (const uint8_t *)s.data() + i + 2;
+    if (telem_crc8(body, len, telem_crc8(&len, 1)) != (uint8_t)s[i + 2 + len]) continue;
+    if (body[0] == type) out.push_back(Record{ body[0], std::vector<uint8_t>(body + 1, body + len) });
+    i += 2 + len;
+  }
+  return out;
+}
+
+// On-air time of a TX buffer, as the PIO program clocks it.
+uint64_t tx_duration_ns(const TxBuffer &b) {
+  uint64_t cyc = 0;
+  for (size_t i = 0; i < b.len; i++) cyc += (b.words[i] & TX_COUNT_MASK) + TX_LOOP_OVERHEAD;
+  return cyc * 1000000000ull / host::SYS_HZ;
+}
+
+// Last line of Serial text containing `has`, and the number after `key` in it.
+std::string serial_line(const char *has) {
+  const std::string &s = host::serial_out;
+  size_t at = s.rfind(has);
+  if (at == std::string::npos) return "";
+  size_t bol = s.rfind('\n', at), eol = s.find('\n', at);
+  bol = bol == std::string::npos ? 0 : bol + 1;
+  return s.substr(bol, eol == std::string::npos ? std::string::npos : eol - bol);
+}
+long field(const std::string &line, const char *key) {
+  size_t k = line.find(key);
+  return k == std::string::npos ? LONG_MIN : strtol(line.c_str() + k + strlen(key), nullptr, 10);
+}
+
+// -------------------- Replay --------------------
+// Scenario files for MILES_REPLAY.py: one "t_ms INPUT value" per line, '#'
+// comments, times from power-on. INPUT is PWR, NEXT, SIDE, FIRE (1 down,
+// 0 up), LIMIT (1 attached) or ALT (mm); "t_ms END" stops the run. The
+// replay prints a line per state entry and burst, in the same format as
+// MILES_GUI.py --replay for the same file.
+const int REPLAY_END = -1;
+const char *const replay_names[] = { "PWR", "NEXT", "SIDE", "FIRE", "LIMIT", "ALT" };   // InputId order
+#define REPLAY_STATE_ID(id, name) #id,
+const char *const replay_states[] = { MILES_FSM_STATES(REPLAY_STATE_ID) };
+#undef REPLAY_STATE_ID
+
+struct ReplayStep {
+  uint32_t t_ms;
+  int      input;   // InputId, or REPLAY_END
+  int32_t  value;
+};
+
+// False with a message naming the line if the text does not parse; steps
+// must not go back in time and the last one is END.
+bool replay_parse(const std::string &text, std::vector<ReplayStep> &out, std::string &err) {
+  out.clear();
+  size_t at = 0;
+  for (uint32_t line = 1; at < text.size(); line++) {
+    size_t eol = text.find('\n', at);
+    std::string l = text.substr(at, eol == std::string::npos ? std::string::npos : eol - at);
+    at = eol == std::string::npos ? text.size() : eol + 1;
+    size_t hash = l.find('#');
+    if (hash != std::string::npos) l.resize(hash);
+
+    char name[8];
+    unsigned long t = 0;
+    long v = 0;
+    int n = sscanf(l.c_str(), "%lu %7s %ld", &t, name, &v);
+    if (n <= 0) continue;
+    ReplayStep s = { (uint32_t)t, INT_MIN, (int32_t)v };
+    if (n >= 2 && strcmp(name, "END") == 0) s.input = REPLAY_END;
+    else if (n == 3) for (int i = 0; i < (int)(sizeof(replay_names) / sizeof(replay_names[0])); i++) if (strcmp(name, replay_names[i]) == 0) s.input = i;
+    if (s.input == INT_MIN || (!out.empty() && s.t_ms < out.back().t_ms) || (!out.empty() && out.back().input == REPLAY_END)) {
+      err = "line " + std::to_string(line) + ": " + l;
+      return false;
+    }
+    out.push_back(s);
+  }
+  if (out.empty() || out.back().input != REPLAY_END) { err = "no END"; return false; }
+  return true;
+}
+
+void replay_apply(const ReplayStep &s) {
+  switch (s.input) {
+    case IN_PWR:   button(PIN_BTN_PWR,  s.value != 0); break;
+    case IN_NEXT:  button(PIN_BTN_NEXT, s.value != 0); break;
+    case IN_SIDE:  button(PIN_BTN_SIDE, s.value != 0); break;
+    case IN_FIRE:  button(PIN_BTN_FIRE, s.value != 0); break;
+    case IN_LIMIT: host::drive(PIN_LIMIT, s.value != 0); break;
+    case IN_ALT:   altitude_mm(s.value); break;
+  }
+}
+
+// Boots, applies the steps on time and returns the trace. The emitter is
+// wired to the receiver, so every burst confirms.
+std::string replay(const std::vector<ReplayStep> &steps) {
+  host::wire(PIN_OUT, PIN_IR_SENSE, 20);
+  host::boot(setup, loop, setup1, loop1);
+  for (const ReplayStep &s : steps)
+    if (s.input != REPLAY_END) host::at_ns((uint64_t)s.t_ms * 1000000, [s] { replay_apply(s); });
+
+  std::string out;
+  uint32_t seen = 0;
+  while (now_us() < (uint64_t)steps.back().t_ms * 1000) {
+    host::run_ms(1);
+    uint32_t head = trace_ring[0].head.load();
+    EXPECT(head - seen <= TRACE_DEPTH);
+    for (; seen != head; seen++) {
+      const TraceRecord &r = trace_ring[0].buf[seen & (TRACE_DEPTH - 1)];
+      char line[48];
+      if (r.point == TR_STATE) snprintf(line, sizeof(line), "%10.3f STATE %s\n", r.t_us / 1e3, replay_states[r.arg]);
+      else if (r.point == TR_TX_START) snprintf(line, sizeof(line), "%10.3f TX %u\n", r.t_us / 1e3, r.arg);
+      else continue;
+      out += line;
+    }
+  }
+  return out;
+}
+
+// -------------------- Scenarios --------------------
+// PWR held until SAFE_READY; returns the press-to-state latency in us.
+uint64_t arm() {
+  phase();
+  uint64_t t0 = now_us();
+  button(PIN_BTN_PWR, true);
+  EXPECT(run_until_state(SAFE_READY, 1500));
+  uint64_t dt = traced(TR_STATE, SAFE_READY, t0) - t0;
+  host::run_ms(rnd(0, 200));
+  button(PIN_BTN_PWR, false);
+  host::run_ms(40);
+  return dt;
+}
+
+void boot_safe() {
+  boot();
+  EXPECT(state == SAFE_STATE);
+  EXPECT(digitalRead(LED_SAFE) == HIGH && digitalRead(LED_ARMED) == LOW);
+  EXPECT(gui_valid && host::panel.on && host::panel.flushes > 0);
+  EXPECT(heap_sealed && heap_mark == (uint32_t)rp2040.getUsedHeap());   // the SSD1306 buffer is in the mark
+  EXPECT(reg_count == NUM_BUILTIN);
+  std::vector<Record> st = records(TM_STATE);
+  EXPECT(!st.empty() && st[0].u8(4) == SAFE_STATE);
+}
+
+// USB not attached at power-on and panel RAM full of noise: arming is
+// live within a few ms and the first DMA frame covers the whole panel.
+void fast_boot() {
+  host::usb_host = false;
+  for (uint8_t &b : host::panel.ram) b = (uint8_t)rnd(0, 255);
+  host::boot(setup, loop, setup1, loop1);
+  host::run_ms(2);
+  uint32_t armable = boot_armable_us.load();
+  EXPECT(armable < 2000);
+
+  uint64_t t_arm = arm();
+  EXPECT(t_arm <= (DEBOUNCE_MS + PWR_HOLD_MS) * 1000);
+  EXPECT(memcmp(host::panel.ram, display.getBuffer(), sizeof(host::panel.ram)) == 0);
+  EXPECT(records(TM_BOOT).empty());
+
+  host::run_ms(rnd(0, 2000));
+  uint64_t t_usb = now_us();
+  host::usb_host = true;
+  EXPECT(host::run_while_not([] { return !records(TM_BOOT).empty(); }, 100));
+  std::vector<Record> rec = records(TM_BOOT);
+  EXPECT(rec.size() == 1 && rec[0].u32(0) == armable);
+  EXPECT(rec[0].u32(4) < 50000);
+  EXPECT(rec[0].u32(8) >= t_usb && rec[0].u32(8) < t_usb + 10000);
+  note("armable %u us, first frame %u us, USB %u us after attach", armable, rec[0].u32(4), (uint32_t)(rec[0].u32(8) - t_usb));
+}
+
+void arm_drop_fire() {
+  uint32_t echo_us = rnd(5, 150);
+  host::wire(PIN_OUT, PIN_IR_SENSE, echo_us);   // receiver sees the emitter
+  boot();
+
+  uint64_t t_arm = arm();
+  // debounce depth + hold time, less up to one tick of sampler phase
+  EXPECT(t_arm > (DEBOUNCE_MS + PWR_HOLD_MS - 1) * 1000 && t_arm <= (DEBOUNCE_MS + PWR_HOLD_MS) * 1000);
+
+  phase();
+  uint64_t t0 = now_us();
+  bounce(PIN_LIMIT, HIGH, (uint8_t)rnd(0, 6));
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  uint64_t t_fly = traced(TR_STATE, ARMED_FLY, t0) - t0;
+
+  host::run_ms(rnd(100, 2000));
+  phase();
+  t0 = now_us();
+  host::accel.mg[2] = (int16_t)rnd(-50, 50);     // free fall from the release on
+  bounce(PIN_LIMIT, LOW, (uint8_t)rnd(0, 6));
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  uint64_t t_drop = traced(TR_STATE, ARMED_SENSING, t0) - t0;
+  EXPECT(t_drop <= SENSOR_DEBOUNCE_MS * 1000 + 150 * 6 + fuse_bound_us(fusion_config.limit_gain + fusion_config.fall_gain));
+
+  // Under a canopy: no more free fall, the range sensor alone sees altitude.
+  host::accel.mg[2] = 1000;
+  climb(0, 4000, rnd(200, 2000));
+  EXPECT(run_until_state(ARMED_IR_FLASH, 3000));
+  uint64_t t_alt = traced(TR_PRESS, IN_ALT);
+  uint64_t t_tx = traced(TR_TX_START);
+  EXPECT(t_alt && t_tx >= t_alt && t_tx - t_alt < fuse_bound_us(fusion_config.alt_gain));   // ALT->TX: fusion + one loop pass
+  EXPECT(alt_mm() >= alt_config.threshold_mm);
+
+  EXPECT(run_until_state(EXPENDED, 1000));
+  uint64_t on_air = traced(TR_TX_END) - t_tx;
+  uint64_t expect_air = tx_duration_ns(frame_cache.tx) / 1000;
+  EXPECT(on_air + 1 >= expect_air && on_air <= expect_air + 1);
+  EXPECT(shot_count == 1);
+  EXPECT(flash_confirmed && flash_bit_errors == 0);
+
+  host::run_ms(20);   // core 1 sends the records once the burst is over
+  std::vector<Record> tx = records(TM_TX), echo = records(TM_ECHO);
+  EXPECT(tx.size() == frame_cache.count && echo.size() == frame_cache.count);
+  for (const Record &r : echo) {
+    EXPECT(r.u8(4) == 1 && r.u8(5) == 0);
+    EXPECT(r.u32(6) + 1 >= echo_us && r.u32(6) <= echo_us + 1);
+  }
+
+  uint64_t t_exp = traced(TR_STATE, EXPENDED);
+  EXPECT(run_until_state(SAFE_STATE, EXPENDED_MS + 100));
+  uint64_t t_back = traced(TR_STATE, SAFE_STATE, t_exp) - t_exp;
+  EXPECT(t_back >= EXPENDED_MS * 1000 && t_back <= EXPENDED_MS * 1000 + 1000);
+
+  host::serial_send("t");   // a full sortie allocates nothing once the GUI is live
+  EXPECT(host::run_while_not([] { return serial_line("heap: ") != ""; }, 1000));
+  EXPECT(serial_line("heap: ").find(", +0 since") != std::string::npos);
+
+  note("PWR->READY %llu us, LIM->FLY %llu us, LIM->SENSE %llu us, ALT->TX %llu us, on air %llu us, echo %u us",
+       (unsigned long long)t_arm, (unsigned long long)t_fly, (unsigned long long)t_drop,
+       (unsigned long long)(t_tx - t_alt), (unsigned long long)on_air, echo.empty() ? 0u : echo[0].u32(6));
+}
+
+void manual_fire() {
+  host::wire(PIN_OUT, PIN_IR_SENSE, 20);
+  boot();
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::run_ms(rnd(10, 500));
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  host::run_ms(rnd(10, 500));
+  phase();
+  uint64_t t0 = now_us();
+  button(PIN_BTN_FIRE, true);
+  EXPECT(run_until_state(EXPENDED, 1000));
+  button(PIN_BTN_FIRE, false);
+  uint64_t t_fire = traced(TR_TX_START, TRACE_ANY, t0) - t0;
+  EXPECT(t_fire > (DEBOUNCE_MS - 1) * 1000 && t_fire <= DEBOUNCE_MS * 1000);
+  EXPECT(shot_count == 1 && flash_confirmed);
+  EXPECT(!alt_above());
+  note("FIRE->TX %llu us", (unsigned long long)t_fire);
+}
+
+// The emitter pin carries the PWM carrier inside every envelope pulse and
+// stays low outside them.
+void carrier() {
+  host::wire(PIN_OUT, PIN_IR_SENSE, 20);
+  host::log_pin(PIN_OUT);
+  host::log_pin(PIN_IR_LED);
+  boot();
+  EXPECT(carrier_hz && carrier_hz - carrier_config.hz + carrier_config.hz / 1000 <= carrier_config.hz / 500);
+  EXPECT(host::pins[PIN_IR_LED].log.empty());   // PWM running, gate closed
+
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  button(PIN_BTN_FIRE, true);
+  EXPECT(run_until_state(EXPENDED, 1000));
+  button(PIN_BTN_FIRE, false);
+  EXPECT(flash_confirmed && flash_bit_errors == 0);   // envelope timing unchanged
+
+  typedef std::vector<std::pair<uint64_t, bool>> Log;
+  typedef std::vector<std::pair<uint64_t, uint64_t>> Spans;
+  auto highs = [](const Log &l) {
+    Spans out;
+    for (size_t i = 0; i + 1 < l.size(); i++) if (l[i].second && !l[i + 1].second) out.push_back({ l[i].first, l[i + 1].first });
+    return out;
+  };
+  Spans env = highs(host::pins[PIN_OUT].log), led = highs(host::pins[PIN_IR_LED].log);
+  EXPECT(!env.empty() && !host::pins[PIN_IR_LED].log.back().second);
+
+  double period = 1e9 / carrier_hz, high = period * carrier_config.duty_pct / 100;
+  size_t j = 0;
+  for (const auto &e : env) {
+    size_t first = j;
+    for (; j < led.size() && led[j].second <= e.second; j++) {
+      EXPECT(led[j].first >= e.first);                // nothing outside the pulse
+      if (j == first || j + 1 >= led.size() || led[j + 1].first > e.second) continue;
+      EXPECT(fabs((double)(led[j].second - led[j].first) - high) <= period / 100);
+      if (j > first + 1) EXPECT(fabs((double)(led[j].first - led[j - 1].first) - period) <= host::CYCLE_NS);
+    }
+    double expect = (e.second - e.first) / period;
+    EXPECT(fabs((double)(j - first) - expect) <= 1);
+  }
+  EXPECT(j == led.size());
+
+  host::serial_send("s");
+  EXPECT(host::run_while_not([] { return serial_line("scope: carrier") != ""; }, 100));
+  EXPECT(field(serial_line("scope: carrier"), "carrier ") == (long)carrier_hz);
+  note("%u Hz, %zu carrier periods in %zu pulses", carrier_hz, led.size(), env.size());
+}
+
+void scope_selftest() {
+  boot();
+  host::serial_send("s");
+  host::run_ms(20);
+  EXPECT(host::serial_out.find("scope: no capture yet") != std::string::npos);
+
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  altitude_mm(3500);
+  EXPECT(run_until_state(EXPENDED, 1000));
+  host::run_ms(50);
+  host::serial_send("s");
+  host::run_ms(50);
+
+  uint32_t pulses = 0;
+  for (uint8_t k = 0; k < frame_cache.count; k++)
+    for (uint8_t i = 0; i < frame_cache.frames[k].len; i++) pulses += (frame_cache.frames[k].bits >> i) & 1;
+  std::string head = serial_line(" pulses, "), sum = serial_line("scope: edge error");
+  EXPECT(field(head, "scope: ") == (long)pulses && field(head, " pulses, ") == (long)pulses);
+  EXPECT(field(head, "resolution ") == 16);
+  long jitter = field(sum, "jitter ");
+  long drift = field(sum, "drift ");
+  long width = field(sum, "width error max ");
+  EXPECT(jitter >= 0 && jitter <= 16);                 // one sample step either side
+  EXPECT(drift >= -16 && drift <= 16 && width <= 16);
+  note("%u pulses, jitter %ld ns, drift %ld ns, width error %ld ns", pulses, jitter, drift, width);
+}
+
+// Full redraw from the font, then from the glyph cache: same bytes, on the
+// panel too.
+void gui_compare() {
+  static uint8_t font[OLED_FB_BYTES];
+  gui_use_cache = false;
+  gui_valid = false;
+  host::sev();
+  host::run_ms(40);                                   // a whole-screen flush is ~25 ms
+  memcpy(font, display.getBuffer(), sizeof font);
+  gui_use_cache = true;
+  gui_valid = false;
+  host::sev();
+  host::run_ms(40);
+  EXPECT(memcmp(font, display.getBuffer(), sizeof font) == 0);
+  EXPECT(memcmp(font, host::panel.ram, sizeof font) == 0);
+}
+
+void glyph_cache() {
+  boot();
+  EXPECT(gui_cached);
+  EXPECT(gui_strip_count[W_STATE] == NUM_STATES && gui_strip_count[W_PROTO] == reg_count);
+  EXPECT(gui_strip(W_SHOTS, 0) == nullptr && gui_strip(W_PROTO, reg_count) == nullptr);
+  uint32_t lit = 0;
+  for (size_t i = 0; i < OLED_FB_BYTES; i++) lit += host::panel.ram[i] != 0;
+  EXPECT(lit > 100);
+  gui_compare();
+
+  for (uint8_t i = 0; i < reg_count; i++) {           // every protocol name, both sides
+    button(PIN_BTN_NEXT, true); host::run_ms(40); button(PIN_BTN_NEXT, false); host::run_ms(40);
+    if (rnd(0, 1)) { button(PIN_BTN_SIDE, true); host::run_ms(40); button(PIN_BTN_SIDE, false); host::run_ms(40); }
+    gui_compare();
+  }
+  arm();
+  gui_compare();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  gui_compare();
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  gui_compare();
+  note("%u strip bytes for %u protocols", (unsigned)oled_strip_used, (unsigned)reg_count);
+}
+
+// Another emitter on the sense pin: frames back to back (gap_us = 0 is full
+// bin rate), each edge moved by up to +-jitter_us and every pulse stretched
+// by stretch_us the way receivers do. Returns bin 0 of each frame.
+uint64_t emit_frames(uint64_t t_ns, const std::vector<uint16_t> &frames, uint32_t gap_us,
+                     uint32_t jitter_us, uint32_t stretch_us, std::vector<uint32_t> &starts) {
+  for (uint16_t bits : frames) {
+    starts.push_back((uint32_t)(t_ns / 1000));
+    for (uint8_t i = 0; i < MILES_FRAME_BITS; i++) {
+      if (!((bits >> i) & 1)) continue;
+      uint64_t rise = t_ns + (uint64_t)i * BIN_US * 1000 + rnd(0, 2 * jitter_us * 1000) - jitter_us * 1000;
+      uint64_t fall = rise + (uint64_t)(PULSE_US + stretch_us) * 1000 + rnd(0, 2 * jitter_us * 1000) - jitter_us * 1000;
+      host::at_ns(rise, [] { host::drive(PIN_IR_SENSE, HIGH); });
+      host::at_ns(fall, [] { host::drive(PIN_IR_SENSE, LOW); });
+    }
+    t_ns += (uint64_t)(MILES_FRAME_BITS * BIN_US + gap_us) * 1000;
+  }
+  return t_ns;
+}
+
+void rx_decode() {
+  host::wire(PIN_OUT, PIN_IR_SENSE, 30);
+  boot();
+  EXPECT(rx_ok);
+  host::drive(PIN_IR_SENSE, LOW);
+  uint32_t jitter = rnd(0, 40), stretch = rnd(0, 100);
+
+  // A code starting with two '0' bins, in a slot past the registry: decoded
+  // from its first rise, but reported unmatched (no registry entry).
+  const uint8_t LEAD_SLOT = 200;
+  uint16_t lead = 0;
+  for (bool unused = false; !unused;) {
+    lead = (uint16_t)((rnd(0, 511) << 2) | 4);
+    unused = true;
+    for (uint32_t hi = 0; hi < 4; hi++) unused &= rx_table[(lead >> 2) | (hi << 9)] == RX_NONE;
+  }
+  EXPECT(rx_table_add(LEAD_SLOT, lead, MILES_FRAME_BITS));
+
+  // frames[i] is a registry code (slot), the lead code, or (RX_NONE) a window no code has
+  std::vector<uint16_t> frames;
+  std::vector<uint8_t> slots;
+  std::vector<uint32_t> starts;
+  uint64_t t = host::now_ns + 1000000;
+  for (uint8_t g = 0; g < 3; g++) {
+    std::vector<uint16_t> group;
+    uint32_t n = rnd(10, 40);
+    for (uint32_t k = 0; k < n; k++) {
+      uint32_t pick = rnd(0, 9);
+      uint8_t slot = pick > 1 ? (uint8_t)rnd(0, 2 * reg_count - 1) : pick ? LEAD_SLOT : RX_NONE;
+      uint16_t bits = slot == LEAD_SLOT ? lead : slot != RX_NONE ? (uint16_t)proto_frame[slot / 2][slot & 1].bits : 0;
+      while (slot == RX_NONE && (bits == 0 || rx_table[bits] != RX_NONE)) bits = (uint16_t)(rnd(0, 2047) | 1);
+      group.push_back(bits);
+      slots.push_back(slot);
+    }
+    frames.insert(frames.end(), group.begin(), group.end());
+    t = emit_frames(t, group, 0, jitter, stretch, starts) + (uint64_t)rnd(6, 50) * 1000000;
+  }
+  EXPECT(host::run_while_not([&] { return rx_frames >= frames.size(); }, (uint32_t)((t - host::now_ns) / 1000000) + 100));
+  host::run_ms(20);
+
+  std::vector<Record> rx = records(TM_RX);
+  EXPECT(rx.size() == frames.size() && rx_overruns == 0);
+  uint32_t hits = 0;
+  for (size_t i = 0; i < rx.size(); i++) {
+    const Record &r = rx[i];
+    uint16_t bits = (uint16_t)(r.u8(4) | r.u8(5) << 8);
+    int32_t dt = (int32_t)(r.u32(0) - starts[i]);
+    EXPECT(bits == frames[i]);
+    EXPECT(dt >= -(int32_t)jitter - 1 && dt <= (int32_t)jitter + 1);
+    if (slots[i] == RX_NONE || slots[i] == LEAD_SLOT) { EXPECT(r.u8(8) == 0 && r.u8(6) == 0xFF); continue; }
+    EXPECT(r.u8(6) == reg_entries[slots[i] / 2].id && r.u8(7) == (slots[i] & 1));
+    EXPECT((r.u8(8) & (HIT_MATCHED | HIT_OWN)) == HIT_MATCHED);
+    EXPECT(((r.u8(8) & HIT_FRIENDLY) != 0) == ((slots[i] & 1) == (active_side_opfor ? 1 : 0)));
+    hits++;
+  }
+  EXPECT(hit_count == hits && rx_echo_count == 0);
+
+  // Our own burst is decoded as its echo, not scored.
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  button(PIN_BTN_FIRE, true);
+  EXPECT(run_until_state(EXPENDED, 1000));
+  button(PIN_BTN_FIRE, false);
+  host::run_ms(50);
+  EXPECT(shot_count == 1 && flash_confirmed);
+  EXPECT(rx_echo_count == frame_cache.count && hit_count == hits);
+  rx = records(TM_RX);
+  EXPECT(rx.size() == frames.size() + frame_cache.count);
+  for (size_t k = 0; k < frame_cache.count; k++) {
+    const Record &r = rx[frames.size() + k];
+    EXPECT((r.u8(8) & HIT_OWN) && (uint16_t)(r.u8(4) | r.u8(5) << 8) == frame_cache.frames[k].bits);
+  }
+  note("%zu frames in 3 groups, %u hits, jitter %u us, stretch %u us", frames.size(), hits, jitter, stretch);
+}
+
+void disarm() {
+  boot();
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  button(PIN_BTN_PWR, true);
+  EXPECT(run_until_state(SAFE_STATE, 1500));
+  button(PIN_BTN_PWR, false);
+  host::run_ms(100);
+  EXPECT(state == SAFE_STATE && shot_count == 0);   // limit still held: no re-arm
+  EXPECT(records(TM_TX).empty());
+}
+
+void no_echo() {
+  boot();
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  altitude_mm(3500);
+  EXPECT(run_until_state(EXPENDED, 1000));
+  EXPECT(shot_count == 1 && !flash_confirmed);
+  uint64_t t_first = traced(TR_TX_START, 0), t_done = traced(TR_SHOT_DONE, retry_config.max_retries);
+  EXPECT(t_done && t_done - t_first <= retry_config.budget_ms * 1000);   // every retry spent, inside the budget
+  host::run_ms(20);
+  std::vector<Record> echo = records(TM_ECHO);
+  EXPECT(echo.size() == frame_cache.count * (1u + retry_config.max_retries));
+  for (const Record &r : echo) EXPECT(r.u8(4) == 0);
+}
+
+// Up to the SAFE_READY..ARMED_SENSING part of a sortie, dropped at 3.5 m.
+void to_sensing() {
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::drive(PIN_LIMIT, LOW);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+}
+
+// One frame of the salvo never reaches the receiver (cut in the gaps around
+// it): that frame alone is unseen, the others keep their own latency, and
+// the burst is resent because the lost frame's bins count as errors.
+void lost_frame() {
+  uint32_t echo_us = rnd(5, 150);
+  boot();
+  to_sensing();
+  EXPECT(frame_cache.count >= 2);
+  uint8_t lost = (uint8_t)rnd(0, frame_cache.count - 1);
+  if (lost) host::wire(PIN_OUT, PIN_IR_SENSE, echo_us);
+  altitude_mm(3500);
+  EXPECT(host::run_while_not([] { return traced(TR_TX_START, 0) != 0; }, 1000, 10));
+  uint64_t half_gap = tx_gap_us / 2;
+  uint64_t cut = tx_mark.t_us + tx_frame_offset_us(lost) - half_gap, back = tx_mark.t_us + tx_frame_offset_us(lost + 1) - half_gap;
+  if (lost) host::at_ns(cut * 1000, [] { host::unwire(PIN_OUT); });
+  host::at_ns(back * 1000, [echo_us] { host::wire(PIN_OUT, PIN_IR_SENSE, echo_us); });
+
+  EXPECT(run_until_state(EXPENDED, 1000));
+  EXPECT(traced(TR_RETRY, 1) && flash_confirmed && flash_bit_errors == 0);
+  host::run_ms(20);
+  std::vector<Record> echo = records(TM_ECHO);
+  EXPECT(echo.size() == 2u * frame_cache.count);
+  for (uint8_t k = 0; k < frame_cache.count; k++) {
+    const Record &r = echo[k];
+    if (k == lost) { EXPECT(r.u8(4) == 0 && r.u8(5) > 0); continue; }
+    EXPECT(r.u8(4) == 1 && r.u8(5) == 0);
+    EXPECT(r.u32(6) + 1 >= echo_us && r.u32(6) <= echo_us + 1);
+  }
+  std::vector<ShotRecord> log;
+  for (uint32_t i = 0; i < shotlog_span(); i++) { ShotRecord r; if (shotlog_at(i, &r)) log.push_back(r); }
+  EXPECT(log.size() == 2 && (log[0].flags & SHOT_CONFIRMED) && log[0].bit_errors > 0);
+  EXPECT((uint32_t)log[0].latency_us + 1 >= echo_us && log[0].latency_us <= echo_us + 1);
+  note("frame %u of %u lost: %u bit errors, resent", lost, frame_cache.count, echo[lost].u8(5));
+}
+
+// Another producer fills the event ring just before the first burst's
+// end-of-frame IRQ, so its EV_TX_DONE is dropped. The latched completion
+// still closes the confirm window and 't' reports the lost events.
+void flood_then_done() {
+  while (sched_post(EV_NONE)) {}
+  on_tx_done();
+}
+
+void full_ring() {
+  boot();
+  host::wire(PIN_OUT, PIN_IR_SENSE, rnd(5, 150));
+  to_sensing();
+  altitude_mm(3500);
+  EXPECT(host::run_while_not([] { return traced(TR_TX_START, 0) != 0; }, 1000, 10));
+  EXPECT(tx_done_cb == on_tx_done);
+  tx_done_cb = flood_then_done;
+  EXPECT(run_until_state(EXPENDED, 1000));
+  EXPECT(shot_count == 1 && flash_confirmed && !traced(TR_RETRY, 1));
+  host::run_ms(20);
+  host::serial_send("t");
+  EXPECT(host::run_while_not([] { return serial_line("events dropped: ") != ""; }, 1000));
+  long dropped = field(serial_line("events dropped: "), "dropped: ");
+  EXPECT(dropped >= 1);
+  note("%ld events dropped", dropped);
+}
+
+// No echo for the first burst, then the receiver sees the emitter: one
+// retry, started as the first confirm window closes, and the shot ends
+// confirmed. Both bursts are in the shot log.
+void retry() {
+  boot();
+  to_sensing();
+  altitude_mm(3500);
+  EXPECT(host::run_while_not([] { return traced(TR_TX_END) != 0; }, 1000));
+  uint64_t t_end0 = traced(TR_TX_END);
+  host::wire(PIN_OUT, PIN_IR_SENSE, (uint32_t)rnd(5, 150));
+  EXPECT(run_until_state(EXPENDED, 1000));
+  EXPECT(shot_count == 1 && flash_confirmed && flash_bit_errors == 0);
+
+  uint64_t t_retry = traced(TR_TX_START, 1);
+  EXPECT(traced(TR_RETRY, 1) && traced(TR_TX_START, 2) == 0 && traced(TR_SHOT_DONE, 1));
+  EXPECT(t_retry >= t_end0 + CONFIRM_WINDOW_MS * 1000 && t_retry <= t_end0 + CONFIRM_WINDOW_MS * 1000 + 1000);
+
+  host::run_ms(20);
+  EXPECT(records(TM_TX).size() == 2u * frame_cache.count);
+  std::vector<ShotRecord> log;
+  for (uint32_t i = 0; i < shotlog_span(); i++) { ShotRecord r; if (shotlog_at(i, &r)) log.push_back(r); }
+  EXPECT(log.size() == 2 && log[0].flags == 0 && log[1].flags == (SHOT_RETRY | SHOT_CONFIRMED));
+
+  host::serial_send("t");
+  EXPECT(host::run_while_not([] { return serial_line("RETRY: ") != ""; }, 1000));
+  EXPECT(field(serial_line("RETRY: "), "n=") == 1 && field(serial_line("FIRE->DONE: "), "n=") == 1);
+  note("retry %llu us after the first burst ended", (unsigned long long)(t_retry - t_end0));
+}
+
+// PWR long-press completes while the first retry is on air: that burst
+// finishes, no further retry follows and the unit is SAFE.
+void retry_disarm() {
+  boot();
+  to_sensing();
+  uint64_t attempt_us = tx_duration_ns(frame_cache.tx) / 1000 + CONFIRM_WINDOW_MS * 1000;
+  uint64_t t0 = now_us();
+  button(PIN_BTN_PWR, true);   // hold completes DEBOUNCE_MS + PWR_HOLD_MS from here
+  uint64_t fire_at = t0 + (DEBOUNCE_MS + PWR_HOLD_MS) * 1000 - attempt_us * 3 / 2 - DEBOUNCE_MS * 1000;
+  host::run_until(fire_at * 1000);
+  button(PIN_BTN_FIRE, true);
+  EXPECT(run_until_state(SAFE_STATE, 1500));
+  button(PIN_BTN_FIRE, false);
+  button(PIN_BTN_PWR, false);
+  EXPECT(host::run_while_not([] { return !tx_pending; }, 200));
+  host::run_ms(200);
+  EXPECT(traced(TR_TX_START, 1) && traced(TR_TX_START, 1) < traced(TR_STATE, SAFE_STATE));
+  EXPECT(traced(TR_TX_START, 2) == 0 && traced(TR_SHOT_DONE, 1));
+  EXPECT(state == SAFE_STATE && shot_count == 1);
+}
+
+void settings_persist() {
+  boot();
+  button(PIN_BTN_NEXT, true); host::run_ms(40); button(PIN_BTN_NEXT, false); host::run_ms(40);
+  button(PIN_BTN_SIDE, true); host::run_ms(40); button(PIN_BTN_SIDE, false);
+  EXPECT(active_index == 1 && active_side_opfor);
+  host::run_ms(SETTINGS_IDLE_MS / 2);
+  EXPECT(host::flash_programs == 0);                 // coalesced, not yet idle
+  host::run_ms(SETTINGS_IDLE_MS);
+  EXPECT(host::flash_programs == 1);
+  SettingsRecord s;
+  EXPECT(journal_latest((uint8_t *)&s));
+  EXPECT(s.protocol_id == builtin_protocols[1].id && s.side == 1 && s.profile_id == TIMING.id);
+}
+
+// A valid record followed by torn ones (power lost mid-program): boot uses
+// the valid one, and the next save skips the dirty slots instead of erasing
+// the sector, so the valid record is still there if that save is lost too.
+void journal_torn() {
+  JournalRecord *img = (JournalRecord *)host_fs_image;
+  SettingsRecord s;
+  memset(&s, 0xFF, sizeof(s));
+  s.protocol_id = builtin_protocols[1].id; s.side = 1; s.profile_id = TIMING.id;
+  img[0].seq = 1;
+  memcpy(img[0].data, &s, sizeof(s));
+  img[0].crc = crc32((const uint8_t *)&img[0], offsetof(JournalRecord, crc));
+  uint32_t torn = rnd(1, 4);
+  for (uint32_t i = 1; i <= torn; i++) {
+    img[i].seq = i + 1;                        // programmed up to the payload
+    memset(img[i].data, (uint8_t)rnd(0, 0xFE), rnd(1, JOURNAL_PAYLOAD));
+  }
+  JournalRecord keep = img[0];
+  boot();
+  EXPECT(active_index == 1 && active_side_opfor);
+
+  button(PIN_BTN_NEXT, true); host::run_ms(40); button(PIN_BTN_NEXT, false);
+  host::run_ms(SETTINGS_IDLE_MS + 100);
+  EXPECT(host::flash_erases == 0 && host::flash_programs == 1);
+  EXPECT(memcmp(&img[0], &keep, sizeof(keep)) == 0);
+  EXPECT(journal_valid(&img[torn + 1]) && img[torn + 1].seq == 2 && journal_next == torn + 2);
+  EXPECT(journal_latest((uint8_t *)&s) && s.protocol_id == builtin_protocols[2].id);
+  note("%u torn slots skipped", torn);
+}
+
+// A journal record from this profile, another one or pre-profile firmware
+// (0xFF): the settings apply either way, only another profile is logged.
+void profile_mismatch() {
+  uint8_t saved = (uint8_t)(rnd(0, 2) == 0 ? 0xFF : rnd(0, NUM_PROFILES - 1));
+  JournalRecord *img = (JournalRecord *)host_fs_image;
+  SettingsRecord s;
+  memset(&s, 0xFF, sizeof(s));
+  s.protocol_id = builtin_protocols[1].id; s.side = 1; s.profile_id = saved;
+  img[0].seq = 1;
+  memcpy(img[0].data, &s, sizeof(s));
+  img[0].crc = crc32((const uint8_t *)&img[0], offsetof(JournalRecord, crc));
+  boot();
+  EXPECT(active_index == 1 && active_side_opfor);
+  bool logged = false;
+  for (const Record &r : records(TM_TEXT))
+    logged |= std::string(r.b.begin(), r.b.end()) == "Settings from another profile";
+  EXPECT(logged == (saved != 0xFF && saved != TIMING.id));
+  note("saved under %u, running %s", saved, TIMING.name);
+}
+
+// Limit bounce while attached, then a real drop. Variants: range sensor
+// and IMU, range sensor dead (fall time only), impact before the window
+// with the range sensor dead, no IMU (limit and range sensor only).
+void drop_fusion() {
+  uint32_t variant = rnd(0, 3);
+  const char *names[] = { "range + imu", "range dead", "impact", "no imu" };
+  if (variant == 3) host::accel.present = false;
+  boot();
+  EXPECT(imu_ok == (variant != 3));
+  arm();
+  host::drive(PIN_LIMIT, HIGH);
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host::run_ms(rnd(50, 500));
+
+  // Open long enough to debounce, too short for the limit alone.
+  uint64_t t0 = now_us();
+  host::drive(PIN_LIMIT, LOW);
+  host::run_ms(SENSOR_DEBOUNCE_MS + rnd(1, FUSE_FULL / fusion_config.limit_gain - SENSOR_DEBOUNCE_MS - 3));
+  host::drive(PIN_LIMIT, HIGH);
+  host::run_ms(20);
+  EXPECT(state == ARMED_FLY && traced(TR_RELEASE, IN_LIMIT, t0) && !traced(TR_PRESS, IN_RELEASED, t0));
+
+  phase();
+  t0 = now_us();
+  uint32_t impact_ms = variant == 2 ? rnd(200, 500) : 0;
+  host::drive(PIN_LIMIT, LOW);
+  fall(1500, variant == 0 || variant == 3, impact_ms);
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  uint16_t gain = fusion_config.limit_gain + (variant == 3 ? 0 : fusion_config.fall_gain);
+  EXPECT(traced(TR_STATE, ARMED_SENSING, t0) - t0 <= SENSOR_DEBOUNCE_MS * 1000 + fuse_bound_us(gain));
+
+  if (variant == 2) {
+    host::run_ms(1500);
+    EXPECT(state == ARMED_SENSING && !traced(TR_PRESS, IN_AT_ALT, t0));   // tumbling on the ground does not add up
+    EXPECT(fuse_fall_ms < fuse_kin_ms && fuse_fall_ms + SENSOR_DEBOUNCE_MS + 3 >= impact_ms);
+  } else {
+    EXPECT(run_until_state(ARMED_IR_FLASH, 1500));
+    uint64_t t = traced(TR_TX_START, 0, t0) - t0;
+    int32_t fallen = (int32_t)(9807 * t / 1000 * t / 2000000000);   // 1/2 g t^2, mm
+    if (variant == 3) EXPECT(fallen >= alt_config.threshold_mm);    // range filter lag only
+    else EXPECT(fallen >= fusion_config.kin_mm && fallen <= fusion_config.kin_mm + alt_config.hysteresis_mm);
+    note("%s: fired %u mm down", names[variant], fallen);
+    EXPECT(run_until_state(EXPENDED, 1000));
+  }
+
+  host::run_ms(20);
+  std::vector<Record> fu = records(TM_FUSE);
+  EXPECT(fu.size() == (variant == 2 ? 1u : 2u));
+  uint8_t want = FUSE_SRC_LIMIT | (variant == 3 ? 0 : FUSE_SRC_FALL);
+  EXPECT(fu[0].u8(4) == FUSE_RELEASED && fu[0].u8(5) == want && fu[0].u32(6) < fuse_bound_us(gain));
+  if (variant != 3) EXPECT(fu[0].u32(6) + 2 * FUSE_TICK_US < fuse_bound_us(fusion_config.limit_gain));   // quicker than the limit alone
+  if (variant == 0 || variant == 1) EXPECT(fu[1].u8(4) == FUSE_AT_ALT && (fu[1].u8(5) & FUSE_SRC_KIN));
+  if (variant == 3) EXPECT(fu[1].u8(4) == FUSE_AT_ALT && fu[1].u8(5) == FUSE_SRC_ALT);
+}
+
+// A host command frame, as MILES_GUI.py sends it.
+void host_cmd(HostCmd type, const std::vector<uint8_t> &payload) {
+  TelemBody r;
+  telem_begin(r, (TelemType)type);
+  for (uint8_t b : payload) telem_put(r, b, 1);
+  std::string f;
+  f += (char)TELEM_SYNC; f += (char)r.n;
+  f.append((const char *)r.b, r.n);
+  f += (char)telem_crc8(r.b, r.n, telem_crc8(&r.n, 1));
+  host::serial_send(f);
+}
+
+std::vector<uint8_t> events(std::initializer_list<std::pair<uint8_t, int16_t>> ev) {
+  std::vector<uint8_t> p;
+  for (auto &e : ev) { p.push_back(e.first); p.push_back((uint8_t)e.second); p.push_back((uint8_t)((uint16_t)e.second >> 8)); }
+  return p;
+}
+
+void gui_bridge() {
+  boot();
+  host_cmd(HC_MIRROR, { 1 });
+  host::run_ms(20);
+  std::vector<Record> ui = records(TM_UI);
+  EXPECT(ui.size() == 1 && ui[0].u8(4) == SAFE_STATE && ui[0].u8(5) == active_index);
+
+  // Two buttons in one frame, released in the next; a torn frame and one
+  // with a bad CRC in between change nothing.
+  host_cmd(HC_INJECT, events({ { IN_NEXT, 1 }, { IN_SIDE, 1 } }));
+  host::run_ms(DEBOUNCE_MS + 10);
+  host::serial_send(std::string("\xA5\x04\x02\x01", 4));
+  host::run_ms(HOST_RX_TIMEOUT_MS + 20);
+  std::string bad = std::string("\xA5\x04\x02\x00\x01\x00\x00", 7);
+  host::serial_send(bad);
+  host_cmd(HC_INJECT, events({ { IN_NEXT, 0 }, { IN_SIDE, 0 } }));
+  host::run_ms(DEBOUNCE_MS + 10);
+  EXPECT(active_index == 1 % reg_count && active_side_opfor);
+
+  // The whole flight from the host: PWR hold, limit, altitude.
+  host_cmd(HC_INJECT, events({ { IN_PWR, 1 } }));
+  EXPECT(run_until_state(SAFE_READY, PWR_HOLD_MS + DEBOUNCE_MS + 10));
+  host_cmd(HC_INJECT, events({ { IN_PWR, 0 }, { IN_LIMIT, 1 } }));
+  EXPECT(run_until_state(ARMED_FLY, 50));
+  host_cmd(HC_INJECT, events({ { IN_LIMIT, 0 } }));
+  EXPECT(run_until_state(ARMED_SENSING, 50));
+  int16_t below = (int16_t)-rnd(1, 3000);   // under the ground reference: filtered, no trigger
+  host_cmd(HC_INJECT, events({ { IN_ALT, below } }));
+  host::run_ms(300);
+  EXPECT(state == ARMED_SENSING && alt_mm() < 0 && alt_mm() >= below - 1);
+  host_cmd(HC_INJECT, events({ { IN_ALT, (int16_t)rnd(3200, 30000) } }));
+  EXPECT(run_until_state(EXPENDED, 1000));
+  host::run_ms(50);
+
+  ui = records(TM_UI);
+  const Record &last = ui.back();
+  EXPECT(last.u8(4) == EXPENDED && last.u8(6) == reg_entries[active_index].id);
+  EXPECT(last.u8(7) == (1 | 4) && last.u32(9) == 1);     // OPFOR, ALT, one shot
+  EXPECT(last.u32(13) == flash_event_ms && last.u32(21) == t_expended_start);
+  for (size_t i = 1; i < ui.size(); i++) EXPECT(ui[i].u32(0) - ui[i - 1].u32(0) >= MIRROR_MIN_MS);
+
+  // Detach: inputs go back to the hardware and the mirror stops.
+  host_cmd(HC_MIRROR, { 0 });
+  host::run_ms(10);
+  EXPECT(input_injected == 0 && alt_injected == ALT_NOT_INJECTED && !mirror_on);
+  size_t n = records(TM_UI).size();
+  EXPECT(run_until_state(SAFE_STATE, EXPENDED_MS + 100));
+  host::run_ms(50);
+  EXPECT(records(TM_UI).size() == n);
+  note("%zu TM_UI records", n);
+}
+
+// Shot log ring as the firmware addresses it, straight in the FS image.
+ShotRecord *shotlog_image() {
+  return (ShotRecord *)(host_fs_image + JOURNAL_BYTES + FLASH_SECTOR_SIZE);
+}
+
+// A previous session's records at the end of the ring, so the first new
+// shot wraps into the first sector. An older record there must not survive
+// the wrap's erase.
+uint32_t seed_shots(uint32_t n, uint32_t first_seq, uint8_t boot) {
+  ShotRecord *img = shotlog_image();
+  for (uint32_t i = 0; i < n; i++) {
+    ShotRecord r;
+    memset(&r, 0, sizeof(r));
+    r.seq = first_seq + i; r.t_ms = 1000 * (i + 1); r.boot = boot;
+    r.latency_us = 0xFFFF; r.pid = builtin_protocols[0].id;
+    r.crc = shotlog_crc(&r);
+    img[SHOTLOG_SLOTS - n + i] = r;
+  }
+  ShotRecord old = img[SHOTLOG_SLOTS - n];
+  old.seq = first_seq - SHOTLOG_SLOTS; old.crc = shotlog_crc(&old);
+  img[5] = old;
+  return first_seq + n - 1;
+}
+
+void shot_log() {
+  uint32_t seeded = rnd(1, 20), last = seed_shots(seeded, rnd(100, 100000), (uint8_t)rnd(0, 50));
+  uint8_t prev_boot = shotlog_image()[SHOTLOG_SLOTS - 1].boot;
+  host::wire(PIN_OUT, PIN_IR_SENSE, rnd(5, 150));
+  boot();
+  EXPECT(shotlog_ok && shotlog_next == 0 && shotlog_seq == last && shotlog_boot == prev_boot + 1);
+
+  uint32_t shots = rnd(1, 3);
+  std::vector<uint32_t> latency, t_ms;
+  for (uint32_t k = 0; k < shots; k++) {
+    arm();
+    host::drive(PIN_LIMIT, HIGH);
+    EXPECT(run_until_state(ARMED_FLY, 50));
+    host::drive(PIN_LIMIT, LOW);
+    EXPECT(run_until_state(ARMED_SENSING, 50));
+    host::run_ms(rnd(10, 300));
+    uint32_t programs = host::flash_programs;
+    button(PIN_BTN_FIRE, true);
+    EXPECT(run_until_state(EXPENDED, 1000));
+    button(PIN_BTN_FIRE, false);
+    EXPECT(flash_confirmed);
+    latency.push_back(flash_latency_us); t_ms.push_back(flash_event_ms);
+    host::run_ms(20);
+    EXPECT(host::flash_programs == programs + 1 && !shotlog_pending());   // one page, written in EXPENDED
+    EXPECT(run_until_state(SAFE_STATE, EXPENDED_MS + 100));
+  }
+  EXPECT(shotlog_next == shots && shotlog_seq == last + shots);
+  EXPECT(!shotlog_valid(&shotlog_image()[5]));           // erased with the first sector
+
+  host::serial_send("D");
+  EXPECT(host::run_while_not([] { return serial_line("Shot log:") != ""; }, 2000));
+  EXPECT(field(serial_line("Shot log:"), "Shot log: ") == (long)(seeded + shots));
+  std::vector<Record> rec = records(TM_SHOT);
+  EXPECT(rec.size() == seeded + shots);
+  for (uint32_t i = 0; i < rec.size(); i++) {
+    const Record &r = rec[i];
+    EXPECT(r.u32(0) == last - seeded + 1 + i);             // oldest first, no gaps
+    if (i < seeded) { EXPECT(r.u16(8) == prev_boot && r.u32(4) == 1000 * (i + 1)); continue; }
+    uint32_t k = i - seeded;
+    EXPECT(r.u16(8) == prev_boot + 1 && r.u32(4) == t_ms[k]);
+    EXPECT(r.u16(10) == latency[k] && r.u8(12) == reg_entries[active_index].id);
+    EXPECT(r.u8(13) == SHOT_CONFIRMED && r.u8(14) == 0);
+  }
+
+  // Next power cycle: the scan finds the new records and the next boot number.
+  EXPECT(shotlog_init() && shotlog_seq == last + shots && shotlog_next == shots && shotlog_boot == prev_boot + 2);
+  note("%u seeded + %u new records, %u erases", seeded, shots, host::flash_erases);
+}
+
+// replay() on a scripted sortie: every state in order, each at the time
+// the script and the timing profile put it. Bad scripts are refused.
+void replay_trace() {
+  std::vector<ReplayStep> steps;
+  std::string err;
+  EXPECT(!replay_parse("100 PWR 1\n50 PWR 0\n200 END\n", steps, err) && err.find("line 2") == 0);
+  EXPECT(!replay_parse("100 FOO 1\n", steps, err) && !replay_parse("100 PWR 1\n", steps, err));
+
+  uint32_t t_pwr = rnd(10, 500), t_lim = t_pwr + PWR_HOLD_MS + 200, t_drop = t_lim + rnd(100, 2000);
+  uint32_t t_alt = t_drop + rnd(50, 500), t_end = t_alt + EXPENDED_MS + 500;
+  char script[256];
+  snprintf(script, sizeof(script), "# sortie\n%u PWR 1\n%u PWR 0\n%u LIMIT 1\n%u LIMIT 0\n%u ALT 4000   # 4 m\n%u END\n",
+           t_pwr, t_pwr + (uint32_t)PWR_HOLD_MS + 100, t_lim, t_drop, t_alt, t_end);
+  EXPECT(replay_parse(script, steps, err) && steps.size() == 6);
+  std::string trace = replay(steps);
+
+  const char *expect[] = { "STATE SAFE_READY", "STATE ARMED_FLY", "STATE ARMED_SENSING", "TX 0",
+                           "STATE ARMED_IR_FLASH", "STATE EXPENDED", "STATE SAFE_STATE" };
+  double t[7] = {};
+  size_t n = 0, at = 0;
+  for (size_t eol; (eol = trace.find('\n', at)) != std::string::npos; at = eol + 1, n++) {
+    char what[16], arg[16];
+    EXPECT(n < 7 && sscanf(trace.c_str() + at, "%lf %15s %15s", &t[n], what, arg) == 3);
+    EXPECT(std::string(what) + " " + arg == expect[n]);
+  }
+  EXPECT(n == 7);
+  EXPECT(t[0] >= t_pwr + DEBOUNCE_MS + PWR_HOLD_MS - 1 && t[0] <= t_pwr + DEBOUNCE_MS + PWR_HOLD_MS);
+  EXPECT(t[1] > t_lim && t[1] <= t_lim + SENSOR_DEBOUNCE_MS + 1);
+  EXPECT(t[2] > t_drop && t[2] <= t_drop + SENSOR_DEBOUNCE_MS + fuse_bound_us(fusion_config.limit_gain) / 1000.0);
+  EXPECT(t[3] > t_alt && t[4] == t[3] && t[5] >= t[3] + CONFIRM_WINDOW_MS);   // FIRE, then the state
+  EXPECT(t[6] >= t[5] + EXPENDED_MS && t[6] <= t[5] + EXPENDED_MS + 1);
+  note("ALT->TX %.3f ms, TX->EXPENDED %.3f ms", t[3] - t_alt, t[5] - t[3]);
+}
+
+void standby() {
+  boot();
+  host::run_ms(STANDBY_IDLE_MS + 100);
+  EXPECT(!host::panel.on);
+  EXPECT(digitalRead(LED_SAFE) == LOW);
+  EXPECT(host_clocks_hw.sleep_en0 != 0xFFFFFFFFu);
+  host::run_ms(rnd(100, 5000));
+  EXPECT(host::deep_sleep_ns > 0);
+
+  uint64_t t0 = now_us();
+  button(PIN_BTN_PWR, true);
+  host::run_ms(10);
+  EXPECT(host::panel.on && digitalRead(LED_SAFE) == HIGH);
+  EXPECT(host_clocks_hw.sleep_en0 == 0xFFFFFFFFu);
+  uint64_t t_ready = traced(TR_WAKE_READY, TRACE_ANY, t0) - t0;
+  host::run_ms(PWR_HOLD_MS + rnd(100, 1000));      // the wake press held on: no arm
+  EXPECT(state == SAFE_STATE);
+  button(PIN_BTN_PWR, false);
+  host::run_ms(DEBOUNCE_MS + 10);
+  button(PIN_BTN_PWR, true);                       // a fresh hold arms as usual
+  EXPECT(run_until_state(SAFE_READY, PWR_HOLD_MS + DEBOUNCE_MS + 10));
+  button(PIN_BTN_PWR, false);
+  host::run_ms(20);
+  std::vector<Record> wake = records(TM_WAKE);
+  EXPECT(wake.size() == 1 && wake[0].u32(4) == t_ready);
+  note("slept %.1f s deep, edge->ready %llu us", host::deep_sleep_ns / 1e9, (unsigned long long)t_ready);
+}
+
+// Runs the suite with the echo wired back and prints its lines.
+void bench_suite() {
+  uint32_t echo_us = rnd(5, 150);
+  host::wire(PIN_OUT, PIN_IR_SENSE, echo_us);
+  boot();
+  EXPECT(host::run_while_not([] { return host::serial_out.find("\"bench\":\"settings_commit\"") != std::string::npos; }, 10000));
+  host::run_ms(5);
+  const std::string &s = host::serial_out;
+  uint32_t lines = 0;
+  for (size_t i = s.find("{\"bench"); i != std::string::npos; i = s.find("{\"bench", i + 1)) {
+    size_t end = s.find('\n', i);
+    EXPECT(end != std::string::npos);
+    printf("%.*s\n", (int)(end - i), s.data() + i);
+    lines++;
+  }
+  EXPECT(lines == bench_count + 1u);   // build stamp + results
+  EXPECT(bench_count == 9);
+  EXPECT(bench_results[3].max <= 1);                               // tx_air_err: the PIO model is exact
+  EXPECT(bench_results[4].n == BENCH_TX_SHOTS && bench_results[4].min >= echo_us);
+  EXPECT(host::flash_programs >= BENCH_JOURNAL_WRITES);
+  EXPECT(shot_count == 0 && state == SAFE_STATE);
+}
+
+struct Scenario {
+  const char *name;
+  void (*run)();
+  const char *what;
+};
+
+const Scenario scenarios[] = {
+#if MILES_BENCH
+  { "bench",            bench_suite,      "boot-time microbenchmarks, JSON lines on stdout" },
+#else
+  { "boot_safe",        boot_safe,        "power-on into SAFE, GUI and telemetry up" },
+  { "fast_boot",        fast_boot,        "armable within 2 ms without USB, first frame by DMA, boot times reported" },
+  { "arm_drop_fire",    arm_drop_fire,    "arm, fly, drop, climb through 3 m, salvo with echo, back to SAFE" },
+  { "manual_fire",      manual_fire,      "FIRE button from ARMED_SENSING" },
+  { "scope_selftest",   scope_selftest,   "PIO edge timer report of a shot: per-bin error within 2 cycles" },
+  { "carrier",          carrier,          "PWM carrier gated onto the emitter pin only inside envelope pulses" },
+  { "glyph_cache",      glyph_cache,      "glyph-strip redraws match font rendering byte for byte" },
+  { "rx_decode",        rx_decode,        "back-to-back foreign frames decoded and scored, own burst seen as echo" },
+  { "disarm",           disarm,           "PWR long-press in flight returns to SAFE without a shot" },
+  { "no_echo",          no_echo,          "nothing on the self-sense input: shot unconfirmed" },
+  { "lost_frame",       lost_frame,       "one salvo frame without echo reported unseen, not matched to the next" },
+  { "full_ring",        full_ring,        "EV_TX_DONE lost to a full event ring: the shot still completes" },
+  { "retry",            retry,            "missing echo resent once after the confirm window, then confirmed" },
+  { "retry_disarm",     retry_disarm,     "PWR during a retry: the burst on air finishes, no more retries" },
+  { "drop_fusion",      drop_fusion,      "limit bounce ignored; drops with and without range sensor / IMU, impact" },
+  { "settings_persist", settings_persist, "NEXT/SIDE coalesced into one journal record" },
+  { "journal_torn",     journal_torn,     "torn records after the newest one are skipped, not erased with it" },
+  { "profile_mismatch", profile_mismatch, "settings from another timing profile apply and are logged" },
+  { "gui_bridge",       gui_bridge,       "mirror records and injected inputs fly a whole shot from the host" },
+  { "shot_log",         shot_log,         "shots recorded in the flash ring across a wrap, 'D' downloads them" },
+  { "replay_trace",     replay_trace,     "scripted inputs replayed on time, state trace in order and on time" },
+  { "standby",          standby,          "idle standby with gated clocks, PWR wake" },
+#endif
+};
+const size_t NUM_SCENARIOS = sizeof(scenarios) / sizeof(scenarios[0]);
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  uint32_t runs = 1, first = 0;
+  const char *telem_path = nullptr, *replay_path = nullptr;
+  std::vector<const bench::Scenario *> pick;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "-n" && i + 1 < argc) runs = (uint32_t)strtoul(argv[++i], nullptr, 0);
+    else if (a == "-s" && i + 1 < argc) first = (uint32_t)strtoul(argv[++i], nullptr, 0);
+    else if (a == "-t" && i + 1 < argc) telem_path = argv[++i];
+    else if (a == "-r" && i + 1 < argc) replay_path = argv[++i];
+    else if (a == "-v") bench::verbose = true;
+    else if (a == "-l") { for (const auto &s : bench::scenarios) printf("%-18s %s\n", s.name, s.what); return 0; }
+    else {
+      const bench::Scenario *hit = nullptr;
+      for (const auto &s : bench::scenarios) if (a == s.name) hit = &s;
+      if (!hit) { fprintf(stderr, "usage: %s [-n runs] [-s seed] [-v] [-t telem.bin] [-l] [-r scenario.txt] [scenario...]\n", argv[0]); return 2; }
+      pick.push_back(hit);
+    }
+  }
+  if (replay_path) {                   // one run in this process, trace on stdout
+    FILE *f = fopen(replay_path, "r");
+    if (!f) { perror(replay_path); return 2; }
+    std::string text, err;
+    char buf[512];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+    fclose(f);
+    std::vector<bench::ReplayStep> steps;
+    if (!bench::replay_parse(text, steps, err)) { fprintf(stderr, "%s: %s\n", replay_path, err.c_str()); return 2; }
+    bench::scenario = replay_path;
+    fputs(bench::replay(steps).c_str(), stdout);
+    return 0;
+  }
+  if (pick.empty()) for (const auto &s : bench::scenarios) pick.push_back(&s);
+
+  int telem_fd = telem_path ? open(telem_path, O_WRONLY | O_CREAT | O_APPEND, 0644) : -1;
+  uint64_t *virt_ns = (uint64_t *)mmap(nullptr, sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  uint32_t total_failed = 0;
+
+  for (const bench::Scenario *sc : pick) {
+    uint32_t failed = 0;
+    uint64_t virt = 0;
+    auto w0 = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < runs; n++) {
+      fflush(stdout);
+      *virt_ns = 0;
+      pid_t pid = fork();
+      if (pid == 0) {
+        bench::scenario = sc->name;
+        bench::seed = first + n;
+        bench::rng = 2463534242u ^ (bench::seed * 2654435761u);
+        sc->run();
+        *virt_ns = host::now_ns;
+        if (telem_fd >= 0 && write(telem_fd, host::serial_out.data(), host::serial_out.size()) < 0) _exit(1);
+        fflush(stdout);
+        _exit(0);
+      }
+      int st = 0;
+      waitpid(pid, &st, 0);
+      if (WIFSIGNALED(st)) fprintf(stderr, "FAIL %s seed=%u: signal %d\n", sc->name, first + n, WTERMSIG(st));
+      if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) failed++;
+      virt += *virt_ns;
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - w0).count();
+    printf("%s %-18s %6u runs %4u failed %10.1f s virtual %8.0f runs/s\n", failed ? "FAIL" : "PASS",
+           sc->name, runs, failed, virt / 1e9, runs / (wall > 0 ? wall : 1e-9));
+    total_failed += failed;
+  }
+  if (telem_fd >= 0) close(telem_fd);
+  return total_failed ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+// Host shim: drawing lives in Adafruit_SSD1306.h.
+
+#include <Arduino.h>
+
+#endif // HOST_ADAFRUIT_GFX_H
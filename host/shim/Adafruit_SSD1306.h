@@ -0,0 +1,89 @@
+#ifndef HOST_ADAFRUIT_SSD1306_H
+#define HOST_ADAFRUIT_SSD1306_H
+
+/*
+  Host shim: SSD1306 framebuffer. Rectangles and pixels are drawn. Text goes
+  through Adafruit_GFX's cell layout (6x8 per character times the text size,
+  wrap at the right edge, transparent unless a background colour is given)
+  but with a made-up 5x7 glyph per character code, so framebuffers can be
+  compared byte for byte. display() pushes the whole buffer to host::panel
+  at the 400 kHz bus time.
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK        0
+#define SSD1306_WHITE        1
+#define SSD1306_INVERSE      2
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_DISPLAYOFF   0xAE
+#define SSD1306_DISPLAYON    0xAF
+
+inline bool host_oled_present = true;      // false: begin() fails like a missing panel
+
+class Adafruit_SSD1306 {
+public:
+  Adafruit_SSD1306(int16_t w, int16_t h, TwoWire *, int8_t) : w_(w), h_(h) { memset(buf_, 0, sizeof(buf_)); }
+  bool begin(uint8_t, uint8_t) {
+    if (!host_oled_present) return false;
+    if (!allocated_) { host::heap_used += sizeof(buf_); allocated_ = true; }   // the library mallocs its buffer once
+    host::panel.on = true;
+    return true;
+  }
+  void clearDisplay() { memset(buf_, 0, sizeof(buf_)); }
+  void display() {
+    memcpy(host::panel.ram, buf_, sizeof(buf_));
+    host::panel.bytes += sizeof(buf_);
+    host::panel.flushes++;
+    host::busy_ns((sizeof(buf_) + 8) * host::I2C_BYTE_NS);   // blocking push
+  }
+  void ssd1306_command(uint8_t c) {
+    if (c == SSD1306_DISPLAYOFF) host::panel.on = false;
+    if (c == SSD1306_DISPLAYON)  host::panel.on = true;
+  }
+  uint8_t *getBuffer() { return buf_; }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || y < 0 || x >= w_ || y >= h_) return;
+    uint8_t &b = buf_[(y / 8) * w_ + x], m = (uint8_t)(1u << (y & 7));
+    if (color == SSD1306_WHITE) b |= m; else if (color == SSD1306_BLACK) b &= ~m; else b ^= m;
+  }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t j = y; j < y + h; j++) for (int16_t i = x; i < x + w; i++) drawPixel(i, j, color);
+  }
+  void setTextSize(uint8_t s) { size_ = s; }
+  void setTextColor(uint16_t c) { fg_ = bg_ = c; }
+  void setTextColor(uint16_t c, uint16_t b) { fg_ = c; bg_ = b; }
+  void setCursor(int16_t x, int16_t y) { cx_ = x; cy_ = y; }
+  void dim(bool) {}
+  void print(const char *s) { while (*s) write(*s++); }
+  void print(char c) { write(c); }
+  template <typename T> void print(T v) { print(std::to_string(v).c_str()); }
+private:
+  void write(char c) {
+    if (c == '\n') { cx_ = 0; cy_ += 8 * size_; return; }
+    if (c == '\r') return;
+    if (cx_ + 6 * size_ > w_) { cx_ = 0; cy_ += 8 * size_; }
+    for (int8_t i = 0; i < 6; i++) {
+      uint8_t col = i < 5 ? glyph_col((uint8_t)c, i) : 0;
+      for (int8_t j = 0; j < 8; j++) {
+        uint16_t color = (col >> j) & 1 ? fg_ : bg_;
+        if (!((col >> j) & 1) && bg_ == fg_) continue;             // transparent
+        fillRect(cx_ + i * size_, cy_ + j * size_, size_, size_, color);
+      }
+    }
+    cx_ += 6 * size_;
+  }
+  static uint8_t glyph_col(uint8_t c, int8_t i) {
+    if (c == ' ') return 0;
+    uint32_t h = (c + 1u) * 2654435761u;
+    return (uint8_t)((h >> (5 * i + 3)) & 0x7F) | 0x01;           // rows 0..6, never blank
+  }
+  int16_t w_, h_, cx_ = 0, cy_ = 0;
+  uint8_t size_ = 1;
+  uint16_t fg_ = SSD1306_WHITE, bg_ = SSD1306_WHITE;
+  uint8_t buf_[128 * 64 / 8];
+  bool allocated_ = false;
+};
+
+#endif // HOST_ADAFRUIT_SSD1306_H
@@ -0,0 +1,101 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host shim: the arduino-pico core API used by the sketch, on host_sim.h.
+
+#define MILES_HEAP_TRAP 0   // the bench allocates after boot; heap_sealed still tells when boot ended
+
+#include "host_sim.h"
+#include <cmath>
+
+typedef unsigned int uint;
+
+#define LOW          0
+#define HIGH         1
+#define CHANGE       host::PE_CHANGE
+#define FALLING      host::PE_FALLING
+#define RISING       host::PE_RISING
+#define INPUT        host::PM_INPUT
+#define OUTPUT       host::PM_OUTPUT
+#define INPUT_PULLUP host::PM_PULLUP
+#define INPUT_PULLDOWN host::PM_PULLDOWN
+
+inline uint64_t time_us_64() { host::clock_read(); return host::now_ns / 1000; }
+inline uint32_t time_us_32() { return (uint32_t)time_us_64(); }
+inline unsigned long millis() { return (unsigned long)(time_us_64() / 1000); }
+inline unsigned long micros() { return (unsigned long)time_us_64(); }
+inline void delay(unsigned long ms) { host::busy_ns((uint64_t)ms * 1000000); }
+inline void delayMicroseconds(unsigned int us) { host::busy_ns((uint64_t)us * 1000); }
+inline void tight_loop_contents() { host::spin(); }
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= host::NUM_PINS) return;
+  host::pins[pin].mode = mode;
+  host::pins[pin].pio = false;
+  host::pin_changed(pin);
+}
+inline void digitalWrite(uint8_t pin, uint8_t v) {
+  if (pin >= host::NUM_PINS) return;
+  host::pins[pin].out = v != LOW;
+  host::pin_changed(pin);
+}
+inline int digitalRead(uint8_t pin) { return host::level(pin) ? HIGH : LOW; }
+
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(int pin, void (*isr)(void), int mode) {
+  if (pin < 0 || pin >= host::NUM_PINS) return;
+  host::pins[pin].isr = isr;
+  host::pins[pin].isr_mode = (uint8_t)mode;
+  host::pins[pin].last = host::level(pin);
+}
+inline void detachInterrupt(int pin) { if (pin >= 0 && pin < host::NUM_PINS) host::pins[pin].isr = nullptr; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+template <typename A, typename B> inline auto min(const A &a, const B &b) -> decltype(a < b ? a : b) { return b < a ? b : a; }
+template <typename A, typename B> inline auto max(const A &a, const B &b) -> decltype(a < b ? a : b) { return a < b ? b : a; }
+
+// USB CDC: writes land in host::serial_out, reads come from host::serial_in.
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  operator bool() const { return host::usb_host; }
+  int available() { return (int)host::serial_in.size(); }
+  int read() {
+    if (host::serial_in.empty()) return -1;
+    int c = host::serial_in.front(); host::serial_in.pop_front();
+    return c;
+  }
+  int availableForWrite() { return host::usb_host ? 64 : 0; }
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *p, size_t n) {
+    if (!host::usb_host) return 0;
+    host::serial_out.append((const char *)p, n);
+    return n;
+  }
+  void flush() {}
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print((long)v); }
+  size_t print(unsigned v) { return print((unsigned long)v); }
+  size_t print(long v) { char b[24]; snprintf(b, sizeof(b), "%ld", v); return print(b); }
+  size_t print(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); return print(b); }
+  size_t print(double v, int digits = 2) { char b[40]; snprintf(b, sizeof(b), "%.*f", digits, v); return print(b); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+  size_t println() { return print("\r\n"); }
+};
+inline HostSerial Serial;
+
+class HostRp2040 {
+public:
+  int cpuid() { return host::cpu(); }
+  void idleOtherCore() {}          // cooperative cores: the other one is not running
+  void resumeOtherCore() {}
+  void reboot() { host::reboot_requested = true; host::park(); }
+  uint32_t getCycleCount() { return (uint32_t)(host::now_ns * host::SYS_HZ / 1000000000ull); }
+  uint64_t getCycleCount64() { return host::now_ns * host::SYS_HZ / 1000000000ull; }
+  int getUsedHeap() { return (int)host::heap_used; }   // the shims' own allocations, see host_sim.h
+};
+inline HostRp2040 rp2040;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,26 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+// Host shim: emulated EEPROM in RAM (host::eeprom), 0xFF after power-up.
+
+#include <Arduino.h>
+
+class HostEEPROM {
+public:
+  bool begin(size_t n) { size_ = n <= sizeof(host::eeprom) ? n : sizeof(host::eeprom); return true; }
+  template <typename T> T &get(int addr, T &v) {
+    if (addr >= 0 && addr + sizeof(T) <= size_) memcpy(&v, host::eeprom + addr, sizeof(T));
+    return v;
+  }
+  template <typename T> const T &put(int addr, const T &v) {
+    if (addr >= 0 && addr + sizeof(T) <= size_) memcpy(host::eeprom + addr, &v, sizeof(T));
+    return v;
+  }
+  bool commit() { return true; }
+  bool end() { size_ = 0; return true; }
+private:
+  size_t size_ = 0;
+};
+inline HostEEPROM EEPROM;
+
+#endif // HOST_EEPROM_H
@@ -0,0 +1,2 @@
+// Host shim: the sketch includes the code table under this name.
+#include "../../MILES_CODES.H.h"
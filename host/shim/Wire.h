@@ -0,0 +1,17 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+// Host shim: I2C bus object; transfers are modelled in hardware/i2c.h.
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool setSDA(int) { return true; }
+  bool setSCL(int) { return true; }
+  void begin() {}
+  void setClock(uint32_t) {}
+};
+inline TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,30 @@
+#ifndef HOST_HARDWARE_ADC_H
+#define HOST_HARDWARE_ADC_H
+
+// Host shim: the ADC returns host::adc_value[input]. A DMA stream from the
+// FIFO sees the current value in every ring slot (the ring refills in 1 ms
+// at the sketch's rate, well inside any filter it feeds).
+
+#include <Arduino.h>
+
+typedef struct {
+  volatile uint32_t cs, result, fcs, fifo, div, intr, inte, intf, ints;
+} adc_hw_t;
+inline adc_hw_t host_adc_hw;
+#define adc_hw (&host_adc_hw)
+
+namespace host {
+inline volatile uint32_t *adc_fifo_reg() { return &host_adc_hw.fifo; }
+}
+
+inline void adc_init() { host::adc_running = false; }
+inline void adc_gpio_init(uint pin) { if (pin < host::NUM_PINS) host::pins[pin].mode = host::PM_INPUT; }
+inline void adc_select_input(uint input) { host::adc_input = (uint8_t)(input < 5 ? input : 4); host::adc_refill(); }
+inline uint adc_get_selected_input() { return host::adc_input; }
+inline void adc_set_clkdiv(float) {}
+inline void adc_fifo_setup(bool, bool, uint16_t, bool, bool) {}
+inline void adc_fifo_drain() {}
+inline void adc_run(bool on) { host::adc_running = on; host::adc_refill(); }
+inline uint16_t adc_read() { return host::adc_value[host::adc_input]; }
+
+#endif // HOST_HARDWARE_ADC_H
@@ -0,0 +1,19 @@
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+// Host shim: fixed 125 MHz system clock.
+
+#include <Arduino.h>
+
+enum clock_index { clk_gpout0 = 0, clk_gpout1, clk_gpout2, clk_gpout3, clk_ref, clk_sys, clk_peri, clk_usb, clk_adc, clk_rtc };
+
+inline uint32_t clock_get_hz(enum clock_index c) {
+  switch (c) {
+    case clk_sys: case clk_peri: return (uint32_t)host::SYS_HZ;
+    case clk_usb: case clk_adc:  return 48000000;
+    case clk_ref:                return 12000000;
+    default:                     return 0;
+  }
+}
+
+#endif // HOST_HARDWARE_CLOCKS_H
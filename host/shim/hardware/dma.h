@@ -0,0 +1,58 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+// Host shim: DMA channels. A transfer is handed to the model of the
+// peripheral it targets (PIO TX FIFO, I2C DATA_CMD, SPI DR, ADC FIFO),
+// anything else is copied at once.
+
+#include <Arduino.h>
+
+typedef host::DmaConfig dma_channel_config;
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+#define DREQ_PIO0_TX0 0
+#define DREQ_SPI0_TX  16
+#define DREQ_I2C0_TX  32
+#define DREQ_ADC      36
+
+inline int dma_claim_unused_channel(bool required) {
+  for (int ch = 0; ch < host::NUM_DMA; ch++) if (!host::dma[ch].claimed) { host::dma[ch].claimed = true; return ch; }
+  if (required) host::fail("no free DMA channel");
+  return -1;
+}
+inline void dma_channel_unclaim(uint ch) { host::dma[ch].claimed = false; }
+inline dma_channel_config dma_channel_get_default_config(uint) { return dma_channel_config(); }
+inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size s) { c->size = (uint8_t)s; }
+inline void channel_config_set_read_increment(dma_channel_config *c, bool on) { c->rinc = on; }
+inline void channel_config_set_write_increment(dma_channel_config *c, bool on) { c->winc = on; }
+inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->dreq = dreq; }
+inline void channel_config_set_chain_to(dma_channel_config *, uint) {}
+inline void channel_config_set_ring(dma_channel_config *c, bool write, uint bits) { c->ring_write = write; c->ring_bits = (uint8_t)bits; }
+
+inline void dma_channel_configure(uint ch, const dma_channel_config *c, volatile void *write, const volatile void *read,
+                                  uint count, bool trigger) {
+  host::DmaChan &d = host::dma[ch];
+  d.cfg = *c; d.write = write; d.read = read; d.count = count;
+  if (trigger) host::dma_start((int)ch);
+}
+inline void dma_channel_transfer_from_buffer_now(uint ch, const volatile void *read, uint32_t count) {
+  host::dma[ch].read = read; host::dma[ch].count = count;
+  host::dma_start((int)ch);
+}
+inline void dma_channel_transfer_to_buffer_now(uint ch, volatile void *write, uint32_t count) {
+  host::dma[ch].write = write; host::dma[ch].count = count;
+  host::dma_start((int)ch);
+}
+inline bool dma_channel_is_busy(uint ch) { return host::dma_busy((int)ch); }
+
+typedef struct { volatile uint32_t read_addr, write_addr, transfer_count, ctrl_trig; } dma_channel_hw_t;
+// Snapshot of the channel's registers; only transfer_count (words left) is modelled.
+inline dma_channel_hw_t *dma_channel_hw_addr(uint ch) {
+  static dma_channel_hw_t regs[host::NUM_DMA];
+  regs[ch].transfer_count = host::dma[ch].count;
+  return &regs[ch];
+}
+inline void dma_channel_abort(uint ch) { host::dma[ch].stream = false; host::dma[ch].busy_until = 0; }
+inline void dma_channel_set_irq0_enabled(uint, bool) {}
+inline void dma_channel_set_irq1_enabled(uint, bool) {}
+
+#endif // HOST_HARDWARE_DMA_H
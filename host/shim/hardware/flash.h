@@ -0,0 +1,38 @@
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+/*
+  Host shim: flash erase/program on the FS image from host_sim.h. Offsets
+  outside the FS region abort the run (on the target they would hit code).
+  Each call stalls the chip for the typical erase/program time.
+*/
+
+#include <Arduino.h>
+
+#define FLASH_PAGE_SIZE   256u
+#define FLASH_SECTOR_SIZE 4096u
+#define XIP_BASE          ((uintptr_t)&_FS_start - host::FS_OFFSET)
+
+namespace host {
+inline uint8_t *flash_at(uint32_t off, size_t len) {
+  if (off < FS_OFFSET || off + len > FS_OFFSET + FS_BYTES) fail("flash access outside the FS region");
+  return host_fs_image + (off - FS_OFFSET);
+}
+}  // namespace host
+
+inline void flash_range_erase(uint32_t off, size_t len) {
+  if (off % FLASH_SECTOR_SIZE || len % FLASH_SECTOR_SIZE) host::fail("unaligned flash erase");
+  memset(host::flash_at(off, len), 0xFF, len);
+  host::flash_erases += len / FLASH_SECTOR_SIZE;
+  host::stall_ns(len / FLASH_SECTOR_SIZE * host::FLASH_ERASE_NS);
+}
+
+inline void flash_range_program(uint32_t off, const uint8_t *data, size_t len) {
+  if (off % FLASH_PAGE_SIZE || len % FLASH_PAGE_SIZE) host::fail("unaligned flash program");
+  uint8_t *p = host::flash_at(off, len);
+  for (size_t i = 0; i < len; i++) p[i] &= data[i];   // programming only clears bits
+  host::flash_programs += len / FLASH_PAGE_SIZE;
+  host::stall_ns(len / FLASH_PAGE_SIZE * host::FLASH_PROGRAM_NS);
+}
+
+#endif // HOST_HARDWARE_FLASH_H
@@ -0,0 +1,25 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+// Host shim: SIO pin access on the host pin model.
+
+#include <Arduino.h>
+
+#define GPIO_IRQ_LEVEL_LOW  0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL  0x4u
+#define GPIO_IRQ_EDGE_RISE  0x8u
+
+enum gpio_function { GPIO_FUNC_SPI = 1, GPIO_FUNC_UART, GPIO_FUNC_I2C, GPIO_FUNC_PWM, GPIO_FUNC_SIO, GPIO_FUNC_PIO0, GPIO_FUNC_PIO1 };
+
+inline uint32_t gpio_get_all() { return host::gpio_all(); }
+inline bool gpio_get(uint pin) { return host::level((uint8_t)pin); }
+inline void gpio_put(uint pin, bool v) { digitalWrite((uint8_t)pin, v ? HIGH : LOW); }
+inline void gpio_set_function(uint pin, enum gpio_function fn) {
+  if (pin >= host::NUM_PINS) return;
+  host::pins[pin].pwm = fn == GPIO_FUNC_PWM;
+  host::pins[pin].pio = fn == GPIO_FUNC_PIO0 || fn == GPIO_FUNC_PIO1;
+  host::pin_changed((uint8_t)pin);
+}
+
+#endif // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,27 @@
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+// Host shim: I2C register block; DMA into DATA_CMD drives host::panel.
+
+#include <Arduino.h>
+
+typedef host::I2cHw i2c_hw_t;
+typedef struct i2c_inst { int n; } i2c_inst_t;
+inline i2c_inst_t host_i2c_inst[2] = { { 0 }, { 1 } };
+#define i2c0 (&host_i2c_inst[0])
+#define i2c1 (&host_i2c_inst[1])
+
+#define I2C_IC_DATA_CMD_STOP_BITS    0x200u
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x400u
+#define I2C_IC_DMA_CR_TDMAE_BITS     0x2u
+#define I2C_IC_STATUS_ACTIVITY_BITS  0x1u
+
+// STATUS.ACTIVITY tracks the modelled bus time of the last transfer.
+inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i) {
+  i2c_hw_t *hw = &host::i2c_hw[i->n];
+  hw->status = host::now_ns < host::i2c_busy_until ? I2C_IC_STATUS_ACTIVITY_BITS : 0;
+  return hw;
+}
+inline uint i2c_get_dreq(i2c_inst_t *i, bool tx) { return 32 + 2 * i->n + (tx ? 0 : 1); }
+
+#endif // HOST_HARDWARE_I2C_H
@@ -0,0 +1,25 @@
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+// Host shim: handler table for the peripheral models in host_sim.h.
+
+#include <Arduino.h>
+
+typedef void (*irq_handler_t)(void);
+enum {
+  TIMER_IRQ_0 = 0, TIMER_IRQ_1, TIMER_IRQ_2, TIMER_IRQ_3,
+  PIO0_IRQ_0 = 7, PIO0_IRQ_1, PIO1_IRQ_0, PIO1_IRQ_1,
+  DMA_IRQ_0, DMA_IRQ_1, IO_IRQ_BANK0,
+  ADC_IRQ_FIFO = 22
+};
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+inline void irq_add_shared_handler(uint num, irq_handler_t h, uint8_t) { host::irq_handlers[num].push_back(h); }
+inline void irq_set_exclusive_handler(uint num, irq_handler_t h) { host::irq_handlers[num] = { h }; }
+inline void irq_remove_handler(uint num, irq_handler_t h) {
+  auto &v = host::irq_handlers[num];
+  for (size_t i = 0; i < v.size(); i++) if (v[i] == h) { v.erase(v.begin() + i); break; }
+}
+inline void irq_set_enabled(uint num, bool on) { if (on) host::irq_enabled.insert(num); else host::irq_enabled.erase(num); }
+
+#endif // HOST_HARDWARE_IRQ_H
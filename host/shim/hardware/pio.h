@@ -0,0 +1,78 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+// Host shim: PIO blocks. Programs are not executed; see the PIO section of
+// host_sim.h for how TX FIFO traffic is turned into pin changes and how the
+// edge timers (scope and IR receiver) are modelled.
+
+#include <Arduino.h>
+
+typedef host::PioBlock pio_hw_t;
+typedef pio_hw_t *PIO;
+#define pio0 (&host::pio_blocks[0])
+#define pio1 (&host::pio_blocks[1])
+
+typedef struct {
+  const uint16_t *instructions;
+  uint8_t length;
+  int8_t origin;
+} pio_program_t;
+
+typedef struct { uint8_t out_base, out_count, in_base; int8_t jmp_pin; float clkdiv; } pio_sm_config;
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX, PIO_FIFO_JOIN_RX };
+enum pio_interrupt_source { pis_interrupt0 = 8, pis_interrupt1, pis_interrupt2, pis_interrupt3 };
+
+inline int pio_index(PIO p) { return p == pio1 ? 1 : 0; }
+
+inline bool pio_can_add_program(PIO p, const pio_program_t *prog) { return p->used + prog->length <= 32; }
+inline uint pio_add_program(PIO p, const pio_program_t *prog) {
+  uint offset = p->used;
+  p->program_at[offset] = prog->instructions;
+  p->used += prog->length;
+  return offset;
+}
+inline int pio_claim_unused_sm(PIO p, bool required) {
+  for (int s = 0; s < 4; s++) if (!p->sm[s].claimed) { p->sm[s].claimed = true; return s; }
+  if (required) host::fail("no free PIO state machine");
+  return -1;
+}
+inline void pio_gpio_init(PIO, uint pin) { if (pin < host::NUM_PINS) { host::pins[pin].pio = true; host::pin_changed((uint8_t)pin); } }
+inline void pio_sm_set_pins_with_mask(PIO, uint, uint32_t values, uint32_t mask) {
+  for (uint8_t pin = 0; pin < host::NUM_PINS; pin++) if (mask & (1u << pin)) host::pio_set_pin(pin, (values >> pin) & 1);
+}
+inline void pio_sm_set_consecutive_pindirs(PIO, uint, uint, uint, bool) {}
+
+inline pio_sm_config pio_get_default_sm_config() { return pio_sm_config{ 0, 0, 0, -1, 1.0f }; }
+inline void sm_config_set_wrap(pio_sm_config *, uint, uint) {}
+inline void sm_config_set_out_pins(pio_sm_config *c, uint base, uint count) { c->out_base = (uint8_t)base; c->out_count = (uint8_t)count; }
+inline void sm_config_set_in_pins(pio_sm_config *c, uint base) { c->in_base = (uint8_t)base; }
+inline void sm_config_set_set_pins(pio_sm_config *, uint, uint) {}
+inline void sm_config_set_sideset_pins(pio_sm_config *, uint) {}
+inline void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) { c->jmp_pin = (int8_t)pin; }
+inline void sm_config_set_out_shift(pio_sm_config *, bool, bool, uint) {}
+inline void sm_config_set_in_shift(pio_sm_config *, bool, bool, uint) {}
+inline void sm_config_set_fifo_join(pio_sm_config *, enum pio_fifo_join) {}
+inline void sm_config_set_clkdiv(pio_sm_config *c, float div) { c->clkdiv = div; }
+
+inline void pio_sm_init(PIO p, uint sm, uint offset, const pio_sm_config *c) {
+  host::PioSm &m = p->sm[sm];
+  m.enabled = false; m.out_base = c->out_base; m.in_base = c->in_base; m.jmp_pin = c->jmp_pin; m.clkdiv = c->clkdiv;
+  m.program = offset < 32 ? p->program_at[offset] : nullptr;
+}
+inline void pio_sm_put(PIO p, uint sm, uint32_t v) { p->txf[sm] = v; }
+inline void pio_sm_set_enabled(PIO p, uint sm, bool on) {
+  p->sm[sm].enabled = on;
+  if (on && p->sm[sm].jmp_pin >= 0) host::scope_enable(pio_index(p), (int)sm);
+}
+inline uint pio_get_dreq(PIO p, uint sm, bool tx) { return (uint)(pio_index(p) * 8 + (tx ? 0 : 4) + sm); }
+inline void pio_set_irq0_source_enabled(PIO p, enum pio_interrupt_source s, bool on) {
+  uint32_t bit = 1u << (s - pis_interrupt0);
+  p->irq0_sources = on ? (p->irq0_sources | bit) : (p->irq0_sources & ~bit);
+}
+inline void pio_set_irq1_source_enabled(PIO, enum pio_interrupt_source, bool) {}
+inline bool pio_interrupt_get(PIO p, uint n) { return (p->irq_flags >> n) & 1; }
+inline void pio_interrupt_clear(PIO p, uint n) { p->irq_flags &= ~(1u << n); }
+inline void pio_sm_clear_fifos(PIO, uint) {}
+inline void pio_sm_restart(PIO, uint) {}
+
+#endif // HOST_HARDWARE_PIO_H
@@ -0,0 +1,31 @@
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+// Host shim: PWM slices with an integer divider. Counters are not stepped;
+// see the PWM section of host_sim.h.
+
+#include <Arduino.h>
+#include "hardware/gpio.h"
+
+typedef struct { uint8_t div; uint16_t top; } pwm_config;
+
+inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7; }
+inline uint pwm_gpio_to_channel(uint gpio) { return gpio & 1; }
+
+inline pwm_config pwm_get_default_config() { return pwm_config{ 1, 0xffff }; }
+inline void pwm_config_set_clkdiv_int(pwm_config *c, uint div) { c->div = (uint8_t)(div ? div : 1); }
+inline void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) { c->top = wrap; }
+
+inline void pwm_set_enabled(uint slice, bool on) {
+  host::PwmSlice &s = host::pwm_slices[slice & 7];
+  if (on && !s.enabled) s.t0 = host::now_ns;
+  s.enabled = on;
+}
+inline void pwm_init(uint slice, pwm_config *c, bool start) {
+  host::PwmSlice &s = host::pwm_slices[slice & 7];
+  s.enabled = false; s.div = c->div; s.top = c->top; s.cc[0] = s.cc[1] = 0;
+  pwm_set_enabled(slice, start);
+}
+inline void pwm_set_chan_level(uint slice, uint chan, uint16_t level) { host::pwm_slices[slice & 7].cc[chan & 1] = level; }
+
+#endif // HOST_HARDWARE_PWM_H
@@ -0,0 +1,24 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+// Host shim: SPI register block; DMA through DR talks to host::accel.
+
+#include <Arduino.h>
+
+typedef host::SpiHw spi_hw_t;
+typedef struct spi_inst { int n; } spi_inst_t;
+inline spi_inst_t host_spi_inst[2] = { { 0 }, { 1 } };
+#define spi0 (&host_spi_inst[0])
+#define spi1 (&host_spi_inst[1])
+
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+inline uint spi_init(spi_inst_t *s, uint baud) { host::spi_baud[s->n] = baud; return baud; }
+inline void spi_deinit(spi_inst_t *s) { host::spi_baud[s->n] = 0; }
+inline void spi_set_format(spi_inst_t *, uint, spi_cpol_t, spi_cpha_t, spi_order_t) {}
+inline spi_hw_t *spi_get_hw(spi_inst_t *s) { return &host::spi_hw[s->n]; }
+inline uint spi_get_dreq(spi_inst_t *s, bool tx) { return 16 + 2 * s->n + (tx ? 0 : 1); }
+
+#endif // HOST_HARDWARE_SPI_H
@@ -0,0 +1,38 @@
+#ifndef HOST_HARDWARE_STRUCTS_CLOCKS_H
+#define HOST_HARDWARE_STRUCTS_CLOCKS_H
+
+// Host shim: the SLEEP_EN registers, readable by the bench (RP2040 bit layout).
+
+#include <Arduino.h>
+
+typedef struct {
+  volatile uint32_t wake_en0, wake_en1, sleep_en0, sleep_en1;
+} clocks_hw_t;
+inline clocks_hw_t host_clocks_hw = { 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu };
+#define clocks_hw (&host_clocks_hw)
+
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS               (1u << 31)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS               (1u << 30)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS               (1u << 29)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS               (1u << 28)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SIO_BITS                 (1u << 23)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_ROM_BITS                 (1u << 19)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PLL_USB_BITS             (1u << 15)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PLL_SYS_BITS             (1u << 14)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS                (1u << 11)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_VREG_AND_CHIP_RESET_BITS (1u << 10)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS                  (1u << 8)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS           (1u << 4)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_BUSCTRL_BITS             (1u << 3)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS              (1u << 0)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS                (1u << 14)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_XIP_BITS                 (1u << 13)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS            (1u << 12)
+#define CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS             (1u << 11)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS             (1u << 10)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS               (1u << 5)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_SYSCFG_BITS              (1u << 2)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS               (1u << 1)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS               (1u << 0)
+
+#endif // HOST_HARDWARE_STRUCTS_CLOCKS_H
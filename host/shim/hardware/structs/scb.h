@@ -0,0 +1,12 @@
+#ifndef HOST_HARDWARE_STRUCTS_SCB_H
+#define HOST_HARDWARE_STRUCTS_SCB_H
+
+// Host shim: per-core SCR, so the bench can see which core set SLEEPDEEP.
+
+#include <Arduino.h>
+
+typedef struct { volatile uint32_t scr; } armv6m_scb_hw_t;
+#define scb_hw (reinterpret_cast<armv6m_scb_hw_t *>(&host::cores[host::cpu()].scr))
+#define M0PLUS_SCR_SLEEPDEEP_BITS 0x4u
+
+#endif // HOST_HARDWARE_STRUCTS_SCB_H
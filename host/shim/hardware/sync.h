@@ -0,0 +1,24 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+// Host shim: interrupts are only delivered between core slices, so masking
+// them is a no-op; WFE/SEV drive the host core scheduler.
+
+#include <Arduino.h>
+
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t) {}
+inline void __wfe() { host::wfe(); }
+inline void __wfi() { host::wfe(); }
+inline void __sev() { host::sev(); }
+inline void __dmb() {}
+
+// Hardware spinlocks: with cooperative cores a section never interleaves.
+typedef volatile uint32_t spin_lock_t;
+inline spin_lock_t host_spin_locks[32];
+inline uint next_striped_spin_lock_num() { static uint n = 0; return 16 + n++ % 8; }
+inline spin_lock_t *spin_lock_instance(uint n) { return &host_spin_locks[n]; }
+inline uint32_t spin_lock_blocking(spin_lock_t *) { return save_and_disable_interrupts(); }
+inline void spin_unlock(spin_lock_t *, uint32_t irq) { restore_interrupts(irq); }
+
+#endif // HOST_HARDWARE_SYNC_H
@@ -0,0 +1,755 @@
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+/*
+  Discrete-event RP2040 model behind the host shims (see MILES_HOST.cpp).
+
+  Time is a virtual nanosecond clock that only moves when both cores are
+  waiting: code runs in zero time, and run_until() advances the clock to the
+  next timeline entry (alarm, scripted pin change, PIO segment, DMA end) or
+  core deadline. The two cores are coroutines (ucontext to start them,
+  _setjmp/_longjmp to switch, which skips the signal-mask syscalls) that
+  give up the CPU in WFE, best_effort_wfe_or_timeout(), delay() and busy-wait spins, so a
+  run is fully deterministic and independent of wall-clock speed.
+
+  Interrupts (alarms, GPIO edges, PIO/DMA completion) are delivered on core 0
+  from the scheduler, between core slices, and set the core's event flag the
+  way an exception entry ends a WFE.
+*/
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <deque>
+#include <vector>
+#include <setjmp.h>
+#include <ucontext.h>
+
+namespace host {
+
+// -------------------- Clock and timeline --------------------
+inline uint64_t now_ns = 0;
+
+struct Timed {
+  int32_t id;                              // alarm id, 0 = anonymous
+  std::function<void()> fn;
+};
+typedef std::pair<uint64_t, uint64_t> TimeKey;   // (t_ns, insertion order)
+inline std::map<TimeKey, Timed> timeline;
+inline std::map<int32_t, TimeKey> timeline_ids;
+inline uint64_t timeline_seq = 0;
+
+inline void at_ns(uint64_t t, std::function<void()> fn, int32_t id = 0) {
+  if (t < now_ns) t = now_ns;
+  TimeKey k(t, timeline_seq++);
+  timeline[k] = Timed{ id, std::move(fn) };
+  if (id) timeline_ids[id] = k;
+}
+inline void after_us(uint64_t us, std::function<void()> fn) { at_ns(now_ns + us * 1000, std::move(fn)); }
+
+inline bool cancel_id(int32_t id) {
+  auto it = timeline_ids.find(id);
+  if (it == timeline_ids.end()) return false;
+  timeline.erase(it->second);
+  timeline_ids.erase(it);
+  return true;
+}
+
+// -------------------- Cores --------------------
+const size_t CORE_STACK = 256 * 1024;
+const uint32_t SPIN_READS = 10000;         // clock reads without a yield that count as a busy-wait
+
+struct Core {
+  ucontext_t ctx;                          // first entry only
+  jmp_buf jb;
+  std::vector<char> stack;
+  bool started = false;
+  bool waiting = false;                    // in WFE / timed wait
+  bool wake_ev = false;                    // the wait ends on an event too
+  bool event = false;                      // ARM event register
+  bool parked = false;                     // never runs again (reboot)
+  uint64_t deadline = UINT64_MAX;
+  uint32_t reads = 0;
+  uint32_t scr = 0;                        // SCB->SCR, SLEEPDEEP lives here
+  void (*setup)() = nullptr;
+  void (*loop)() = nullptr;
+};
+inline Core cores[2];
+inline ucontext_t sched_ctx;
+inline jmp_buf sched_jb;
+inline int cur = -1;                       // running core, -1 = scheduler / ISR
+inline int irq_core = 0;                   // core an ISR is being delivered on
+inline bool reboot_requested = false;
+inline uint64_t deep_sleep_ns = 0;         // both cores in WFE with SLEEPDEEP set
+
+inline int cpu() { return cur >= 0 ? cur : irq_core; }
+
+inline void fail(const char *what) {
+  fprintf(stderr, "host: %s at t=%.3f ms\n", what, now_ns / 1e6);
+  exit(3);
+}
+
+// Gives the CPU back to the scheduler until deadline (or an event, if
+// wake_on_event).
+inline void yield_until(uint64_t deadline, bool wake_on_event) {
+  if (cur < 0) fail("blocking call from ISR context");
+  Core &c = cores[cur];
+  c.waiting = true;
+  c.wake_ev = wake_on_event;
+  c.deadline = deadline;
+  do {
+    if (!_setjmp(c.jb)) _longjmp(sched_jb, 1);
+  } while (!(wake_on_event && c.event) && now_ns < deadline);
+  c.waiting = false;
+  c.deadline = UINT64_MAX;
+  c.reads = 0;
+}
+
+inline void wfe() {
+  if (cur < 0) return;
+  Core &c = cores[cur];
+  if (!c.event) yield_until(UINT64_MAX, true);
+  c.event = false;
+}
+
+inline bool wfe_until(uint64_t deadline) {
+  if (cur < 0) return now_ns >= deadline;
+  Core &c = cores[cur];
+  if (!c.event && now_ns < deadline) yield_until(deadline, true);
+  c.event = false;
+  return now_ns >= deadline;
+}
+
+inline void sev() { cores[0].event = true; cores[1].event = true; }
+
+inline void busy_ns(uint64_t ns) { if (cur >= 0) yield_until(now_ns + ns, false); else now_ns += ns; }
+
+// A core that keeps reading the clock without waiting is spinning on it;
+// let 1 us pass so the thing it waits for can happen.
+inline void clock_read() {
+  if (cur < 0) return;
+  if (++cores[cur].reads >= SPIN_READS) busy_ns(1000);
+}
+inline void spin() { busy_ns(1000); }
+
+// Stalls the whole chip (flash erase/program with XIP off): the clock moves
+// but nothing is delivered until the stall ends.
+inline void stall_ns(uint64_t ns) { now_ns += ns; }
+
+template <typename F>
+inline void irq(int core, F fn) {
+  int sc = cur, si = irq_core;
+  cur = -1; irq_core = core;
+  fn();
+  cur = sc; irq_core = si;
+  cores[core].event = true;
+}
+
+inline void park() {
+  if (cur < 0) return;
+  cores[cur].parked = true;
+  yield_until(UINT64_MAX, false);
+}
+
+inline void core_entry(int n) {
+  Core &c = cores[n];
+  c.setup();
+  for (;;) c.loop();
+}
+inline void core0_entry() { core_entry(0); }
+inline void core1_entry() { core_entry(1); }
+
+inline void boot(void (*s0)(), void (*l0)(), void (*s1)(), void (*l1)()) {
+  void (*entry[2])() = { core0_entry, core1_entry };
+  cores[0].setup = s0; cores[0].loop = l0;
+  cores[1].setup = s1; cores[1].loop = l1;
+  for (int n = 0; n < 2; n++) {
+    Core &c = cores[n];
+    c.stack.resize(CORE_STACK);
+    getcontext(&c.ctx);
+    c.ctx.uc_stack.ss_sp = c.stack.data();
+    c.ctx.uc_stack.ss_size = c.stack.size();
+    c.ctx.uc_link = nullptr;
+    makecontext(&c.ctx, entry[n], 0);
+  }
+}
+
+inline bool runnable(const Core &c) {
+  if (c.parked || !c.setup) return false;
+  if (!c.started) return true;
+  return !c.waiting || (c.wake_ev && c.event) || now_ns >= c.deadline;
+}
+
+inline void resume(int n) {
+  Core &c = cores[n];
+  cur = n;
+  if (!_setjmp(sched_jb)) {
+    if (c.started) _longjmp(c.jb, 1);
+    c.started = true;
+    swapcontext(&sched_ctx, &c.ctx);
+  }
+  cur = -1;
+}
+
+inline bool deep_asleep(const Core &c) {
+  return c.parked || (c.waiting && (c.scr & 4u));
+}
+
+// Runs cores and delivers timeline entries up to t_end.
+inline void run_until(uint64_t t_end) {
+  for (;;) {
+    bool ran = false;
+    for (int n = 0; n < 2; n++) if (runnable(cores[n])) { resume(n); ran = true; }
+    if (ran) continue;
+
+    uint64_t next = timeline.empty() ? UINT64_MAX : timeline.begin()->first.first;
+    for (const Core &c : cores) if (c.waiting && !c.parked && c.deadline < next) next = c.deadline;
+    if (next > t_end) next = t_end;
+    if (next > now_ns && deep_asleep(cores[0]) && deep_asleep(cores[1])) deep_sleep_ns += next - now_ns;
+    if (next > now_ns) now_ns = next;
+    while (!timeline.empty() && timeline.begin()->first.first <= now_ns) {
+      auto it = timeline.begin();
+      Timed t = std::move(it->second);
+      if (t.id) timeline_ids.erase(t.id);
+      timeline.erase(it);
+      t.fn();
+    }
+    bool more = false;
+    for (const Core &c : cores) more |= runnable(c);
+    if (!more && now_ns >= t_end) return;
+  }
+}
+inline void run_ms(uint32_t ms) { run_until(now_ns + (uint64_t)ms * 1000000); }
+inline void run_us(uint32_t us) { run_until(now_ns + (uint64_t)us * 1000); }
+
+// Runs until pred() holds or timeout_ms passes; true if it held.
+template <typename P>
+inline bool run_while_not(P pred, uint32_t timeout_ms, uint32_t step_us = 100) {
+  uint64_t end = now_ns + (uint64_t)timeout_ms * 1000000;
+  while (!pred()) {
+    if (now_ns >= end) return false;
+    run_until(now_ns + step_us * 1000 < end ? now_ns + step_us * 1000 : end);
+  }
+  return true;
+}
+
+// -------------------- Interrupt controller --------------------
+typedef void (*isr_t)();
+inline std::map<unsigned, std::vector<isr_t>> irq_handlers;
+inline std::set<unsigned> irq_enabled;
+
+inline void raise_irq(unsigned num) {
+  if (!irq_enabled.count(num)) return;
+  auto it = irq_handlers.find(num);
+  if (it == irq_handlers.end()) return;
+  for (isr_t h : it->second) irq(0, h);
+}
+
+// -------------------- GPIO --------------------
+const uint8_t NUM_PINS = 30;
+enum PinMode_ : uint8_t { PM_INPUT = 0, PM_OUTPUT, PM_PULLUP, PM_PULLDOWN };
+enum PinEdge_ : uint8_t { PE_LOW = 0, PE_HIGH, PE_CHANGE, PE_FALLING, PE_RISING };
+
+struct Wire_ { uint8_t to; uint64_t delay_ns; };
+struct Pin {
+  uint8_t mode = PM_INPUT;
+  bool out = false;                        // SIO output latch
+  bool pio = false;                        // routed to a PIO
+  bool pwm = false;                        // routed to its PWM slice
+  bool pio_level = false;
+  bool ext_set = false, ext = false;       // driven by the test bench
+  bool last = false;
+  isr_t isr = nullptr;
+  uint8_t isr_mode = PE_CHANGE;
+  std::vector<Wire_> wires;
+  std::vector<std::pair<uint64_t, bool>> log;   // (t_ns, level) if logging
+  bool logging = false;
+};
+inline Pin pins[NUM_PINS];
+inline bool pwm_level(uint8_t p);          // PWM, below
+
+inline bool level(uint8_t p) {
+  if (p >= NUM_PINS) return false;
+  const Pin &s = pins[p];
+  if (s.pio) return s.pio_level;
+  if (s.pwm) return pwm_level(p);
+  if (s.mode == PM_OUTPUT) return s.out;
+  if (s.ext_set) return s.ext;
+  return s.mode == PM_PULLUP;
+}
+
+inline void drive(uint8_t p, bool l);
+inline void scope_edge(uint8_t p, bool l);   // PIO edge timer, below
+
+inline void pin_changed(uint8_t p) {
+  Pin &s = pins[p];
+  bool l = level(p);
+  if (l == s.last) return;
+  s.last = l;
+  if (s.logging) s.log.push_back({ now_ns, l });
+  scope_edge(p, l);
+  if (s.isr) {
+    bool hit = s.isr_mode == PE_CHANGE || (s.isr_mode == PE_RISING && l) || (s.isr_mode == PE_FALLING && !l);
+    if (hit) { isr_t f = s.isr; at_ns(now_ns, [f] { irq(0, f); }); }
+  }
+  for (const Wire_ &w : s.wires) { uint8_t to = w.to; at_ns(now_ns + w.delay_ns, [to, l] { drive(to, l); }); }
+}
+
+// Test bench side: an external driver on an input pin (overrides pulls).
+inline void drive(uint8_t p, bool l) { pins[p].ext_set = true; pins[p].ext = l; pin_changed(p); }
+inline void release(uint8_t p) { pins[p].ext_set = false; pin_changed(p); }
+// Every level change of `from` reaches `to` delay_us later (e.g. IR emitter to receiver).
+inline void wire(uint8_t from, uint8_t to, uint32_t delay_us) { pins[from].wires.push_back({ to, (uint64_t)delay_us * 1000 }); }
+inline void unwire(uint8_t from) { pins[from].wires.clear(); }
+inline void log_pin(uint8_t p) { pins[p].logging = true; pins[p].last = level(p); }
+
+inline uint32_t gpio_all() {
+  uint32_t v = 0;
+  for (uint8_t p = 0; p < NUM_PINS; p++) if (level(p)) v |= 1u << p;
+  return v;
+}
+
+// -------------------- ADC --------------------
+inline uint16_t adc_value[5] = { 0, 0, 0, 0, 0 };   // 12-bit counts per input
+inline uint8_t adc_input = 0;
+inline bool adc_running = false;
+inline void adc_refill();
+inline void set_adc(uint8_t input, uint16_t counts) { if (input < 5) adc_value[input] = counts & 0x0FFF; adc_refill(); }
+
+// -------------------- DMA --------------------
+const int NUM_DMA = 12;
+struct DmaConfig {
+  uint8_t size = 2;                        // 0: 8, 1: 16, 2: 32 bit
+  bool rinc = true, winc = false;
+  uint8_t ring_bits = 0;
+  bool ring_write = false;
+  unsigned dreq = 0x3f;
+};
+struct DmaChan {
+  bool claimed = false;
+  DmaConfig cfg;
+  volatile void *write = nullptr;
+  const volatile void *read = nullptr;
+  uint32_t count = 0;
+  uint64_t busy_until = 0;
+  bool stream = false;                     // paced by a free-running DREQ (ADC)
+};
+inline DmaChan dma[NUM_DMA];
+inline volatile uint32_t *adc_fifo_reg();   // from hardware/adc.h
+inline bool dma_feed(int ch);               // peripheral models, below
+
+inline bool dma_busy(int ch) { return ch >= 0 && ch < NUM_DMA && (dma[ch].stream || now_ns < dma[ch].busy_until); }
+
+inline void adc_refill() {
+  if (!adc_running) return;
+  for (DmaChan &c : dma) {
+    if (!c.stream || c.read != adc_fifo_reg()) continue;
+    size_t bytes = c.cfg.ring_bits ? (size_t)1 << c.cfg.ring_bits : c.count * 2;
+    uintptr_t base = (uintptr_t)c.write & ~(uintptr_t)(bytes - 1);
+    uint16_t *p = (uint16_t *)base;
+    for (size_t i = 0; i < bytes / 2; i++) p[i] = adc_value[adc_input];
+  }
+}
+
+inline void dma_start(int ch) {
+  DmaChan &c = dma[ch];
+  if (c.read == adc_fifo_reg()) { c.stream = true; adc_refill(); return; }
+  if (dma_feed(ch)) return;
+  // memory to memory: done at once
+  size_t w = (size_t)1 << c.cfg.size;
+  for (uint32_t i = 0; i < c.count; i++) {
+    const volatile uint8_t *r = (const volatile uint8_t *)c.read + (c.cfg.rinc ? i * w : 0);
+    volatile uint8_t *d = (volatile uint8_t *)c.write + (c.cfg.winc ? i * w : 0);
+    for (size_t b = 0; b < w; b++) d[b] = r[b];
+  }
+}
+
+// -------------------- PWM --------------------
+// Slices are not stepped: a pin routed to a running slice reads its level
+// from the time since the slice was enabled, and no events are scheduled
+// for its edges. The carrier gate (PIO, below) asks for them one at a time
+// while it passes the carrier through.
+const uint64_t CYCLE_NS = 8;               // at SYS_HZ
+
+struct PwmSlice {
+  bool enabled = false;
+  uint8_t div = 1;
+  uint16_t top = 0xffff;
+  uint16_t cc[2] = { 0, 0 };
+  uint64_t t0 = 0;                         // counter was 0 here
+};
+inline PwmSlice pwm_slices[8];
+
+inline uint64_t pwm_ticks(const PwmSlice &s, uint64_t t) { return (t - s.t0) / CYCLE_NS / s.div; }
+
+inline bool pwm_level(uint8_t p) {
+  const PwmSlice &s = pwm_slices[(p >> 1) & 7];
+  if (!s.enabled) return false;
+  return pwm_ticks(s, now_ns) % ((uint64_t)s.top + 1) < s.cc[p & 1];
+}
+
+// First time after now at which pin p changes level, UINT64_MAX if never.
+inline uint64_t pwm_next_edge(uint8_t p) {
+  const PwmSlice &s = pwm_slices[(p >> 1) & 7];
+  uint64_t period = (uint64_t)s.top + 1, cc = s.cc[p & 1];
+  if (!s.enabled || cc == 0 || cc >= period) return UINT64_MAX;
+  uint64_t tick = pwm_ticks(s, now_ns), ph = tick % period;
+  uint64_t next = tick - ph + (ph < cc ? cc : period);
+  return s.t0 + next * s.div * CYCLE_NS;
+}
+
+// -------------------- PIO (MILES TX program, edge timer) --------------------
+// The state machine programs are not interpreted: a DMA into an SM's TX FIFO
+// is decoded as MILES_TX.h words (level, last flag, cycle count) and turned
+// into timed pin changes plus the end-of-frame IRQ 0. An SM with a jmp pin
+// is an edge timer: each edge on that pin pushes the word the program
+// would, from the edge's cycle and the program's sampling grid. If its
+// program starts with a pull, it is MILES_RX.h's receiver. The pulled word
+// is the idle timeout, and the first rise after idle raises IRQ 0.
+// If it starts with "jmp pin", it is MILES_CARRIER.h's gate: the out pin
+// is the in pin while the jmp pin is high, else low (no gate delay).
+// Otherwise it is MILES_SCOPE.h's edge timer.
+const uint64_t SYS_HZ = 125000000;
+static_assert(1000000000ull / SYS_HZ == CYCLE_NS, "CYCLE_NS must match SYS_HZ");
+const uint32_t TX_OVERHEAD_CYCLES = 6;
+
+struct PioSm {
+  bool claimed = false;
+  uint8_t out_base = 0, in_base = 0;
+  bool enabled = false;
+  int8_t jmp_pin = -1;
+  uint8_t phase = 0;                       // edge timer: 0 wait low, 1 wait high, 2 high, 3 low
+  uint64_t seen = 0;                       // cycle the current level was sampled
+  float clkdiv = 1.0f;
+  const uint16_t *program = nullptr;
+  uint32_t timeout = 0;                    // receiver: low-loop passes before idle
+  uint32_t gen = 0;                        // receiver: invalidates a pending idle timeout
+};
+struct PioBlock {
+  volatile uint32_t txf[4];
+  volatile uint32_t rxf[4];
+  uint32_t irq_flags = 0;
+  uint32_t irq0_sources = 0;
+  PioSm sm[4];
+  uint8_t used = 0;                        // instruction slots taken
+  const uint16_t *program_at[32] = {};
+};
+inline PioBlock pio_blocks[2];
+
+inline void pio_set_pin(uint8_t pin, bool l) { pins[pin].pio_level = l; pin_changed(pin); }
+
+inline void pio_raise(int blk, unsigned flag) {
+  pio_blocks[blk].irq_flags |= 1u << flag;
+  if (pio_blocks[blk].irq0_sources & (1u << flag)) raise_irq(7 + 2 * blk);   // PIOx_IRQ_0
+}
+
+inline bool rx_program(const PioSm &m) { return m.program && m.program[0] == 0x80a0; }   // pull block
+inline bool gate_program(const PioSm &m) { return m.program && m.program[0] == 0x00c3 && m.program[1] == 0xa003; }
+
+// Re-evaluates the gate output and, while the envelope is high, follows a
+// PWM input to its next edge. gen drops edges scheduled before a change.
+inline void gate_update(int b, int s) {
+  PioSm &m = pio_blocks[b].sm[s];
+  uint32_t g = ++m.gen;
+  bool open = m.enabled && level((uint8_t)m.jmp_pin);
+  pio_set_pin(m.out_base, open && level(m.in_base));
+  if (!open || !pins[m.in_base].pwm) return;
+  uint64_t t = pwm_next_edge(m.in_base);
+  if (t != UINT64_MAX) at_ns(t, [b, s, g] { if (pio_blocks[b].sm[s].gen == g) gate_update(b, s); });
+}
+
+inline void scope_enable(int b, int s) {
+  PioSm &m = pio_blocks[b].sm[s];
+  if (gate_program(m)) { gate_update(b, s); return; }
+  m.phase = level((uint8_t)m.jmp_pin) ? 0 : 1;
+  if (rx_program(m)) { m.timeout = pio_blocks[b].txf[s]; m.gen++; }
+}
+
+// RX FIFO to memory: one word per push while the channel has count left.
+inline void scope_push(int b, int s, uint32_t w) {
+  for (DmaChan &c : dma) {
+    if (c.read != (const volatile void *)&pio_blocks[b].rxf[s] || c.count == 0 || c.busy_until <= now_ns) continue;
+    volatile uint32_t *d = (volatile uint32_t *)c.write;
+    *d = w;
+    uintptr_t next = (uintptr_t)(d + 1);
+    if (c.cfg.ring_write && c.cfg.ring_bits) {
+      uintptr_t m = ((uintptr_t)1 << c.cfg.ring_bits) - 1;
+      next = ((uintptr_t)d & ~m) | (next & m);
+    }
+    c.write = (volatile void *)next;
+    if (--c.count == 0) c.busy_until = now_ns;
+    return;
+  }
+}
+
+// Receiver, on its divided clock. A sample in cycle c sees the level at the
+// start of c, so an edge is first seen in cycle ceil(t / cycle). After a
+// rise seen in R, highs are sampled at R + 4 + 2i; a high ending in F is
+// followed by low samples at F + 3 + 2j, j <= timeout. Same words as the
+// scope: ~k for a 2k + 2 cycle high, timeout - j for a 2j + 3 cycle low.
+inline double sm_cycle_ns(const PioSm &m) { return m.clkdiv * 1e9 / (double)SYS_HZ; }
+
+inline void rx_edge(int b, int s, bool l) {
+  PioSm &m = pio_blocks[b].sm[s];
+  double cns = sm_cycle_ns(m);
+  int64_t e = (int64_t)((now_ns + cns - 1) / cns);
+  int64_t i;
+  switch (m.phase) {
+    case 0: if (!l) m.phase = 1; break;
+    case 1:
+      if (!l) break;
+      m.seen = (uint64_t)e; m.phase = 2;
+      pio_raise(b, 0);
+      break;
+    case 2: {
+      if (l) break;
+      i = (e - (int64_t)m.seen - 4 + 1) / 2;
+      if (i < 0) i = 0;
+      scope_push(b, s, ~(uint32_t)(i + 1));
+      m.seen += 4 + 2 * (uint64_t)i; m.phase = 3;
+      uint32_t g = ++m.gen;
+      uint64_t t_idle = (uint64_t)((m.seen + 3 + 2 * (uint64_t)m.timeout + 1) * cns);
+      at_ns(t_idle, [b, s, g] {
+        PioSm &q = pio_blocks[b].sm[s];
+        if (!q.enabled || q.phase != 3 || q.gen != g) return;
+        scope_push(b, s, 0xFFFFFFFFu);
+        q.phase = 1;
+      });
+      break;
+    }
+    case 3:
+      if (!l) break;
+      i = (e - (int64_t)m.seen - 3 + 1) / 2;
+      if (i < 0) i = 0;
+      scope_push(b, s, m.timeout - (uint32_t)i);
+      m.seen += 3 + 2 * (uint64_t)i; m.phase = 2; m.gen++;
+      break;
+  }
+}
+
+// Highs are sampled every 2 cycles from seen + 2 on, lows from seen + 3 on;
+// k loop passes push ~k (high 2k + 2, low 2k + 3 cycles).
+inline void scope_edge(uint8_t pin, bool l) {
+  int64_t cyc = (int64_t)(now_ns * SYS_HZ / 1000000000ull);
+  for (int b = 0; b < 2; b++) {
+    for (int s = 0; s < 4; s++) {
+      PioSm &m = pio_blocks[b].sm[s];
+      if (!m.enabled || m.jmp_pin != pin) continue;
+      if (gate_program(m)) { gate_update(b, s); continue; }
+      if (rx_program(m)) { rx_edge(b, s, l); continue; }
+      int64_t k;
+      switch (m.phase) {
+        case 0: if (!l) m.phase = 1; break;
+        case 1: if (l) { m.phase = 2; m.seen = (uint64_t)cyc; } break;
+        case 2:
+          if (l) break;
+          k = (cyc - (int64_t)m.seen - 2 + 1) / 2;
+          if (k < 1) k = 1;
+          scope_push(b, s, ~(uint32_t)k);
+          m.seen += 2 + 2 * (uint64_t)k; m.phase = 3;
+          break;
+        case 3:
+          if (!l) break;
+          k = (cyc - (int64_t)m.seen - 3 + 1) / 2;
+          if (k < 0) k = 0;
+          scope_push(b, s, ~(uint32_t)k);
+          m.seen += 3 + 2 * (uint64_t)k; m.phase = 2;
+          break;
+      }
+    }
+  }
+}
+
+inline bool pio_feed(int ch) {
+  DmaChan &c = dma[ch];
+  for (int b = 0; b < 2; b++) {
+    for (int s = 0; s < 4; s++) {
+      if (c.read == (const volatile void *)&pio_blocks[b].rxf[s]) { c.busy_until = UINT64_MAX; return true; }
+      if (c.write != (volatile void *)&pio_blocks[b].txf[s]) continue;
+      const uint32_t *wd = (const uint32_t *)c.read;
+      uint8_t pin = pio_blocks[b].sm[s].out_base;
+      uint64_t t = now_ns;
+      for (uint32_t i = 0; i < c.count; i++) {
+        bool l = (wd[i] >> 31) & 1, last = (wd[i] >> 30) & 1;
+        uint64_t cyc = (wd[i] & 0x3FFFFFFFu) + TX_OVERHEAD_CYCLES;
+        at_ns(t, [pin, l] { pio_set_pin(pin, l); });
+        t += cyc * 1000000000ull / SYS_HZ;
+        if (last) at_ns(t, [b] { pio_raise(b, 0); });
+      }
+      c.busy_until = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+// -------------------- I2C + SSD1306 panel --------------------
+// 400 kHz: 9 bit times per byte. The panel model follows the column/page
+// window and display on/off commands, enough to see what was sent.
+const uint64_t I2C_BYTE_NS = 9 * 2500;
+struct I2cHw { volatile uint32_t enable, tar, data_cmd, dma_cr, status; };
+inline I2cHw i2c_hw[2];
+inline uint64_t i2c_busy_until = 0;
+
+struct Panel {
+  uint8_t ram[1024];
+  bool on = false;
+  uint8_t c0 = 0, c1 = 127, p0 = 0, p1 = 7, col = 0, page = 0;
+  uint32_t bytes = 0, flushes = 0;
+};
+inline Panel panel;
+
+inline void panel_data(uint8_t d) {
+  panel.ram[(panel.page & 7) * 128 + (panel.col & 127)] = d;
+  if (++panel.col > panel.c1) { panel.col = panel.c0; if (++panel.page > panel.p1) panel.page = panel.p0; }
+}
+
+inline void panel_stream(const uint16_t *w, uint32_t n) {
+  bool control = true, data = false;
+  uint8_t cmd[3]; uint8_t nc = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    uint8_t b = (uint8_t)w[i];
+    if (control) { data = (b & 0x40) != 0; control = false; }
+    else if (data) panel_data(b);
+    else {
+      cmd[nc++] = b;
+      uint8_t need = (cmd[0] == 0x21 || cmd[0] == 0x22) ? 3 : 1;
+      if (nc == need) {
+        if (cmd[0] == 0x21) { panel.c0 = cmd[1] & 127; panel.c1 = cmd[2] & 127; panel.col = panel.c0; }
+        else if (cmd[0] == 0x22) { panel.p0 = cmd[1] & 7; panel.p1 = cmd[2] & 7; panel.page = panel.p0; }
+        else if (cmd[0] == 0xAE) panel.on = false;
+        else if (cmd[0] == 0xAF) panel.on = true;
+        nc = 0;
+      }
+    }
+    if (w[i] & 0x200) { control = true; nc = 0; }   // STOP ends the transaction
+  }
+  panel.bytes += n;
+  panel.flushes++;
+}
+
+inline bool i2c_feed(int ch) {
+  DmaChan &c = dma[ch];
+  for (I2cHw &h : i2c_hw) {
+    if (c.write != (volatile void *)&h.data_cmd) continue;
+    panel_stream((const uint16_t *)c.read, c.count);
+    uint64_t start = i2c_busy_until > now_ns ? i2c_busy_until : now_ns;
+    i2c_busy_until = start + c.count * I2C_BYTE_NS;
+    c.busy_until = i2c_busy_until - I2C_BYTE_NS;   // DMA is done once the last word is in the FIFO
+    return true;
+  }
+  return false;
+}
+
+// -------------------- SPI + accelerometer --------------------
+// A LIS3DH on the SPI block: WHO_AM_I, writable registers and the output
+// registers, with address auto-increment. Scenarios set accel.mg; a read
+// returns it as the part would at +/-16 g high resolution (12 mg per LSB,
+// left-justified), or zeros while CTRL_REG1 has it powered down. An absent
+// part reads 0xFF. A transfer is one RX + one TX DMA channel on DR, timed
+// at 8 bit clocks per byte.
+struct SpiHw { volatile uint32_t cr0, cr1, dr, sr, cpsr, imsc, ris, mis, icr, dmacr; };
+inline SpiHw spi_hw[2];
+inline uint32_t spi_baud[2] = { 0, 0 };
+inline int spi_rx_ch[2] = { -1, -1 };      // RX channel waiting for the TX side
+
+struct Accel {
+  bool present = true;
+  int16_t mg[3] = { 0, 0, 1000 };          // at rest, z up
+  uint8_t reg[64] = {};
+  uint32_t reads = 0;                      // bursts from OUT_X_L
+};
+inline Accel accel;
+
+inline uint8_t accel_reg(uint8_t r) {
+  if (r == 0x0F) return 0x33;
+  if (r >= 0x28 && r <= 0x2D) {
+    if ((accel.reg[0x20] >> 4) == 0) return 0;
+    int32_t mg = accel.mg[(r - 0x28) / 2];
+    mg = mg < -16000 ? -16000 : mg > 16000 ? 16000 : mg;
+    uint16_t v = (uint16_t)((mg / 12) * 16);
+    return (uint8_t)(r & 1 ? v >> 8 : v);
+  }
+  return accel.reg[r & 63];
+}
+
+inline void accel_transfer(const uint8_t *tx, uint8_t *rx, uint32_t n) {
+  if (!accel.present) { memset(rx, 0xFF, n); return; }
+  bool read = (tx[0] & 0x80) != 0, inc = (tx[0] & 0x40) != 0;
+  uint8_t a = tx[0] & 0x3F;
+  if (read && a == 0x28) accel.reads++;
+  rx[0] = 0xFF;
+  for (uint32_t i = 1; i < n; i++) {
+    if (read) rx[i] = accel_reg(a);
+    else { accel.reg[a] = tx[i]; rx[i] = 0xFF; }
+    if (inc) a = (a + 1) & 0x3F;
+  }
+}
+
+inline bool spi_feed(int ch) {
+  DmaChan &c = dma[ch];
+  for (int n = 0; n < 2; n++) {
+    SpiHw &h = spi_hw[n];
+    if (c.read == (const volatile void *)&h.dr) { spi_rx_ch[n] = ch; c.busy_until = UINT64_MAX; return true; }
+    if (c.write != (volatile void *)&h.dr) continue;
+    uint8_t rx[64];
+    uint32_t len = c.count < sizeof(rx) ? c.count : sizeof(rx);
+    accel_transfer((const uint8_t *)c.read, rx, len);
+    c.busy_until = now_ns + (uint64_t)len * 8 * 1000000000ull / (spi_baud[n] ? spi_baud[n] : 1000000);
+    if (spi_rx_ch[n] >= 0) {
+      DmaChan &r = dma[spi_rx_ch[n]];
+      memcpy((void *)r.write, rx, len < r.count ? len : r.count);
+      r.busy_until = c.busy_until;
+      spi_rx_ch[n] = -1;
+    }
+    return true;
+  }
+  return false;
+}
+
+inline bool dma_feed(int ch) { return pio_feed(ch) || i2c_feed(ch) || spi_feed(ch); }
+
+// -------------------- Flash --------------------
+// The FS region of a 2 MB part, backed by host memory and visible at
+// XIP_BASE + offset like the real XIP window.
+const uint32_t FS_OFFSET = 0x1C0000;
+const uint32_t FS_BYTES  = 0x40000;
+const uint64_t FLASH_ERASE_NS   = 45000000;    // per 4 KB sector
+const uint64_t FLASH_PROGRAM_NS = 400000;      // per 256 B page
+inline uint32_t flash_erases = 0, flash_programs = 0;
+inline uint32_t heap_used = 0;            // what the modelled libraries malloc() on the target
+
+// -------------------- USB serial --------------------
+inline bool usb_host = true;                // a host has the port open
+inline std::string serial_out;
+inline std::deque<uint8_t> serial_in;
+inline void serial_send(const std::string &s) { for (char ch : s) serial_in.push_back((uint8_t)ch); sev(); }
+
+// -------------------- EEPROM --------------------
+inline uint8_t eeprom[4096];
+inline bool eeprom_init = (memset(eeprom, 0xFF, sizeof(eeprom)), true);
+
+}  // namespace host
+
+// Flash image: one writable section so the FS symbols are link-time
+// constants inside it, as with the core's linker script.
+asm(".pushsection .data.host_fs,\"aw\",@progbits\n"
+    ".balign 4096\n"
+    ".globl _FS_start\n"
+    "_FS_start:\n"
+    ".fill 0x40000,1,0xff\n"
+    ".globl _FS_end\n"
+    "_FS_end:\n"
+    ".popsection\n");
+extern uint8_t _FS_start;
+extern uint8_t _FS_end;
+extern uint8_t host_fs_image[] asm("_FS_start");   // the same bytes, as an array
+static_assert(host::FS_BYTES == 0x40000, "keep the .fill size in step with FS_BYTES");
+
+#endif // HOST_SIM_H
@@ -0,0 +1,81 @@
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+// Host shim: alarms and repeating timers on the host timeline, delivered on
+// core 0 like the default alarm pool.
+
+#include <Arduino.h>
+
+typedef int32_t alarm_id_t;
+typedef uint64_t absolute_time_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+struct repeating_timer;
+typedef bool (*repeating_timer_callback_t)(struct repeating_timer *rt);
+struct repeating_timer {
+  int64_t delay_us;
+  alarm_id_t alarm_id;
+  repeating_timer_callback_t callback;
+  void *user_data;
+};
+
+namespace host {
+inline int32_t next_alarm_id = 1;
+
+inline void alarm_at(alarm_id_t id, uint64_t t, alarm_callback_t cb, void *user) {
+  at_ns(t, [id, t, cb, user] {
+    int64_t r = 0;
+    irq(0, [&] { r = cb(id, user); });
+    if (r < 0) alarm_at(id, t + (uint64_t)(-r) * 1000, cb, user);        // from the due time
+    else if (r > 0) alarm_at(id, now_ns + (uint64_t)r * 1000, cb, user);  // from now
+  }, id);
+}
+
+inline void repeat_at(struct repeating_timer *rt, uint64_t t) {
+  alarm_id_t id = rt->alarm_id;
+  at_ns(t, [rt, id, t] {
+    bool again = false;
+    irq(0, [&] { again = rt->callback(rt); });
+    if (!again || rt->alarm_id != id || timeline_ids.count(id)) return;   // cancelled or re-added inside the callback
+    uint64_t d = (uint64_t)(rt->delay_us < 0 ? -rt->delay_us : rt->delay_us) * 1000;
+    repeat_at(rt, rt->delay_us < 0 ? t + d : now_ns + d);
+  }, id);
+}
+}  // namespace host
+
+inline absolute_time_t get_absolute_time() { return time_us_64(); }
+inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + (uint64_t)ms * 1000; }
+inline bool best_effort_wfe_or_timeout(absolute_time_t t) { return host::wfe_until(t * 1000); }
+inline void sleep_us(uint64_t us) { host::busy_ns(us * 1000); }
+inline void sleep_ms(uint32_t ms) { host::busy_ns((uint64_t)ms * 1000000); }
+
+inline alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t cb, void *user, bool) {
+  alarm_id_t id = host::next_alarm_id++;
+  host::alarm_at(id, host::now_ns + us * 1000, cb, user);
+  return id;
+}
+inline alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t cb, void *user, bool fire_if_past) {
+  return add_alarm_in_us((uint64_t)ms * 1000, cb, user, fire_if_past);
+}
+inline bool cancel_alarm(alarm_id_t id) { return host::cancel_id(id); }
+
+inline bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t cb, void *user, struct repeating_timer *out) {
+  out->delay_us = delay_us;
+  out->callback = cb;
+  out->user_data = user;
+  out->alarm_id = host::next_alarm_id++;
+  host::repeat_at(out, host::now_ns + (uint64_t)(delay_us < 0 ? -delay_us : delay_us) * 1000);
+  return true;
+}
+inline bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t cb, void *user, struct repeating_timer *out) {
+  return add_repeating_timer_us((int64_t)delay_ms * 1000, cb, user, out);
+}
+inline bool cancel_repeating_timer(struct repeating_timer *t) {
+  bool ok = host::cancel_id(t->alarm_id);
+  t->alarm_id = 0;
+  return ok;
+}
+
+#endif // HOST_PICO_TIME_H